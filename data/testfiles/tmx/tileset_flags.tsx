@@ -0,0 +1,16 @@
+<?xml version="1.0" encoding="UTF-8"?>
+<tileset version="1.10" tiledversion="1.11.2" name="tileset_flags" tilewidth="16" tileheight="16" tilecount="4" columns="4">
+ <image source="../images/tilesets/tileset1.png" width="64" height="16"/>
+ <tile id="1">
+  <properties>
+   <property name="solid" type="bool" value="true"/>
+  </properties>
+ </tile>
+ <tile id="2" type="ladder"/>
+ <tile id="3">
+  <properties>
+   <property name="hazard" type="int" value="5"/>
+   <property name="solid" type="bool" value="false"/>
+  </properties>
+ </tile>
+</tileset>
@@ -8,11 +8,17 @@
 //	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
 //	CREATED:			25-SEP-2019 Adrian Purser <ade&arcadestuff.com>
 //=============================================================================
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <iostream>
+#include <thread>
 #include <utility>
 #include <format>
 #include "assets.h"
+#include "image_palette.h"
 #include "utility/format.h"
+#include "logger.h"
 
 namespace gap::assets
 {
@@ -22,12 +28,95 @@ int
 Assets::add_source_image(std::unique_ptr<gap::image::SourceImage> p_image)
 {
 	int index = m_source_images.size();
-	m_source_images.push_back(std::move(p_image));
+	const uint8_t pixelformat = p_image->target_pixelformat();
+	m_source_images.push_back({std::move(p_image), pixelformat});
 	return index;
 }
 
+static
+std::string
+source_image_key(const std::string & path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+int
+Assets::add_source_image(std::unique_ptr<gap::image::SourceImage> p_image, const std::string & path, uint64_t hash)
+{
+	const uint8_t pixelformat = p_image->source_pixelformat();
+	const int index = add_source_image(std::move(p_image));
+	m_loaded_images[source_image_key(path)] = LoadedImage {.hash = hash, .pixelformat = pixelformat, .views = {index}};
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+//	Find a source image that has already been loaded from 'path'. If the file
+//	has not changed, the view with the requested target pixel format is
+//	returned, adding one that shares the decoded pixels if there is none.
+//	Returns -1 if the image has to be loaded.
+//-----------------------------------------------------------------------------
+int
+Assets::find_source_image(const std::string & path, uint64_t hash, uint8_t target_pixelformat)
+{
+	auto it = m_loaded_images.find(source_image_key(path));
+	if((it == m_loaded_images.end()) || (it->second.hash != hash))
+		return -1;
+
+	auto & loaded = it->second;
+	if(target_pixelformat == 0)
+		target_pixelformat = loaded.pixelformat;
+
+	for(auto index : loaded.views)
+		if(m_source_images[index].target_pixelformat == target_pixelformat)
+			return index;
+
+	const int index = m_source_images.size();
+	m_source_images.push_back({m_source_images[loaded.views.front()].p_image, target_pixelformat});
+	loaded.views.push_back(index);
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+//	Free the pixels of a source image. They are only freed once every view
+//	that shares them has been released. A released image can not be found by
+//	find_source_image() any more.
+//-----------------------------------------------------------------------------
+void
+Assets::release_source_image(int index)
+{
+	if((index < 0) || std::cmp_greater_equal(index, m_source_images.size()) || (m_source_images[index].p_image == nullptr))
+		return;
+
+	m_source_images[index].p_image.reset();
+
+	std::erase_if(m_loaded_images, [index](const auto & entry) {return std::ranges::find(entry.second.views, index) != entry.second.views.end();});
+}
+
+// The number of images and tiles that are cut from each source image.
+std::vector<int>
+Assets::source_image_consumers() const
+{
+	std::vector<int> consumers(m_source_images.size(), 0);
+
+	auto add = [&](int index)
+	{
+		if((index >= 0) && std::cmp_less(index, consumers.size()))
+			++consumers[index];
+	};
+
+	for(const auto & group : m_image_groups)
+		for(const auto & image : group.images)
+			add(image.source_image);
+
+	for(const auto & tileset : m_tilesets)
+		for(const auto & tile : tileset.tiles)
+			add(tile.source_image);
+
+	return consumers;
+}
+
 int
-Assets::add_image_group( std::string_view name, int base)
+Assets::add_image_group( std::string_view name, int base, int palette_size)
 {
 	if(image_group_exists(name))
 		return -1;
@@ -35,7 +124,7 @@ Assets::add_image_group( std::string_view name, int base)
 	int index = m_image_groups.size();
 
 //	m_image_groups.emplace_back(name,base);
-	m_image_groups.emplace_back( ImageGroup {.name=std::string(name), .base = static_cast<uint16_t>(base), .images = {}} );
+	m_image_groups.emplace_back( ImageGroup {.name=std::string(name), .base = static_cast<uint16_t>(base), .palette_size = palette_size, .images = {}} );
 
 	return index;
 }
@@ -244,8 +333,14 @@ Assets::dump()
 	std::cout << "-----------------------------------------------------------------------------\n";
 	int index = 0;
 
-	for(const auto & p_image : m_source_images)
+	for(const auto & [p_image, target_pixelformat] : m_source_images)
 	{
+		if(p_image == nullptr)
+		{
+			std::cout << index++ << ": released\n";
+			continue;
+		}
+
 		auto str = std::to_string(index) + ':';
 		str.resize(5,' ');
 		str += std::to_string(p_image->width()) + 'x' + std::to_string(p_image->height());
@@ -253,7 +348,7 @@ Assets::dump()
 		str += gap::image::get_pixelformat_name(p_image->source_pixelformat());
 		str.resize(24,' ');
 		str += "-> ";
-		str += gap::image::get_pixelformat_name(p_image->target_pixelformat());
+		str += gap::image::get_pixelformat_name(target_pixelformat);
 
 		std::cout << str << '\n';
 		++index;
@@ -337,8 +432,11 @@ Assets::enumerate_source_images(std::function<bool (int image_index,const gap::i
 {
 	int index = 0;
 	for(const auto & image : m_source_images)
-		if(!callback(index++,*(image.get())))
+	{
+		if((image.p_image != nullptr) && !callback(index,*image.p_image))
 			break;
+		++index;
+	}
 }
 
 void
@@ -421,6 +519,15 @@ Assets::enumerate_tilemaps(std::function<bool(const gap::tilemap::TileMap & tile
 				break;
 }
 
+void
+Assets::enumerate_sound_samples(std::function<bool(const gap::sound::SoundSample & sample)> callback) const
+{
+	for(auto & p_sample : m_sound_samples)
+		if(p_sample != nullptr)
+			if(!callback(*p_sample.get()))
+				break;
+}
+
 void
 Assets::enumerate_files(std::function<bool(const gap::assets::FileInfo & fileinfo)> callback) const
 {
@@ -432,19 +539,19 @@ Assets::enumerate_files(std::function<bool(const gap::assets::FileInfo & fileinf
 std::uint32_t
 Assets::get_target_image_offset(int index, int x,int y) const
 {
-	if((index<0) || ( std::cmp_greater_equal(index,m_source_images.size())))
+	if((index<0) || ( std::cmp_greater_equal(index,m_source_images.size())) || (m_source_images[index].p_image == nullptr))
 		return 0;
 
-	return gap::image::pixelformat::image_pixel_offset(m_source_images[index]->target_pixelformat(),x,y,m_source_images[index]->width());
+	return gap::image::pixelformat::image_pixel_offset(m_source_images[index].target_pixelformat,x,y,m_source_images[index].p_image->width());
 }
 
 std::uint32_t
 Assets::get_target_line_stride(int index) const
 {
-	if((index<0) || (std::cmp_greater_equal(index,m_source_images.size())))
+	if((index<0) || (std::cmp_greater_equal(index,m_source_images.size())) || (m_source_images[index].p_image == nullptr))
 		return 0;
 
-	return m_source_images[index]->width();
+	return m_source_images[index].p_image->width();
 }
 
 std::uint8_t
@@ -453,39 +560,39 @@ Assets::get_target_pixelformat(int index) const
 	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size())))
 		return 0;
 
-	return m_source_images[index]->target_pixelformat();
+	return m_source_images[index].target_pixelformat;
 }
 
 
 std::vector<uint8_t>
 Assets::get_target_subimage(int index, int x, int y, int width, int height, uint8_t pixel_format, bool big_endian) const
 {
-	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ))
+	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ) || (m_source_images[index].p_image == nullptr))
 	{
-		std::cerr << "get_target_subimage: Unknown Image: " << index << std::endl;
+		gap::logger::error("get_target_subimage: Unknown Image: {}", index);
  		return {};
 	}
 
-	return m_source_images[index]->create_sub_target_data(x, y, width, height, pixel_format, big_endian);
+	return m_source_images[index].p_image->create_sub_target_data(x, y, width, height, pixel_format, big_endian);
 
 }
 
 int
 Assets::source_image_width(int index) const
 {
-	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ))
+	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ) || (m_source_images[index].p_image == nullptr))
 		return 0;
 
-	return m_source_images[index]->width();
+	return m_source_images[index].p_image->width();
 }
 
 int
 Assets::source_image_height(int index) const
 {
-	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ))
+	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ) || (m_source_images[index].p_image == nullptr))
 		return 0;
 
-	return m_source_images[index]->height();
+	return m_source_images[index].p_image->height();
 }
 
 
@@ -493,13 +600,13 @@ Assets::source_image_height(int index) const
 std::unique_ptr<gap::image::SourceImage>
 Assets::get_source_subimage(int index, int x, int y, int width, int height) const
 {
-	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ))
+	if((index<0) || ( std::cmp_greater_equal(index, m_source_images.size()) ) || (m_source_images[index].p_image == nullptr))
 	{
-		std::cerr << "get_source_subimage: Unknown Image: " << index << std::endl;
+		gap::logger::error("get_source_subimage: Unknown Image: {}", index);
  		return nullptr;
 	}
 
-	return m_source_images[index]->duplicate_subimage(x, y, width, height);
+	return m_source_images[index].p_image->duplicate_subimage(x, y, width, height);
 }
 
 int
@@ -533,6 +640,182 @@ Assets::add_colour_map(const ColourMap & cmap)
 
 }
 
+//-----------------------------------------------------------------------------
+//	Build a colour map for each image group and tileset whose indexed images
+//	do not have one. A group gets one palette for its I8 images and another
+//	for its I4 images. The colour histograms of the source regions are
+//	collected in parallel.
+//
+//	Palettes that hold every colour of their images are merged with any
+//	earlier palette while the combined colours still fit, so that groups cut
+//	from the same artwork share a colour map. Palettes that had to be reduced
+//	are not shared.
+//-----------------------------------------------------------------------------
+int
+Assets::build_palettes()
+{
+	struct Region
+	{
+		int											source	= 0;
+		gap::image::Rect				rect;
+	};
+
+	struct PaletteSet
+	{
+		std::string										name;
+		int														max_colours		= 256;
+		std::vector<gap::image::Image *>	images;
+		gap::tileset::TileSet *				p_tileset			= nullptr;
+		std::vector<Region>						regions;
+		gap::image::ColourHistogram		histogram;
+	};
+
+	std::vector<PaletteSet> sets;
+
+	for(auto & group : m_image_groups)
+		for(const uint8_t pixel_format : {uint8_t(gap::image::pixelformat::I8), uint8_t(gap::image::pixelformat::I4)})
+		{
+			PaletteSet set;
+			set.name				= std::format("{}:{}", group.name, gap::image::get_pixelformat_name(pixel_format));
+			set.max_colours	= std::min(group.palette_size, gap::image::pixelformat::palette_limit(pixel_format));
+
+			for(auto & image : group.images)
+				if((image.pixel_format == pixel_format) && (image.colour_map < 0))
+				{
+					set.images.push_back(&image);
+					set.regions.push_back({image.source_image, {image.x, image.y, image.width, image.height}});
+				}
+
+			if(!set.images.empty())
+				sets.push_back(std::move(set));
+		}
+
+	for(auto & tileset : m_tilesets)
+		if(gap::image::pixelformat::is_indexed(tileset.pixel_format) && (tileset.colour_map < 0))
+		{
+			PaletteSet set;
+			set.name				= std::format("tileset:{}", tileset.name.empty() ? std::to_string(tileset.id) : tileset.name);
+			set.max_colours	= std::min(tileset.palette_size, gap::image::pixelformat::palette_limit(tileset.pixel_format));
+			set.p_tileset		= &tileset;
+
+			for(const auto & tile : tileset.tiles)
+				set.regions.push_back({tile.source_image, {int(tile.x), int(tile.y), tileset.tile_width, tileset.tile_height}});
+
+			sets.push_back(std::move(set));
+		}
+
+	if(sets.empty())
+		return 0;
+
+	//---------------------------------------------------------------------------
+	//	Histograms. Each region is counted by a worker thread and then merged
+	//	into its set.
+	//---------------------------------------------------------------------------
+	std::vector<std::pair<std::size_t,const Region *>> regions;
+	for(std::size_t i=0; i<sets.size(); ++i)
+		for(const auto & region : sets[i].regions)
+		{
+			if((region.source < 0) || std::cmp_greater_equal(region.source, m_source_images.size()) || (m_source_images[region.source].p_image == nullptr))
+				return set_error(std::format("Palette '{}' refers to an unknown source image {}", sets[i].name, region.source));
+			regions.push_back({i, &region});
+		}
+
+	std::vector<gap::image::ColourHistogram> histograms(regions.size());
+	std::atomic<std::size_t> next = 0;
+
+	auto worker = [&]
+	{
+		for(std::size_t i = next++; i < regions.size(); i = next++)
+		{
+			const auto & rect = regions[i].second->rect;
+			histograms[i].add(*m_source_images[regions[i].second->source].p_image, rect.x, rect.y, rect.width, rect.height);
+		}
+	};
+
+	const std::size_t thread_count = std::min<std::size_t>(regions.size(), std::max(1U, std::thread::hardware_concurrency()));
+	{
+		std::vector<std::jthread> threads;
+		for(std::size_t i=1; i<thread_count; ++i)
+			threads.emplace_back(worker);
+		worker();
+	}
+
+	for(std::size_t i=0; i<regions.size(); ++i)
+		sets[regions[i].first].histogram.merge(histograms[i]);
+
+	//---------------------------------------------------------------------------
+	//	Share palettes where the colours fit.
+	//---------------------------------------------------------------------------
+	struct SharedPalette
+	{
+		std::string										name;
+		int														max_colours		= 256;
+		bool													b_exact				= true;
+		gap::image::ColourHistogram		histogram;
+		std::vector<std::size_t>			sets;
+	};
+
+	std::vector<SharedPalette> palettes;
+
+	for(std::size_t i=0; i<sets.size(); ++i)
+	{
+		const auto & set = sets[i];
+		const bool b_exact = std::cmp_less_equal(set.histogram.size(), set.max_colours);
+
+		auto it = palettes.end();
+		if(b_exact)
+			it = std::find_if(begin(palettes), end(palettes), [&](const SharedPalette & palette)
+				{
+					if(!palette.b_exact)
+						return false;
+
+					std::size_t size = palette.histogram.size();
+					for(const auto & [colour, count] : set.histogram.counts())
+						size += palette.histogram.contains(colour) ? 0 : 1;
+					return std::cmp_less_equal(size, std::min(palette.max_colours, set.max_colours));
+				});
+
+		if(it == palettes.end())
+		{
+			palettes.push_back({set.name, set.max_colours, b_exact, {}, {}});
+			it = std::prev(palettes.end());
+		}
+
+		it->max_colours = std::min(it->max_colours, set.max_colours);
+		it->histogram.merge(set.histogram);
+		it->sets.push_back(i);
+	}
+
+	//---------------------------------------------------------------------------
+	//	Colour maps
+	//---------------------------------------------------------------------------
+	for(const auto & palette : palettes)
+	{
+		ColourMap cmap;
+		cmap.source			= "auto";
+		cmap.name				= palette.name;
+		cmap.colourmap	= gap::image::build_palette(palette.histogram, palette.max_colours);
+
+		for(int suffix = 1; find_colour_map(cmap.name) >= 0; ++suffix)
+			cmap.name = std::format("{}:{}", palette.name, suffix);
+
+		const int index = add_colour_map(cmap);
+
+		gap::logger::verbose(	"PALETTE: {} - {} colours from {} source colours{}, shared by {}",
+													cmap.name, cmap.colourmap.size(), palette.histogram.size(), palette.b_exact ? "" : " (reduced)", palette.sets.size() );
+
+		for(auto i : palette.sets)
+		{
+			for(auto p_image : sets[i].images)
+				p_image->colour_map = index;
+			if(sets[i].p_tileset != nullptr)
+				sets[i].p_tileset->colour_map = index;
+		}
+	}
+
+	return 0;
+}
+
 
 } // namespace gap::assets
 
@@ -11,6 +11,9 @@
 #ifndef GUARD_ADE_GAMES_ASSET_PACKER_ASSETS_H
 #define GUARD_ADE_GAMES_ASSET_PACKER_ASSETS_H
 
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include "image.h"
 #include "tileset.h"
@@ -49,6 +52,18 @@ struct ImageFrame
 };
 
 
+//-----------------------------------------------------------------------------
+//	When enabled, images are trimmed to their opaque bounds and packed into
+//	pages of page_width x page_height pixels instead of being stored as
+//	separate rectangles.
+//-----------------------------------------------------------------------------
+struct AtlasSettings
+{
+	bool											b_enabled		= false;
+	int												page_width	= 1024;
+	int												page_height	= 1024;
+};
+
 struct ImageSequence
 {
 	enum {MODE_ONCE, MODE_LOOP, MODE_BOUNCE};
@@ -68,12 +83,30 @@ private:
 		std::string												name;
 	//	int																current_index = 0;
 		uint16_t													base = 0;
+		int																palette_size = 256;			// Maximum colours of a generated colour map.
 		std::vector<gap::image::Image>		images;
 
 //		ImageGroup( std::string_view _name, uint16_t _base = 0) : name(_name), base(_base) {}
 	};
 
-	std::vector<std::unique_ptr<gap::image::SourceImage>>		m_source_images;
+	// Source images are shared by views that only differ in the target pixel
+	// format. Images loaded from a file are found by path and content hash so
+	// that each file is decoded once.
+	struct SourceImageView
+	{
+		std::shared_ptr<gap::image::SourceImage>	p_image;
+		uint8_t																		target_pixelformat = 0;
+	};
+
+	struct LoadedImage
+	{
+		uint64_t																	hash					= 0;
+		uint8_t																		pixelformat		= 0;		// Target pixel format when no format is specified.
+		std::vector<int>													views;
+	};
+
+	std::vector<SourceImageView>														m_source_images;
+	std::unordered_map<std::string,LoadedImage>							m_loaded_images;
 	std::vector<ImageGroup>																	m_image_groups;
 	std::vector<gap::tileset::TileSet>											m_tilesets;
 	std::vector<FileInfo>																		m_files;
@@ -82,8 +115,10 @@ private:
 	std::vector<std::unique_ptr<gap::tilemap::TileMap>>			m_tilemaps;
 	std::vector<std::unique_ptr<gap::sound::SoundSample>>		m_sound_samples;
 	std::string 																						m_last_error;
+	AtlasSettings																						m_atlas;
 
 	int			m_most_recent_tileset = -1;
+	bool		m_b_release_source_images = false;		// Free each source image once the images and tiles cut from it are encoded.
 
 public:
 	Assets() = default;
@@ -91,16 +126,25 @@ public:
 	Assets & operator=(const Assets &) = delete;
 
 	int										add_source_image(std::unique_ptr<gap::image::SourceImage> p_image);
+	int										add_source_image(std::unique_ptr<gap::image::SourceImage> p_image, const std::string & path, uint64_t hash);
+	int										find_source_image(const std::string & path, uint64_t hash, uint8_t target_pixelformat = 0);
+	void									release_source_image(int index);
+	std::vector<int>			source_image_consumers() const;
+	void									set_release_source_images(bool b_release)			{m_b_release_source_images = b_release;}
+	bool									release_source_images() const noexcept				{return m_b_release_source_images;}
 	int										add_image(gap::image::Image & image);
 	int										add_image_sequence( std::string_view name, int mode );
 	int										add_image_frame( std::string_view group, std::string_view image, int time, int x=0, int y=0, int count=1);
-	int										add_image_group( std::string_view name, int base = 0 );
+	int										add_image_group( std::string_view name, int base = 0, int palette_size = 256 );
 	int										add_file(FileInfo && file);
 	void									add_tileset(const gap::tileset::TileSet & tileset)	{m_tilesets.push_back(tileset); m_most_recent_tileset=tileset.id;}
 	void									add_tile(int tileset, const gap::tileset::Tile & tile);
 	void									add_tilemap(std::unique_ptr<gap::tilemap::TileMap> && p_tilemap);
 	void									add_sound_sample(std::unique_ptr<gap::sound::SoundSample> && p_sound_sample);
 
+	void									set_atlas_settings(const AtlasSettings & settings)	{m_atlas = settings;}
+	const AtlasSettings &	atlas_settings() const noexcept											{return m_atlas;}
+
 	bool 									image_group_exists(std::string_view name)	{return !(find_group(name) < 0);}
 
 	uint32_t 							tileset_width(int id)		{	if(auto p_tileset = get_tileset(id))	return p_tileset->tile_width; return 0; }
@@ -112,6 +156,7 @@ public:
 	int										file_count() const noexcept							{return m_files.size();}
 	int										colourmap_count() const noexcept				{return m_colour_maps.size();}
 	int										tilemap_count() const noexcept					{return m_tilemaps.size();}
+	int										sound_sample_count() const noexcept			{return m_sound_samples.size();}
 	
 	void									enumerate_source_images(std::function<bool (int image_index,const gap::image::SourceImage &)> callback) const;
 	void									enumerate_images(std::function<bool (int group,int image_index,const gap::image::Image &)> callback) const;
@@ -122,6 +167,7 @@ public:
 	void									enumerate_files(std::function<bool(const gap::assets::FileInfo & fileinfo)> callback) const;
 	void									enumerate_colourmaps(std::function<bool(const gap::assets::ColourMap &)> callback) const;
 	void 									enumerate_tilemaps(std::function<bool(const gap::tilemap::TileMap & tilemap)> callback) const;
+	void 									enumerate_sound_samples(std::function<bool(const gap::sound::SoundSample & sample)> callback) const;
 
 	void									dump();
 
@@ -138,6 +184,7 @@ public:
 	int										find_colour_map(const std::string & name );
 	const ColourMap *			get_colour_map(int index);
 	int										add_colour_map(const ColourMap & cmap);
+	int										build_palettes();
 
 	const std::string &		get_last_error() const noexcept		{return m_last_error;}
 
@@ -0,0 +1,191 @@
+//=============================================================================
+//	FILE:					atlas.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Packs image rectangles into texture atlas pages
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include "atlas.h"
+
+namespace gap::atlas
+{
+
+using gap::image::Rect;
+
+static
+bool
+contains(const Rect & outer, const Rect & inner)
+{
+	return 	(inner.x >= outer.x) && (inner.y >= outer.y) &&
+					((inner.x + inner.width) <= (outer.x + outer.width)) &&
+					((inner.y + inner.height) <= (outer.y + outer.height));
+}
+
+static
+bool
+intersects(const Rect & a, const Rect & b)
+{
+	return 	(a.x < (b.x + b.width)) && (b.x < (a.x + a.width)) &&
+					(a.y < (b.y + b.height)) && (b.y < (a.y + a.height));
+}
+
+MaxRectsPacker::MaxRectsPacker(int width, int height)
+	: m_width(width)
+	, m_height(height)
+{
+	m_free.push_back(Rect{0, 0, width, height});
+}
+
+std::optional<Rect>
+MaxRectsPacker::insert(int width, int height)
+{
+	if((width <= 0) || (height <= 0))
+		return std::nullopt;
+
+	const Rect * p_best		= nullptr;
+	int best_short				= std::numeric_limits<int>::max();
+	int best_long					= std::numeric_limits<int>::max();
+
+	for(const auto & free : m_free)
+	{
+		if((width > free.width) || (height > free.height))
+			continue;
+
+		const int leftover_x	= free.width - width;
+		const int leftover_y	= free.height - height;
+		const int short_side	= std::min(leftover_x, leftover_y);
+		const int long_side		= std::max(leftover_x, leftover_y);
+
+		if((short_side < best_short) || ((short_side == best_short) && (long_side < best_long)))
+		{
+			p_best			= &free;
+			best_short	= short_side;
+			best_long		= long_side;
+		}
+	}
+
+	if(p_best == nullptr)
+		return std::nullopt;
+
+	const Rect used{p_best->x, p_best->y, width, height};
+
+	split_free_rects(used);
+	prune_free_rects();
+
+	m_used_height = std::max(m_used_height, used.y + used.height);
+	return used;
+}
+
+//-----------------------------------------------------------------------------
+//	Replace every free rectangle that overlaps 'used' with the (up to four)
+//	maximal rectangles that remain around it.
+//-----------------------------------------------------------------------------
+void
+MaxRectsPacker::split_free_rects(const Rect & used)
+{
+	const std::size_t count = m_free.size();
+
+	for(std::size_t i=0; i<count; ++i)
+	{
+		const Rect free = m_free[i];
+		if(!intersects(free, used))
+			continue;
+
+		if(used.x > free.x)
+			m_free.push_back(Rect{free.x, free.y, used.x - free.x, free.height});
+		if((used.x + used.width) < (free.x + free.width))
+			m_free.push_back(Rect{used.x + used.width, free.y, (free.x + free.width) - (used.x + used.width), free.height});
+		if(used.y > free.y)
+			m_free.push_back(Rect{free.x, free.y, free.width, used.y - free.y});
+		if((used.y + used.height) < (free.y + free.height))
+			m_free.push_back(Rect{free.x, used.y + used.height, free.width, (free.y + free.height) - (used.y + used.height)});
+
+		m_free[i].width = 0;		// Mark for removal.
+	}
+}
+
+void
+MaxRectsPacker::prune_free_rects()
+{
+	std::erase_if(m_free, [](const Rect & r) {return r.width == 0;});
+
+	for(std::size_t i=0; i<m_free.size(); ++i)
+	{
+		for(std::size_t j=i+1; j<m_free.size();)
+		{
+			if(contains(m_free[i], m_free[j]))
+			{
+				m_free.erase(m_free.begin() + j);
+			}
+			else if(contains(m_free[j], m_free[i]))
+			{
+				m_free.erase(m_free.begin() + i);
+				j = i + 1;
+			}
+			else
+				++j;
+		}
+	}
+}
+
+Layout
+pack(std::span<const Rect> sizes, int page_width, int page_height)
+{
+	Layout layout;
+	layout.placements.resize(sizes.size());
+
+	// ----- Place the largest rectangles first. -----
+	std::vector<std::size_t> order(sizes.size());
+	std::iota(begin(order), end(order), std::size_t(0));
+	std::stable_sort(begin(order), end(order), [&](std::size_t a, std::size_t b)
+	{
+		const auto & ra = sizes[a];
+		const auto & rb = sizes[b];
+		const int long_a	= std::max(ra.width, ra.height);
+		const int long_b	= std::max(rb.width, rb.height);
+		if(long_a != long_b)
+			return long_a > long_b;
+		return std::min(ra.width, ra.height) > std::min(rb.width, rb.height);
+	});
+
+	std::vector<MaxRectsPacker> packers;
+
+	for(auto index : order)
+	{
+		const auto & size = sizes[index];
+		if(	(size.width <= 0) || (size.height <= 0) ||
+				(size.width > page_width) || (size.height > page_height) )
+			continue;
+
+		auto & placement = layout.placements[index];
+
+		for(std::size_t page = 0; page < packers.size(); ++page)
+		{
+			if(auto rect = packers[page].insert(size.width, size.height))
+			{
+				placement = Placement{int(page), rect->x, rect->y};
+				break;
+			}
+		}
+
+		if(placement.page < 0)
+		{
+			auto & packer = packers.emplace_back(page_width, page_height);
+			auto rect = packer.insert(size.width, size.height);
+			placement = Placement{int(packers.size()-1), rect->x, rect->y};
+		}
+	}
+
+	for(const auto & packer : packers)
+		layout.pages.push_back(Page{packer.width(), packer.used_height()});
+
+	return layout;
+}
+
+} // namespace gap::atlas
@@ -0,0 +1,74 @@
+//=============================================================================
+//	FILE:					atlas.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Packs image rectangles into texture atlas pages
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_ATLAS_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_ATLAS_H
+
+#include <optional>
+#include <span>
+#include <vector>
+#include "image.h"
+
+namespace gap::atlas
+{
+
+//-----------------------------------------------------------------------------
+//	MaxRects bin packer. Keeps a list of the maximal free rectangles of a page
+//	and places each new rectangle where it leaves the shortest leftover side
+//	(Best Short Side Fit).
+//-----------------------------------------------------------------------------
+class MaxRectsPacker
+{
+private:
+	std::vector<gap::image::Rect>		m_free;
+	int															m_width					= 0;
+	int															m_height				= 0;
+	int															m_used_height		= 0;
+
+public:
+	MaxRectsPacker(int width, int height);
+
+	int															width() const					{return m_width;}
+	int															height() const				{return m_height;}
+	int															used_height() const		{return m_used_height;}
+
+	std::optional<gap::image::Rect>	insert(int width, int height);
+
+private:
+	void														split_free_rects(const gap::image::Rect & used);
+	void														prune_free_rects();
+};
+
+struct Page
+{
+	int															width		= 0;
+	int															height	= 0;				// Height actually used by the placed rectangles.
+};
+
+struct Placement
+{
+	int															page		= -1;				// -1 if the rectangle is empty or larger than a page.
+	int															x				= 0;
+	int															y				= 0;
+};
+
+struct Layout
+{
+	std::vector<Page>								pages;
+	std::vector<Placement>					placements;		// One per input size, in input order.
+};
+
+// Packs rectangles of the given sizes (only the width and height are used)
+// into as few pages of page_width x page_height as it can.
+Layout		pack(std::span<const gap::image::Rect> sizes, int page_width, int page_height);
+
+} // namespace gap::atlas
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_ATLAS_H
@@ -0,0 +1,101 @@
+//=============================================================================
+//	FILE:					bench.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Benchmark runner
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <numeric>
+#include <print>
+#include <utility>
+#include "bench.h"
+
+namespace gap::bench
+{
+
+static volatile std::size_t sg_sink = 0;
+
+void
+sink(std::size_t value)
+{
+	sg_sink = sg_sink + value;
+}
+
+std::string
+temp_filename(std::string_view name)
+{
+	const auto dir = std::filesystem::temp_directory_path() / "gap_bench";
+	std::filesystem::create_directories(dir);
+	return (dir / name).string();
+}
+
+bool
+Runner::enabled(std::string_view name) const
+{
+	if(m_filters.empty())
+		return true;
+
+	return std::any_of(begin(m_filters), end(m_filters), [&](const std::string & filter) {return name.find(filter) != std::string_view::npos;});
+}
+
+void
+Runner::print_header() const
+{
+	std::println("{:<48} {:>6} {:>12} {:>12} {:>12} {:>10}", "benchmark", "iters", "min(ms)", "median(ms)", "mean(ms)", "MB/s");
+	std::println("{:-<48} {:->6} {:->12} {:->12} {:->12} {:->10}", "", "", "", "", "", "");
+}
+
+void
+Runner::run(std::string_view name, std::size_t bytes, const std::function<void()> & body)
+{
+	run(name, bytes, []{}, body);
+}
+
+void
+Runner::run(std::string_view name, std::size_t bytes, const std::function<void()> & setup, const std::function<void()> & body)
+{
+	if(!enabled(name))
+		return;
+
+	using clock = std::chrono::steady_clock;
+
+	// ----- Warm up -----
+	setup();
+	body();
+
+	std::vector<double> times;
+	double total = 0.0;
+
+	while(	(std::cmp_less(times.size(), m_min_iterations) || (total < m_min_time_ms)) &&
+					std::cmp_less(times.size(), m_max_iterations) )
+	{
+		setup();
+		const auto start = clock::now();
+		body();
+		const auto end = clock::now();
+
+		const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+		times.push_back(ms);
+		total += ms;
+	}
+
+	std::sort(begin(times), end(times));
+	const double min 		= times.front();
+	const double median = times[times.size()/2];
+	const double mean 	= total / (double)times.size();
+
+	if(bytes > 0)
+		std::println("{:<48} {:>6} {:>12.3f} {:>12.3f} {:>12.3f} {:>10.1f}", name, times.size(), min, median, mean, ((double)bytes / (1024.0 * 1024.0)) / (median / 1000.0));
+	else
+		std::println("{:<48} {:>6} {:>12.3f} {:>12.3f} {:>12.3f} {:>10}", name, times.size(), min, median, mean, "-");
+
+	++m_run_count;
+}
+
+} // namespace gap::bench
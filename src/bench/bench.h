@@ -0,0 +1,64 @@
+//=============================================================================
+//	FILE:					bench.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Benchmark runner
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_BENCH_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_BENCH_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace gap::bench
+{
+
+// Prevent the optimiser from discarding the result of a benchmark body.
+void					sink(std::size_t value);
+
+// Path of a scratch file in the benchmark's temporary directory.
+std::string		temp_filename(std::string_view name);
+
+class Runner
+{
+private:
+	std::vector<std::string>	m_filters;
+	double										m_min_time_ms			= 500.0;
+	int												m_min_iterations	= 3;
+	int												m_max_iterations	= 1000;
+	int												m_run_count				= 0;
+
+public:
+	Runner() = default;
+	Runner(const Runner &) = delete;
+	Runner & operator=(const Runner &) = delete;
+
+	void				add_filter(std::string_view filter)		{m_filters.emplace_back(filter);}
+	void				set_quick(bool b_quick)								{m_min_time_ms = b_quick ? 50.0 : 500.0; m_min_iterations = b_quick ? 1 : 3;}
+	bool				enabled(std::string_view name) const;
+	int					run_count() const											{return m_run_count;}
+
+	void				print_header() const;
+
+	// Run 'body' repeatedly and print its timings. 'setup' is called before
+	// each iteration and is not timed. 'bytes' is the amount of data processed
+	// per iteration and is used to calculate the throughput (0 = not shown).
+	void				run(std::string_view name, std::size_t bytes, const std::function<void()> & body);
+	void				run(std::string_view name, std::size_t bytes, const std::function<void()> & setup, const std::function<void()> & body);
+};
+
+// ----- Benchmark groups. Each registers its cases with the runner. -----
+void		run_parse_benchmarks(Runner & runner);
+void		run_image_benchmarks(Runner & runner);
+void		run_encode_benchmarks(Runner & runner);
+
+} // namespace gap::bench
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_BENCH_H
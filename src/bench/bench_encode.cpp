@@ -0,0 +1,223 @@
+//=============================================================================
+//	FILE:					bench_encode.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	GBIN chunk encoding and export benchmarks
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <filesystem>
+#include <format>
+#include "bench.h"
+#include "workloads.h"
+#include "assets.h"
+#include "configuration.h"
+#include "encode_gbin.h"
+#include "export.h"
+#include "tilemap.h"
+
+namespace gap::bench
+{
+
+static constexpr int				ATLAS_COUNT			= 4;
+static constexpr int				ATLAS_SIZE			= 2048;
+static constexpr int				TILE_COUNT			= 100000;
+static constexpr uint32_t		TILEMAP_SIZE		= 4096;
+static constexpr uint32_t		BLOCK_SIZE			= 16;
+static constexpr int				FILE_COUNT			= 4;
+static constexpr std::size_t	FILE_SIZE			= 4 * 1024 * 1024;
+
+static
+std::size_t
+source_image_bytes(const gap::assets::Assets & assets)
+{
+	std::size_t bytes = 0;
+	for(int i=0; i<assets.source_image_count(); ++i)
+		bytes += std::size_t(assets.source_image_width(i)) * assets.source_image_height(i) * sizeof(uint32_t);
+	return bytes;
+}
+
+void
+run_encode_benchmarks(Runner & runner)
+{
+	gap::Configuration config;
+
+	//---------------------------------------------------------------------------
+	//	IMAGES AND TILES
+	//---------------------------------------------------------------------------
+	if(runner.enabled("encode/images"))
+	{
+		gap::assets::Assets assets;
+		add_atlas_images(assets, ATLAS_COUNT, ATLAS_SIZE, 1);
+		add_tileset(assets, TILE_COUNT);
+
+		runner.run(std::format("encode/images/{}x{}x{}+{}tiles", ATLAS_COUNT, ATLAS_SIZE, ATLAS_SIZE, TILE_COUNT), source_image_bytes(assets), [&]
+		{
+			std::vector<uint8_t> data;
+			gap::encode_packed_image_chunks(data, assets, config);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	ATLAS - The same images trimmed and packed into atlas pages.
+	//---------------------------------------------------------------------------
+	if(runner.enabled("encode/atlas"))
+	{
+		gap::assets::Assets assets;
+		add_atlas_images(assets, ATLAS_COUNT, ATLAS_SIZE, 1);
+
+		gap::assets::AtlasSettings settings;
+		settings.b_enabled = true;
+		assets.set_atlas_settings(settings);
+
+		runner.run(std::format("encode/atlas/{}x{}x{}", ATLAS_COUNT, ATLAS_SIZE, ATLAS_SIZE), source_image_bytes(assets), [&]
+		{
+			std::vector<uint8_t> data;
+			gap::encode_packed_image_chunks(data, assets, config);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	TILEMAP
+	//---------------------------------------------------------------------------
+	if(runner.enabled("encode/tilemap"))
+	{
+		gap::assets::Assets assets;
+		assets.add_tilemap(make_tilemap(TILEMAP_SIZE, TILEMAP_SIZE, BLOCK_SIZE, 2));
+
+		runner.run(std::format("encode/tilemap/{}x{}/blk{}", TILEMAP_SIZE, TILEMAP_SIZE, BLOCK_SIZE), std::size_t(TILEMAP_SIZE) * TILEMAP_SIZE * sizeof(uint16_t), [&]
+		{
+			std::vector<uint8_t> data;
+			gap::encode_tilemap_chunks(data, assets, config);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	TILEMAP LOCALITY - A camera sweeps diagonally across the map, in both
+	//	directions, reading every tile in view each frame from the stored
+	//	blocks, as a renderer would.
+	//---------------------------------------------------------------------------
+	for(const auto & [layout, layout_name] : {	std::pair{gap::tilemap::LAYOUT_ROW_MAJOR, "rowmajor"},
+																							std::pair{gap::tilemap::LAYOUT_MORTON, "morton"},
+																							std::pair{gap::tilemap::LAYOUT_HILBERT, "hilbert"} })
+	{
+		static constexpr uint32_t VIEW_WIDTH	= 320;
+		static constexpr uint32_t VIEW_HEIGHT	= 180;
+		static constexpr uint32_t SPEED				= 8;
+		static constexpr uint32_t MAP_SIZE		= TILEMAP_SIZE / 2;		// Few enough blocks for each to have a block number.
+
+		const auto name = std::format("tilemap/locality/{}/{}x{}/blk{}", layout_name, MAP_SIZE, MAP_SIZE, BLOCK_SIZE);
+		if(!runner.enabled(name))
+			continue;
+
+		// ----- Every block is different so that none are shared. -----
+		std::vector<uint64_t> tiles(std::size_t(MAP_SIZE) * MAP_SIZE);
+		for(std::size_t i=0; i<tiles.size(); ++i)
+			tiles[i] = ((i * 0x9E3779B1U) >> 20) & 0x3FF;
+
+		gap::tilemap::TileMap tilemap(1, "bench", MAP_SIZE, MAP_SIZE, BLOCK_SIZE, 2);
+		tilemap.set_layout(layout);
+		tilemap.assign_rect(tiles, MAP_SIZE, 0, 0, MAP_SIZE, MAP_SIZE);
+		tilemap.deduplicate_blocks();
+
+		// ----- The blocks as stored, and where each tile of a block is stored. -----
+		const auto order = gap::tilemap::layout_order(layout, BLOCK_SIZE, BLOCK_SIZE);
+		std::vector<uint32_t> cell(order.size());
+		for(std::size_t i=0; i<order.size(); ++i)
+			cell[order[i]] = uint32_t(i);
+
+		std::vector<uint16_t> blocks;
+		blocks.reserve(tilemap.block_data().size());
+		for(std::size_t block=0; block<tilemap.block_data().size(); block+=order.size())
+			for(auto position : order)
+				blocks.push_back(uint16_t(tilemap.block_data()[block + position]));
+
+		const auto indices = tilemap.indices();
+		auto tile = [&](uint32_t x, uint32_t y) -> uint32_t
+		{
+			const auto index = indices[((y / BLOCK_SIZE) * tilemap.blocks_wide()) + (x / BLOCK_SIZE)];
+			return index == gap::tilemap::INDEX_EMPTY ? 0 : blocks[(std::size_t(index) * order.size()) + cell[((y % BLOCK_SIZE) * BLOCK_SIZE) + (x % BLOCK_SIZE)]];
+		};
+
+		const uint32_t frames = (MAP_SIZE - std::max(VIEW_WIDTH, VIEW_HEIGHT)) / SPEED;
+
+		runner.run(name, std::size_t(frames) * 2 * VIEW_WIDTH * VIEW_HEIGHT * sizeof(uint16_t), [&]
+		{
+			uint32_t sum = 0;
+			for(uint32_t frame=0; frame<frames; ++frame)
+			{
+				// ----- Down and right, then down and left. -----
+				const uint32_t top = frame * SPEED;
+				for(const uint32_t left : {frame * SPEED, MAP_SIZE - VIEW_WIDTH - (frame * SPEED)})
+					for(uint32_t y=0; y<VIEW_HEIGHT; ++y)
+						for(uint32_t x=0; x<VIEW_WIDTH; ++x)
+							sum += tile(left + x, top + y);
+			}
+			sink(sum);
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	FILES
+	//---------------------------------------------------------------------------
+	if(runner.enabled("encode/files"))
+	{
+		gap::assets::Assets assets;
+		for(int i=0; i<FILE_COUNT; ++i)
+		{
+			gap::assets::FileInfo file;
+			file.name = std::format("file{}", i);
+			file.data = make_file_data(FILE_SIZE, 3 + i);
+			assets.add_file(std::move(file));
+		}
+
+		runner.run(std::format("encode/files/{}x{}MB", FILE_COUNT, FILE_SIZE / (1024 * 1024)), FILE_COUNT * FILE_SIZE, [&]
+		{
+			std::vector<uint8_t> data;
+			gap::encode_file_chunks(data, assets, config);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	EXPORT
+	//---------------------------------------------------------------------------
+	if(runner.enabled("export"))
+	{
+		gap::assets::Assets assets;
+		add_atlas_images(assets, 1, ATLAS_SIZE / 2, 4);
+		add_tileset(assets, TILE_COUNT / 10);
+		assets.add_tilemap(make_tilemap(TILEMAP_SIZE / 4, TILEMAP_SIZE / 4, BLOCK_SIZE, 5));
+
+		gap::assets::FileInfo file;
+		file.name = "file";
+		file.data = make_file_data(FILE_SIZE, 6);
+		assets.add_file(std::move(file));
+
+		gap::Configuration export_config;
+		export_config.output_prefix = temp_filename("");
+
+		for(const auto & [type, format, format_name, extension] : {	std::tuple{gap::exporter::TYPE_GBIN, gap::exporter::FORMAT_BINARY, "gbin/binary", "gbin"},
+																																	std::tuple{gap::exporter::TYPE_GBIN, gap::exporter::FORMAT_C_ARRAY, "gbin/c_array", "c"},
+																																	std::tuple{gap::exporter::TYPE_DEFINITIONS, gap::exporter::FORMAT_C_HEADER, "definitions/c_header", "h"} } )
+		{
+			gap::exporter::ExportInfo info;
+			info.filename	= std::format("bench_export.{}", extension);
+			info.name			= "bench";
+			info.type			= type;
+			info.format		= format;
+
+			runner.run(std::format("export/{}", format_name), 0, [&]
+			{
+				sink(gap::exporter::export_assets(assets, info, export_config));
+			});
+		}
+	}
+}
+
+} // namespace gap::bench
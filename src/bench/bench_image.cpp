@@ -0,0 +1,158 @@
+//=============================================================================
+//	FILE:					bench_image.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Image transform and pixel conversion benchmarks
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <format>
+#include <tuple>
+#include "bench.h"
+#include "workloads.h"
+#include "image.h"
+
+namespace gap::bench
+{
+
+static constexpr int 	ATLAS_SIZE = 2048;
+
+static
+void
+run_transform(Runner & runner, std::string_view name, const gap::image::SourceImage & source, const std::function<void(gap::image::SourceImage &)> & transform)
+{
+	const std::size_t bytes = std::size_t(source.width()) * source.height() * sizeof(uint32_t);
+	std::unique_ptr<gap::image::SourceImage> p_image;
+
+	// The transforms modify the image in place so each iteration starts with
+	// a fresh copy of the source. The copy is not timed.
+	runner.run(	name, bytes,
+							[&] {p_image = std::make_unique<gap::image::SourceImage>(source);},
+							[&] {transform(*p_image); sink(p_image->width());} );
+}
+
+void
+run_image_benchmarks(Runner & runner)
+{
+	const auto p_atlas 	= make_atlas(ATLAS_SIZE, ATLAS_SIZE, 1);
+	const auto p_sprite = p_atlas->duplicate_subimage(0, 0, SPRITE_SIZE, SPRITE_SIZE);
+	const auto p_medium	= p_atlas->duplicate_subimage(0, 0, 256, 256);
+
+	//---------------------------------------------------------------------------
+	//	TRANSFORMS
+	//---------------------------------------------------------------------------
+	const auto atlas_name = std::format("{}x{}", ATLAS_SIZE, ATLAS_SIZE);
+
+	run_transform(runner, std::format("transform/rotate_90/{}", atlas_name), 	*p_atlas, [](auto & image) {image.rotate_90();});
+	run_transform(runner, std::format("transform/rotate_180/{}", atlas_name), *p_atlas, [](auto & image) {image.rotate_180();});
+	run_transform(runner, std::format("transform/rotate_270/{}", atlas_name), *p_atlas, [](auto & image) {image.rotate_270();});
+	run_transform(runner, std::format("transform/hflip/{}", atlas_name), 			*p_atlas, [](auto & image) {image.horizontal_flip();});
+	run_transform(runner, std::format("transform/vflip/{}", atlas_name), 			*p_atlas, [](auto & image) {image.vertical_flip();});
+
+	for(const auto * p_image : {p_sprite.get(), p_medium.get()})
+	{
+		for(const float angle : {30.0f, 45.0f})
+		{
+			run_transform(runner, std::format("transform/rotate/{}x{}/{}deg", p_image->width(), p_image->height(), angle), *p_image,
+										[angle](auto & image)
+										{
+											int ox = image.width() / 2;
+											int oy = image.height() / 2;
+											image.rotate(angle, ox, oy);
+										});
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	//	ANGLE STEP - 32 rotations of one sprite, one at a time and as a batch.
+	//---------------------------------------------------------------------------
+	{
+		std::vector<float> angles;
+		for(int i=0; i<32; ++i)
+			angles.push_back(i * (360.0f / 32.0f));
+
+		const std::size_t bytes = std::size_t(SPRITE_SIZE) * SPRITE_SIZE * sizeof(uint32_t) * angles.size();
+
+		runner.run(std::format("transform/rotate/{}x{}/step32/single", SPRITE_SIZE, SPRITE_SIZE), bytes, [&]
+		{
+			for(const float angle : angles)
+			{
+				gap::image::SourceImage image(*p_sprite);
+				int ox = SPRITE_SIZE/2;
+				int oy = SPRITE_SIZE/2;
+				image.rotate(angle, ox, oy);
+				sink(image.width());
+			}
+		});
+
+		runner.run(std::format("transform/rotate/{}x{}/step32/batch", SPRITE_SIZE, SPRITE_SIZE), bytes, [&]
+		{
+			auto copies = p_sprite->rotated_copies(angles, SPRITE_SIZE/2, SPRITE_SIZE/2);
+			sink(copies.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	PIXEL FORMAT CONVERSION
+	//---------------------------------------------------------------------------
+	static constexpr int REGION = 1024;
+
+	for(const uint8_t pf : {	gap::image::pixelformat::ARGB8888,
+														gap::image::pixelformat::RGB888,
+														gap::image::pixelformat::RGB565,
+														gap::image::pixelformat::ARGB1555,
+														gap::image::pixelformat::ARGB4444,
+														gap::image::pixelformat::AL88,
+														gap::image::pixelformat::L8,
+														gap::image::pixelformat::AL44,
+														gap::image::pixelformat::A8,
+														gap::image::pixelformat::L4,
+														gap::image::pixelformat::A4 } )
+	{
+		runner.run(std::format("convert/{}/{}x{}", gap::image::get_pixelformat_name(pf), REGION, REGION), std::size_t(REGION) * REGION * sizeof(uint32_t), [&]
+		{
+			auto data = p_atlas->create_sub_target_data(ATLAS_SIZE/4, ATLAS_SIZE/4, REGION, REGION, pf, false);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	PREMULTIPLIED ALPHA AND DITHERING
+	//---------------------------------------------------------------------------
+	for(const auto & [pf, options, options_name] : {	std::tuple{gap::image::pixelformat::ARGB8888,	gap::image::EncodeOptions{true, gap::image::DITHER_NONE}, 			"premultiply"},
+																										std::tuple{gap::image::pixelformat::RGB565,		gap::image::EncodeOptions{false, gap::image::DITHER_ORDERED}, 	"ordered"},
+																										std::tuple{gap::image::pixelformat::RGB565,		gap::image::EncodeOptions{false, gap::image::DITHER_DIFFUSION}, "diffusion"},
+																										std::tuple{gap::image::pixelformat::ARGB4444,	gap::image::EncodeOptions{true, gap::image::DITHER_DIFFUSION}, 	"premultiply+diffusion"},
+																										std::tuple{gap::image::pixelformat::L4,				gap::image::EncodeOptions{false, gap::image::DITHER_ORDERED}, 	"ordered"},
+																										std::tuple{gap::image::pixelformat::L4,				gap::image::EncodeOptions{false, gap::image::DITHER_DIFFUSION}, "diffusion"} } )
+	{
+		runner.run(std::format("convert/{}/{}/{}x{}", gap::image::get_pixelformat_name(pf), options_name, REGION, REGION), std::size_t(REGION) * REGION * sizeof(uint32_t), [&]
+		{
+			auto data = p_atlas->create_sub_target_data(ATLAS_SIZE/4, ATLAS_SIZE/4, REGION, REGION, pf, false, options);
+			sink(data.size());
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	BLOCK COMPRESSION
+	//---------------------------------------------------------------------------
+	for(const uint8_t pf : {	gap::image::pixelformat::BC1,
+														gap::image::pixelformat::BC3,
+														gap::image::pixelformat::ETC2,
+														gap::image::pixelformat::ETC2_RGBA } )
+	{
+		for(const bool b_high_quality : {false, true})
+		{
+			const gap::image::EncodeOptions options{false, gap::image::DITHER_NONE, b_high_quality};
+			runner.run(std::format("convert/{}/{}/{}x{}", gap::image::get_pixelformat_name(pf), b_high_quality ? "hq" : "fast", REGION, REGION), std::size_t(REGION) * REGION * sizeof(uint32_t), [&]
+			{
+				auto data = p_atlas->create_sub_target_data(ATLAS_SIZE/4, ATLAS_SIZE/4, REGION, REGION, pf, false, options);
+				sink(data.size());
+			});
+		}
+	}
+}
+
+} // namespace gap::bench
@@ -0,0 +1,58 @@
+//=============================================================================
+//	FILE:					bench_main.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Benchmark entry point
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <print>
+#include <string_view>
+#include "bench.h"
+#include "logger.h"
+
+//-----------------------------------------------------------------------------
+//	Usage: gap_bench [--quick] [filter]...
+//
+//	Only benchmarks whose name contains one of the filters are run. If no
+//	filters are given then every benchmark is run.
+//-----------------------------------------------------------------------------
+int
+main(int argc, char ** argv)
+{
+	gap::bench::Runner runner;
+
+	// Keep the packer's own progress output out of the timings.
+	gap::logger::set_level(gap::logger::QUIET);
+
+	for(int i=1; i<argc; ++i)
+	{
+		const std::string_view arg(argv[i]);
+
+		if(arg == "--quick")
+			runner.set_quick(true);
+		else if((arg == "--help") || (arg == "-h"))
+		{
+			std::println("Usage: {} [--quick] [filter]...", argv[0]);
+			return 0;
+		}
+		else
+			runner.add_filter(arg);
+	}
+
+	runner.print_header();
+
+	gap::bench::run_parse_benchmarks(runner);
+	gap::bench::run_image_benchmarks(runner);
+	gap::bench::run_encode_benchmarks(runner);
+
+	if(runner.run_count() == 0)
+	{
+		std::println(stderr, "No benchmarks matched the filter.");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,106 @@
+//=============================================================================
+//	FILE:					bench_parse.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	GAP parsing, tilemap decoding and tilemap building benchmarks
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <format>
+#include <fstream>
+#include <utility>
+#include <vector>
+#include "bench.h"
+#include "workloads.h"
+#include "filesystem.h"
+#include "parse_gap.h"
+#include "source_tilemap.h"
+#include "tilemap.h"
+
+namespace gap::bench
+{
+
+void
+run_parse_benchmarks(Runner & runner)
+{
+	gap::FileSystem filesystem;
+
+	//---------------------------------------------------------------------------
+	//	GAP
+	//---------------------------------------------------------------------------
+	for(const auto & [groups, images] : {std::pair{16, 64}, std::pair{64, 256}})
+	{
+		const auto name = std::format("parse/gap/{}x{}", groups, images);
+		if(!runner.enabled(name))
+			continue;
+
+		const auto source = make_gap_source(groups, images);
+
+		runner.run(name, source.size(), [&]
+		{
+			gap::ParserGAP parser(filesystem);
+			auto p_assets = parser.parse(source);
+			sink(p_assets ? p_assets->image_group_count() : 0);
+		});
+	}
+
+	//---------------------------------------------------------------------------
+	//	TMX
+	//---------------------------------------------------------------------------
+	std::vector<std::pair<const char *, TMXEncoding>> encodings = {{"csv", TMXEncoding::CSV}, {"base64", TMXEncoding::BASE64}};
+#if defined(GAP_HAVE_ZLIB)
+	encodings.push_back({"zlib", TMXEncoding::BASE64_ZLIB});
+#endif
+
+	for(const auto & [p_encoding, encoding] : encodings)
+	{
+		for(const uint32_t size : {256U, 1024U})
+		{
+			const auto name = std::format("decode/tmx/{}/{}x{}", p_encoding, size, size);
+			if(!runner.enabled(name))
+				continue;
+
+			const auto source 	= make_tmx_source(size, size, 0xC0FFEE, encoding);
+			const auto filename	= temp_filename(std::format("bench_{}_{}.tmx", p_encoding, size));
+			std::ofstream(filename, std::ios_base::binary).write(source.data(), source.size());
+
+			runner.run(name, source.size(), [&]
+			{
+				auto p_tilemap = gap::tilemap::load(filename, "tiled:tmx", filesystem);
+				sink(p_tilemap ? p_tilemap->width() : 0);
+			});
+		}
+	}
+
+	//---------------------------------------------------------------------------
+	//	TILEMAP - Copying a layer into a TileMap a tile at a time and a
+	//	rectangle at a time.
+	//---------------------------------------------------------------------------
+	if(runner.enabled("build/tilemap"))
+	{
+		static constexpr uint32_t SIZE				= 4096;
+		static constexpr uint32_t BLOCK_SIZE	= 16;
+
+		const auto tiles = make_tile_layer(SIZE, SIZE, 7);
+
+		runner.run(std::format("build/tilemap/set/{}x{}/blk{}", SIZE, SIZE, BLOCK_SIZE), tiles.size() * sizeof(uint64_t), [&]
+		{
+			gap::tilemap::TileMap tilemap(1, "bench", SIZE, SIZE, BLOCK_SIZE, 1);
+			for(uint32_t y=0; y<SIZE; ++y)
+				for(uint32_t x=0; x<SIZE; ++x)
+					tilemap.set(x, y, tiles[(std::size_t(y) * SIZE) + x]);
+			sink(tilemap.active_block_count());
+		});
+
+		runner.run(std::format("build/tilemap/assign_rect/{}x{}/blk{}", SIZE, SIZE, BLOCK_SIZE), tiles.size() * sizeof(uint64_t), [&]
+		{
+			gap::tilemap::TileMap tilemap(1, "bench", SIZE, SIZE, BLOCK_SIZE, 1);
+			tilemap.assign_rect(tiles, SIZE, 0, 0, SIZE, SIZE);
+			sink(tilemap.active_block_count());
+		});
+	}
+}
+
+} // namespace gap::bench
@@ -0,0 +1,234 @@
+//=============================================================================
+//	FILE:					workloads.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Reproducible synthetic workloads for the benchmarks
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <format>
+#include "workloads.h"
+#include "utility/base64.h"
+
+#if defined(GAP_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace gap::bench
+{
+
+std::unique_ptr<gap::image::SourceImage>
+make_atlas(int width, int height, uint32_t seed)
+{
+	Random rng(seed);
+	std::vector<uint32_t> pixels(width * height, 0U);
+
+	for(int cy=0; (cy + SPRITE_SIZE) <= height; cy += SPRITE_SIZE)
+	{
+		for(int cx=0; (cx + SPRITE_SIZE) <= width; cx += SPRITE_SIZE)
+		{
+			const uint32_t 	colour 	= 0xFF000000U | (rng.next() & 0x0FFFFFFU);
+			const int 			radius	= 8 + rng.next(SPRITE_SIZE/2 - 8);
+			const int				r2			= radius * radius;
+			const int				mx			= cx + (SPRITE_SIZE/2);
+			const int				my			= cy + (SPRITE_SIZE/2);
+
+			for(int y=my-radius; y<my+radius; ++y)
+				for(int x=mx-radius; x<mx+radius; ++x)
+					if((((x-mx)*(x-mx)) + ((y-my)*(y-my))) <= r2)
+						pixels[(y * width) + x] = colour ^ ((x ^ y) & 0x0F);
+		}
+	}
+
+	auto p_image = std::make_unique<gap::image::SourceImage>(width, height, pixels.data());
+	p_image->set_source_pixelformat(gap::image::pixelformat::ARGB8888);
+	p_image->set_target_pixelformat(gap::image::pixelformat::ARGB8888);
+	return p_image;
+}
+
+std::vector<uint64_t>
+make_tile_layer(uint32_t width, uint32_t height, uint32_t seed)
+{
+	static constexpr uint32_t REGION = 16;
+
+	Random rng(seed);
+	std::vector<uint64_t> tiles(std::size_t(width) * height, 0U);
+
+	for(uint32_t ry=0; ry<height; ry += REGION)
+	{
+		for(uint32_t rx=0; rx<width; rx += REGION)
+		{
+			const uint32_t kind = rng.next(10);		// 0-2 = empty, 3-4 = uniform, 5-9 = noise
+			if(kind < 3)
+				continue;
+
+			const uint64_t fill = 1 + rng.next(255);
+			for(uint32_t y=ry; (y<ry+REGION) && (y<height); ++y)
+				for(uint32_t x=rx; (x<rx+REGION) && (x<width); ++x)
+					tiles[(std::size_t(y) * width) + x] = kind < 5 ? fill : rng.next(256);
+		}
+	}
+
+	return tiles;
+}
+
+std::unique_ptr<gap::tilemap::TileMap>
+make_tilemap(uint32_t width, uint32_t height, uint32_t blocksize, uint32_t seed)
+{
+	auto tiles = make_tile_layer(width, height, seed);
+	auto p_tilemap = std::make_unique<gap::tilemap::TileMap>(1, "bench", width, height, blocksize, 1);
+
+	for(uint32_t y=0; y<height; ++y)
+		for(uint32_t x=0; x<width; ++x)
+			if(auto tile = tiles[(std::size_t(y) * width) + x]; tile != 0)
+				p_tilemap->set(x, y, tile);
+
+	return p_tilemap;
+}
+
+std::vector<uint8_t>
+make_file_data(std::size_t size, uint32_t seed)
+{
+	Random rng(seed);
+	std::vector<uint8_t> data(size);
+	for(auto & byte : data)
+		byte = rng.next() & 0x0FF;
+	return data;
+}
+
+void
+add_atlas_images(gap::assets::Assets & assets, int atlas_count, int atlas_size, uint32_t seed)
+{
+	for(int iatlas=0; iatlas<atlas_count; ++iatlas)
+	{
+		const int source = assets.add_source_image(make_atlas(atlas_size, atlas_size, seed + iatlas));
+		assets.add_image_group(std::format("atlas{}", iatlas));
+
+		for(int y=0; (y + SPRITE_SIZE) <= atlas_size; y += SPRITE_SIZE)
+		{
+			for(int x=0; (x + SPRITE_SIZE) <= atlas_size; x += SPRITE_SIZE)
+			{
+				gap::image::Image image;
+				image.name					= std::format("a{}_{}_{}", iatlas, x, y);
+				image.source_image	= source;
+				image.x							= x;
+				image.y							= y;
+				image.width					= SPRITE_SIZE;
+				image.height				= SPRITE_SIZE;
+				image.x_origin			= SPRITE_SIZE/2;
+				image.y_origin			= SPRITE_SIZE/2;
+				image.pixel_format	= gap::image::pixelformat::ARGB8888;
+				assets.add_image(image);
+			}
+		}
+	}
+}
+
+void
+add_tileset(gap::assets::Assets & assets, int tile_count)
+{
+	const int width		= assets.source_image_width(0);
+	const int height	= assets.source_image_height(0);
+	const int across 	= width / TILE_SIZE;
+	const int down		= height / TILE_SIZE;
+
+	gap::tileset::TileSet tileset;
+	tileset.name					= "tiles";
+	tileset.id						= assets.generate_tileset_id();
+	tileset.tile_width		= TILE_SIZE;
+	tileset.tile_height		= TILE_SIZE;
+	tileset.pixel_format	= gap::image::pixelformat::RGB565;
+	assets.add_tileset(tileset);
+
+	for(int i=0; i<tile_count; ++i)
+	{
+		gap::tileset::Tile tile;
+		tile.x							= ((i % across) * TILE_SIZE);
+		tile.y							= (((i / across) % down) * TILE_SIZE);
+		tile.source_image		= 0;
+		tile.transform			= (i / (across * down)) & 0x0F;
+		assets.add_tile(tileset.id, tile);
+	}
+}
+
+std::string
+make_gap_source(int group_count, int images_per_group)
+{
+	std::string source("# Synthetic benchmark source\n");
+
+	for(int group=0; group<group_count; ++group)
+	{
+		source += std::format("imagegroup, name=\"group{}\"\n", group);
+		for(int image=0; image<images_per_group; ++image)
+			source += std::format("image, name=\"img{}_{}\", x={}, y={}, w=64, h=64, xo=32, yo=32, format=RGB565 # sprite\n", group, image, (image % 32) * 64, (image / 32) * 64);
+		source += std::format("imagearray, name=\"arr{}\", x=0, y=0, w=32, h=32, xc=16, yc=16, format=ARGB4444\n", group);
+		source += std::format("imagesequence, name=\"seq{}\", mode=loop\n", group);
+		source += std::format("imageframe, time=4\n");
+	}
+
+	source += "tileset, id=1, name=\"tiles\", w=8, h=8, format=RGB565\n";
+	source += "tilearray, x=0, y=0, tw=256, th=256\n";
+
+	return source;
+}
+
+std::string
+make_tmx_source(uint32_t width, uint32_t height, uint32_t seed, TMXEncoding encoding)
+{
+	const auto tiles = make_tile_layer(width, height, seed);
+
+	std::string source("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	source += std::format("<map version=\"1.10\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\"{}\" height=\"{}\" tilewidth=\"{}\" tileheight=\"{}\" infinite=\"0\">\n", width, height, TILE_SIZE, TILE_SIZE);
+	source += " <tileset firstgid=\"1\" source=\"tiles.tsx\"/>\n";
+	source += std::format(" <layer id=\"1\" name=\"bench\" width=\"{}\" height=\"{}\">\n", width, height);
+
+	if(encoding == TMXEncoding::CSV)
+	{
+		source += "  <data encoding=\"csv\">\n";
+		for(uint32_t y=0; y<height; ++y)
+		{
+			for(uint32_t x=0; x<width; ++x)
+			{
+				const auto tile = tiles[(std::size_t(y) * width) + x];
+				source += std::format("{}", tile == 0 ? 0 : tile + 1);
+				if((x + 1 < width) || (y + 1 < height))
+					source += ',';
+			}
+			source += '\n';
+		}
+	}
+	else
+	{
+		// ----- 32 bit little endian tile ids, as written by Tiled. -----
+		std::vector<uint8_t> ids;
+		ids.reserve(tiles.size() * 4);
+		for(auto tile : tiles)
+		{
+			const uint32_t id = tile == 0 ? 0 : uint32_t(tile + 1);
+			for(int shift=0; shift<32; shift+=8)
+				ids.push_back(uint8_t(id >> shift));
+		}
+
+		if(encoding == TMXEncoding::BASE64)
+			source += "  <data encoding=\"base64\">\n   ";
+#if defined(GAP_HAVE_ZLIB)
+		else
+		{
+			std::vector<uint8_t> packed(compressBound(ids.size()));
+			uLongf size = packed.size();
+			compress2(packed.data(), &size, ids.data(), ids.size(), Z_DEFAULT_COMPRESSION);
+			packed.resize(size);
+			ids = std::move(packed);
+			source += "  <data encoding=\"base64\" compression=\"zlib\">\n   ";
+		}
+#endif
+		source += ade::base64::encode(ids) + "\n  ";
+	}
+
+	source += "</data>\n </layer>\n</map>\n";
+	return source;
+}
+
+} // namespace gap::bench
@@ -0,0 +1,73 @@
+//=============================================================================
+//	FILE:					workloads.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Reproducible synthetic workloads for the benchmarks
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_BENCH_WORKLOADS_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_BENCH_WORKLOADS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "assets.h"
+#include "image.h"
+#include "tilemap.h"
+
+namespace gap::bench
+{
+
+// Deterministic pseudo random number generator (xorshift32) so that every
+// run, on every machine, generates identical data.
+class Random
+{
+private:
+	uint32_t		m_state;
+
+public:
+	explicit Random(uint32_t seed = 0x12345678U) : m_state(seed ? seed : 1U) {}
+
+	uint32_t		next()										{m_state ^= m_state << 13; m_state ^= m_state >> 17; m_state ^= m_state << 5; return m_state;}
+	uint32_t		next(uint32_t range)			{return next() % range;}
+};
+
+static constexpr int				SPRITE_SIZE			= 64;
+static constexpr int				TILE_SIZE				= 8;
+
+// An ARGB8888 atlas made up of SPRITE_SIZE cells, each containing a filled
+// circle surrounded by transparent pixels.
+std::unique_ptr<gap::image::SourceImage>		make_atlas(int width, int height, uint32_t seed);
+
+// A gap::tilemap::TileMap with a mixture of empty blocks, uniform blocks
+// and noise.
+std::unique_ptr<gap::tilemap::TileMap>			make_tilemap(uint32_t width, uint32_t height, uint32_t blocksize, uint32_t seed);
+
+// Raw tile data for a width x height layer with the same distribution as
+// make_tilemap().
+std::vector<uint64_t>												make_tile_layer(uint32_t width, uint32_t height, uint32_t seed);
+
+std::vector<uint8_t>												make_file_data(std::size_t size, uint32_t seed);
+
+// Populate assets with 'atlas_count' atlases, each cut into sprites, plus a
+// tileset of 'tile_count' tiles taken from the first atlas.
+void																				add_atlas_images(gap::assets::Assets & assets, int atlas_count, int atlas_size, uint32_t seed);
+void																				add_tileset(gap::assets::Assets & assets, int tile_count);
+
+// Generate the source of a .gap file with the given number of image groups
+// and images per group.
+std::string																	make_gap_source(int group_count, int images_per_group);
+
+// Generate a Tiled TMX document with a single layer. BASE64_ZLIB is only
+// available when zlib support is built in (GAP_HAVE_ZLIB).
+enum class TMXEncoding {CSV, BASE64, BASE64_ZLIB};
+
+std::string																	make_tmx_source(uint32_t width, uint32_t height, uint32_t seed, TMXEncoding encoding = TMXEncoding::CSV);
+
+} // namespace gap::bench
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_BENCH_WORKLOADS_H
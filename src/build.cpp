@@ -15,6 +15,7 @@
 #include "encode_gbin.h"
 #include "export.h"
 #include "utility/hexdump.h"
+#include "logger.h"
 
 namespace gap
 {
@@ -23,18 +24,18 @@ namespace gap
 int
 build(const gap::Configuration & config, gap::FileSystem & filesystem)
 {
-	std::cout << "=============================================================================\n\n"; 
+	gap::logger::info("=============================================================================\n");
 
 	if(config.input_file.empty())
 	{
-		std::cerr << "No Input File!\n";
+		gap::logger::error("No Input File!");
 		return -1;
 	}
 
 	auto filedata = filesystem.load(config.input_file);
 	if(filedata.empty())
 	{
-		std::cerr << "Failed to load the source file or it is empty!\n";
+		gap::logger::error("Failed to load the source file or it is empty!");
 		return -1;
 	}
 
@@ -46,17 +47,36 @@ build(const gap::Configuration & config, gap::FileSystem & filesystem)
 	if(p_assets == nullptr)
 		return -1;
 
+	if(p_assets->build_palettes() < 0)
+	{
+		gap::logger::error("{}", p_assets->get_last_error());
+		return -1;
+	}
+
 //	std::cout << source << std::endl;
 //	p_assets->dump();
 
+	// The source images are only needed until the last GBIN has been encoded,
+	// so that export may release each one as soon as it has been used.
+	int gbin_exports = 0;
+	parser.enumerate_exports([&](const auto & exportinfo)->bool
+		{
+			if(exportinfo.type == gap::exporter::TYPE_GBIN)
+				++gbin_exports;
+			return true;
+		});
+
 	parser.enumerate_exports([&](const auto & exportinfo)->bool
 		{
-			std::cout << "EXPORT: " << exportinfo.filename << " type:" << exportinfo.type << " format:" << exportinfo.format << std::endl;
+			gap::logger::info("EXPORT: {} type:{} format:{}", exportinfo.filename, exportinfo.type, exportinfo.format);
+			if((exportinfo.type == gap::exporter::TYPE_GBIN) && (--gbin_exports == 0))
+				p_assets->set_release_source_images(!config.b_retain_original_source_images);
 			export_assets(*(p_assets.get()),exportinfo,config);
 			return true;
 		});
 
-	std::cout << "Finished\n";
+	gap::logger::info("Finished");
+	gap::logger::flush();
 	return 0;
 }
 
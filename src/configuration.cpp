@@ -9,6 +9,7 @@
 //	CREATED:				24-SEP-2019 Adrian Purser <ade@arcadestuff.com>
 //=============================================================================
 
+#include <algorithm>
 #include <print>
 #include "config.h"
 #include "utility/program_options.h"
@@ -28,6 +29,11 @@ parse_command_line(int argc,char ** argv,Configuration & out_config)
 	grp_general.add_option("version","Display version information");
 	grp_general.add_option("mount,m","Mount Package","<Path>,<MountPoint>");
 	grp_general.add_option("output,o","Output Directory","<Path>");
+	grp_general.add_option("quiet,q","Only display errors");
+	grp_general.add_option("verbose,v","Display details of each asset. Use twice for trace output");
+	grp_general.add_option("trace","Display trace output including tilemap dumps");
+	grp_general.add_option("hq","High quality (slower) block compression for release builds");
+	grp_general.add_option("retain","Keep the decoded source images in memory until the build has finished");
 
 	program_options::OptionGroup grp_tests;
 	grp_tests.add_option("test,t","Test Mode","<Mode>");
@@ -73,6 +79,21 @@ parse_command_line(int argc,char ** argv,Configuration & out_config)
 	if(values.options.count("output"))
 		out_config.output_prefix = values.options["output"].back();
 
+	if(values.options.count("quiet"))
+		out_config.verbosity = gap::logger::QUIET;
+	else if(values.options.count("trace"))
+		out_config.verbosity = gap::logger::TRACE;
+	else if(values.options.count("verbose"))
+		out_config.verbosity = std::min<int>(gap::logger::NORMAL + values.options["verbose"].size(), gap::logger::TRACE);
+
+	gap::logger::set_level(out_config.verbosity);
+
+	if(values.options.count("hq"))
+		out_config.b_high_quality_compression = true;
+
+	if(values.options.count("retain"))
+		out_config.b_retain_original_source_images = true;
+
 	if(values.options.count("test"))
 	{
 		out_config.test_mode = values.options["test"].back();
@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include "logger.h"
 
 namespace gap
 {
@@ -31,6 +32,8 @@ struct Configuration
 	std::string										output_prefix;
 	bool													b_big_endian													= false;
 	bool													b_retain_original_source_images				= false;
+	bool													b_high_quality_compression						= false;
+	int														verbosity															= gap::logger::NORMAL;
 	std::vector<MountPoint>				mount_points;
 	std::string										test_mode;
 	std::vector<std::string>			args;
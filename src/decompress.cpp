@@ -0,0 +1,123 @@
+//=============================================================================
+//	FILE:					decompress.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	zlib, gzip and zstd decompression of embedded data
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <climits>
+#include "decompress.h"
+#include "utility/hash.h"
+
+#if defined(GAP_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(GAP_HAVE_ZSTD)
+#include <zstd.h>
+#include <zstd_errors.h>
+#endif
+
+namespace gap::compression
+{
+
+int
+method_from_name(std::string_view name)
+{
+	if(name.empty())
+		return NONE;
+
+	switch(ade::hash::hash_ascii_string_as_lower(name.data(), name.size()))
+	{
+		case ade::hash::hash_ascii_string_as_lower("zlib") :	return ZLIB;
+		case ade::hash::hash_ascii_string_as_lower("gzip") :	return GZIP;
+		case ade::hash::hash_ascii_string_as_lower("zstd") :	return ZSTD;
+		default : break;
+	}
+	return UNKNOWN;
+}
+
+bool
+is_supported(int method)
+{
+	switch(method)
+	{
+		case NONE :	return true;
+#if defined(GAP_HAVE_ZLIB)
+		case ZLIB :	return true;
+		case GZIP :	return true;
+#endif
+#if defined(GAP_HAVE_ZSTD)
+		case ZSTD :	return true;
+#endif
+		default :		break;
+	}
+	return false;
+}
+
+#if defined(GAP_HAVE_ZLIB)
+static
+std::error_code
+inflate_zlib(std::span<const uint8_t> in, std::span<uint8_t> out, bool b_gzip)
+{
+	if((in.size() > UINT_MAX) || (out.size() > UINT_MAX))
+		return std::make_error_code(std::errc::value_too_large);
+
+	z_stream stream{};
+	stream.next_in		= const_cast<Bytef *>(in.data());
+	stream.avail_in		= uInt(in.size());
+	stream.next_out		= out.data();
+	stream.avail_out	= uInt(out.size());
+
+	if(inflateInit2(&stream, b_gzip ? (MAX_WBITS + 16) : MAX_WBITS) != Z_OK)
+		return std::make_error_code(std::errc::not_enough_memory);
+
+	const int result = inflate(&stream, Z_FINISH);
+	const auto total = stream.total_out;
+	inflateEnd(&stream);
+
+	if(result == Z_STREAM_END)
+		return total == out.size() ? std::error_code() : std::make_error_code(std::errc::invalid_argument);
+	if(result == Z_BUF_ERROR)
+		return std::make_error_code((stream.avail_out == 0) ? std::errc::invalid_argument : std::errc::illegal_byte_sequence);
+	return std::make_error_code(std::errc::illegal_byte_sequence);
+}
+#endif
+
+std::error_code
+decompress(std::span<const uint8_t> in, std::span<uint8_t> out, int method)
+{
+	switch(method)
+	{
+		case NONE :
+			if(in.size() != out.size())
+				return std::make_error_code(std::errc::invalid_argument);
+			std::copy(begin(in), end(in), begin(out));
+			return {};
+
+#if defined(GAP_HAVE_ZLIB)
+		case ZLIB :	return inflate_zlib(in, out, false);
+		case GZIP :	return inflate_zlib(in, out, true);
+#endif
+
+#if defined(GAP_HAVE_ZSTD)
+		case ZSTD :
+			{
+				const auto size = ZSTD_decompress(out.data(), out.size(), in.data(), in.size());
+				if(ZSTD_isError(size))
+					return std::make_error_code(ZSTD_getErrorCode(size) == ZSTD_error_dstSize_tooSmall ? std::errc::invalid_argument : std::errc::illegal_byte_sequence);
+				return size == out.size() ? std::error_code() : std::make_error_code(std::errc::invalid_argument);
+			}
+#endif
+
+		default : break;
+	}
+
+	return std::make_error_code(std::errc::protocol_not_supported);
+}
+
+} // namespace gap::compression
@@ -0,0 +1,51 @@
+//=============================================================================
+//	FILE:					decompress.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	zlib, gzip and zstd decompression of embedded data
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_DECOMPRESS_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_DECOMPRESS_H
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+namespace gap::compression
+{
+
+enum
+{
+	NONE = 0,
+	ZLIB,
+	GZIP,
+	ZSTD,
+	UNKNOWN
+};
+
+// Method from its name as used by Tiled ("", "zlib", "gzip" or "zstd"),
+// case insensitive. UNKNOWN if it is not recognised.
+int								method_from_name(std::string_view name);
+
+// False if support for the method was not built in (GAP_HAVE_ZLIB,
+// GAP_HAVE_ZSTD).
+bool							is_supported(int method);
+
+//-----------------------------------------------------------------------------
+//	Decompress 'in' straight into 'out', which must be exactly the size of the
+//	decompressed data.
+//
+//	std::errc::protocol_not_supported	- The method is unknown or not built in.
+//	std::errc::illegal_byte_sequence	- The data is corrupt.
+//	std::errc::invalid_argument				- The data does not fill 'out' exactly.
+//-----------------------------------------------------------------------------
+std::error_code		decompress(std::span<const uint8_t> in, std::span<uint8_t> out, int method);
+
+} // namespace gap::compression
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_DECOMPRESS_H
@@ -0,0 +1,67 @@
+//=============================================================================
+//	FILE:					dedupe.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Sharing of identical data blocks within a chunk
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_DEDUPE_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_DEDUPE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include "utility/hash.h"
+
+namespace gap
+{
+
+//-----------------------------------------------------------------------------
+//	Remembers the blocks of data that have been written into a chunk so that
+//	a later block with identical content can reference the existing copy.
+//	Blocks are found by hash and then compared byte for byte.
+//-----------------------------------------------------------------------------
+class DataDedupe
+{
+private:
+	struct Entry
+	{
+		uint32_t		offset;
+		uint32_t		size;
+	};
+
+	std::unordered_multimap<uint64_t,Entry>		m_entries;
+
+public:
+	// Returns the offset, within 'chunk_data', of a block identical to 'block'.
+	std::optional<uint32_t>	find(std::span<const uint8_t> chunk_data, std::span<const uint8_t> block) const
+													{
+														const auto hash = ade::hash::hash_bytes(block.data(), block.size());
+														const auto [first, last] = m_entries.equal_range(hash);
+														for(auto it = first; it != last; ++it)
+														{
+															const auto & entry = it->second;
+															if(	(entry.size == block.size()) &&
+																	(std::size_t(entry.offset) + entry.size <= chunk_data.size()) &&
+																	std::equal(begin(block), end(block), chunk_data.begin() + entry.offset) )
+																return entry.offset;
+														}
+														return std::nullopt;
+													}
+
+	void										add(std::span<const uint8_t> block, uint32_t offset)
+													{
+														m_entries.emplace(ade::hash::hash_bytes(block.data(), block.size()), Entry{offset, (uint32_t)block.size()});
+													}
+
+	std::size_t							size() const		{return m_entries.size();}
+};
+
+} // namespace gap
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_DEDUPE_H
@@ -13,6 +13,7 @@
 #include <format>
 #include <iostream>
 #include "encode_definitions.h"
+#include "logger.h"
 
 namespace gap
 {
@@ -134,12 +135,12 @@ encode_definitions(const gap::exporter::ExportInfo & exportinfo, const gap::asse
 	//	Image Sequences
 	//---------------------------------------------------------------------------
 	{
-		std::cout << "Enumerating Sequences...\n";
+		gap::logger::verbose("Enumerating Sequences...");
 		std::map<uint32_t,std::string>	sequences;
 
 		assets.enumerate_image_sequences( [&](uint32_t sequence_number, const gap::assets::ImageSequence & imgseq)->bool
 			{	
-				std::cout << "  SEQ: " << imgseq.name << " = " << sequence_number << '\n';
+				gap::logger::trace("  SEQ: {} = {}", imgseq.name, sequence_number);
 				sequences[sequence_number] = imgseq.name;	
 				return true;
 			});
@@ -173,6 +174,50 @@ encode_definitions(const gap::exporter::ExportInfo & exportinfo, const gap::asse
 		});
 	definitions.append("};\n\n} // namespace tileset\n\n");
 
+	//---------------------------------------------------------------------------
+	//	TileMap Flags
+	//---------------------------------------------------------------------------
+	std::string tilemap_flags;
+	assets.enumerate_tilemaps([&](const gap::tilemap::TileMap & tilemap)->bool
+		{
+			if(tilemap.flag_names().empty())
+				return true;
+
+			std::string nam = tilemap.name().empty() ? std::format("tilemap{}", tilemap.id()) : tilemap.name();
+			std::transform(begin(nam),end(nam),begin(nam),[](char ch) {return isalnum(ch) ? tolower(ch) : '_';});
+
+			tilemap_flags.append(std::format("namespace {}\n{{\nenum\n{{\n", nam));
+			for(std::size_t bit=0; bit<tilemap.flag_names().size(); ++bit)
+			{
+				std::string flag = tilemap.flag_names()[bit];
+				std::transform(begin(flag),end(flag),begin(flag),[](char ch) {return isalnum(ch) ? toupper(ch) : '_';});
+				tilemap_flags.append(std::format("\t{:24} = 0x{:08X},\n", "FLAG_" + flag, 1U << bit));
+			}
+			tilemap_flags.append(std::format("}};\n}} // namespace {}\n\n", nam));
+			return true;
+		});
+
+	if(!tilemap_flags.empty())
+		definitions.append("namespace tilemap\n{\n\n" + tilemap_flags + "} // namespace tilemap\n\n");
+
+	//---------------------------------------------------------------------------
+	//	Sound Samples - The index of each named sample in the SWAV chunk.
+	//---------------------------------------------------------------------------
+	std::string	samples;
+	int					sample_index = 0;
+	assets.enumerate_sound_samples([&](const gap::sound::SoundSample & sample)->bool
+		{
+			std::string nam = sample.name();
+			std::transform(begin(nam),end(nam),begin(nam),[](char ch) {return isalnum(ch) ? toupper(ch) : '_';});
+			if(!nam.empty())
+				samples.append(std::format("\t{:24} = {},\n",nam,sample_index));
+			++sample_index;
+			return true;
+		});
+
+	if(!samples.empty())
+		definitions.append("namespace sound\n{\nenum\n{\n" + samples + "};\n} // namespace sound\n\n");
+
 	definitions.append("} // namespace game\n\n");
 
 	//---------------------------------------------------------------------------
@@ -9,13 +9,20 @@
 //	CREATED:			30-SEP-2019 Adrian Purser <ade&arcadestuff.com>
 //=============================================================================
 
+#include <algorithm>
 #include <iostream>
+#include <map>
+#include <span>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <format>
 #include <print>
 
 #include "encode_gbin.h"
+#include "atlas.h"
+#include "dedupe.h"
+#include "logger.h"
 
 #define HEADER_SIZE		32
 #define VERSION "02"
@@ -181,10 +188,163 @@ struct TSETChunkEntry
 
 static const uint32_t TSET_SHUNK_SIZE = 12;
 
+//-----------------------------------------------------------------------------
+//	An image that has been trimmed and encoded, waiting to be placed on an
+//	atlas page.
+//-----------------------------------------------------------------------------
+struct AtlasImage
+{
+	std::size_t							imag_index	= 0;				// Index of the image's IMAGChunkEntry.
+	uint8_t									pixel_format = 0;
+	int											width				= 0;
+	int											height			= 0;
+	std::vector<uint8_t>		data;
+	int											shared			= -1;				// Index of an identical, earlier atlas image.
+};
+
+static
+void
+append_padded(std::vector<std::uint8_t> & data, std::span<const uint8_t> block)
+{
+	data.insert(end(data),begin(block),end(block));
+	auto sz = (data.size() + 3) & ~3;
+	if(sz > data.size())
+		data.resize(sz);
+}
+
+//-----------------------------------------------------------------------------
+//	Packs the atlas images into pages, appends the pages to the IMGD chunk
+//	data and points each image's IMAG entry at its region of a page.
+//	'data_offset' is the offset of the IMGD chunk data within 'data'.
+//-----------------------------------------------------------------------------
 static
 void
-encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config)
+append_atlas_pages(	std::vector<std::uint8_t> & 						data,
+										std::size_t 														data_offset,
+										std::vector<AtlasImage> & 							atlas_images,
+										std::vector<IMAGChunkEntry> & 					images,
+										const gap::assets::AtlasSettings & 			settings )
+{
+	// ----- Identical trimmed images share one region. -----
+	std::unordered_multimap<uint64_t,std::size_t> hashes;
+	int shared_count = 0;
+
+	for(std::size_t i=0; i<atlas_images.size(); ++i)
+	{
+		auto & image = atlas_images[i];
+		const auto hash = ade::hash::hash_bytes(image.data.data(), image.data.size());
+
+		const auto [first, last] = hashes.equal_range(hash);
+		for(auto it = first; it != last; ++it)
+		{
+			const auto & other = atlas_images[it->second];
+			if(	(other.pixel_format == image.pixel_format) && (other.width == image.width) &&
+					(other.height == image.height) && (other.data == image.data) )
+			{
+				image.shared = it->second;
+				++shared_count;
+				break;
+			}
+		}
+
+		if(image.shared < 0)
+			hashes.emplace(hash, i);
+	}
+
+	// ----- Pages only hold images of a single pixel format. -----
+	std::map<uint8_t, std::vector<std::size_t>> formats;
+	for(std::size_t i=0; i<atlas_images.size(); ++i)
+		if((atlas_images[i].shared < 0) && (atlas_images[i].width > 0) && (atlas_images[i].height > 0))
+			formats[atlas_images[i].pixel_format].push_back(i);
+
+	for(const auto & [pixel_format, indices] : formats)
+	{
+		const int bpp = gap::image::pixelformat::bytes_per_pixel(pixel_format);
+
+		std::vector<gap::image::Rect> sizes;
+		sizes.reserve(indices.size());
+		for(auto index : indices)
+			sizes.push_back(gap::image::Rect{0, 0, atlas_images[index].width, atlas_images[index].height});
+
+		const auto layout = gap::atlas::pack(sizes, settings.page_width, settings.page_height);
+
+		for(std::size_t ipage = 0; ipage < layout.pages.size(); ++ipage)
+		{
+			const auto & page = layout.pages[ipage];
+			const uint32_t page_offset = data.size() - data_offset;
+			const std::size_t page_stride = std::size_t(page.width) * bpp;
+
+			std::vector<uint8_t> page_data(page_stride * page.height, 0);
+			std::size_t used_pixels = 0;
+			int image_count = 0;
+
+			for(std::size_t i=0; i<indices.size(); ++i)
+			{
+				const auto & placement = layout.placements[i];
+				if(std::cmp_not_equal(placement.page, ipage))
+					continue;
+
+				const auto & image = atlas_images[indices[i]];
+				const std::size_t line_size = std::size_t(image.width) * bpp;
+				for(int y=0; y<image.height; ++y)
+					std::copy_n(image.data.data() + (y * line_size), line_size, page_data.data() + ((placement.y + y) * page_stride) + (placement.x * bpp));
+
+				auto & imag = images[image.imag_index];
+				imag.image_data_offset	= page_offset + ((placement.y * page.width) + placement.x) * bpp;
+				imag.line_offset				= page.width - image.width;
+
+				used_pixels += std::size_t(image.width) * image.height;
+				++image_count;
+			}
+
+			gap::logger::verbose("IMGD: atlas page {} ({}) {}x{}, {} images, {}% used",	ipage, gap::image::get_pixelformat_name(pixel_format), page.width, page.height,
+																																					image_count, (used_pixels * 100) / (std::size_t(page.width) * page.height));
+			append_padded(data, page_data);
+		}
+
+		// ----- Images that are too large for a page are stored on their own. -----
+		for(std::size_t i=0; i<indices.size(); ++i)
+		{
+			if(layout.placements[i].page >= 0)
+				continue;
+
+			const auto & image = atlas_images[indices[i]];
+			gap::logger::verbose("IMGD: image {}x{} does not fit on a {}x{} atlas page", image.width, image.height, settings.page_width, settings.page_height);
+
+			images[image.imag_index].image_data_offset = data.size() - data_offset;
+			append_padded(data, image.data);
+		}
+	}
+
+	for(const auto & image : atlas_images)
+	{
+		if(image.shared >= 0)
+		{
+			const auto & source = images[atlas_images[image.shared].imag_index];
+			images[image.imag_index].image_data_offset	= source.image_data_offset;
+			images[image.imag_index].line_offset				= source.line_offset;
+		}
+	}
+
+	if(shared_count > 0)
+		gap::logger::verbose("IMGD: {} atlas images share the data of an identical image", shared_count);
+}
+
+static
+bool
+is_same_source_region(const gap::image::Image & a, const gap::image::Image & b)
 {
+	return 	(a.source_image == b.source_image) &&
+					(a.x == b.x) && (a.y == b.y) && (a.width == b.width) && (a.height == b.height) &&
+					(a.x_origin == b.x_origin) && (a.y_origin == b.y_origin) &&
+					(a.b_hflip == b.b_hflip) && (a.b_vflip == b.b_vflip);
+}
+
+int
+encode_packed_image_chunks(std::vector<std::uint8_t> & data,gap::assets::Assets & assets,const gap::Configuration & config)
+{
+	int errors = 0;
+
 	struct ImageGroup
 	{
 		std::string	name;
@@ -208,119 +368,392 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 	assets.enumerate_image_groups( [&](const std::string & /*name*/ ,uint32_t /*group_number*/,uint16_t /*base*/, uint16_t /*size*/ )->bool	{	b_have_image_data = true; return false; });
 	assets.enumerate_tilesets( [&](const gap::tileset::TileSet & /*tileset*/)->bool {	b_have_image_data = true; return false; });
 
+	// Images whose encoded data is identical to an earlier image (e.g. a
+	// symmetrical sprite rotated by 180 degrees) share that image's data.
+	gap::DataDedupe image_dedupe;
+	int shared_image_count = 0;
+
+	// Encoded size of the run length encoded images and their size in the raw
+	// base format, for the size report.
+	std::size_t rle_bytes = 0;
+	std::size_t rle_raw_bytes = 0;
+
+	// Colour maps for the indexed formats. IMAG and TSET entries refer to
+	// them by their CMAP index.
+	std::vector<gap::image::Palette> palettes;
+	assets.enumerate_colourmaps([&](const gap::assets::ColourMap & cmap)->bool
+		{
+			palettes.emplace_back(cmap.colourmap);
+			return true;
+		});
+
+	auto set_palette = [&](int colour_map, gap::image::EncodeOptions & encode) -> int
+	{
+		if((colour_map < 0) || std::cmp_greater_equal(colour_map, palettes.size()))
+			return 0;
+		encode.p_palette = &palettes[colour_map];
+		return colour_map;
+	};
+
+	// The palette of an IMAG or TSET entry is a single byte.
+	auto palette_index = [&](int colour_map, std::string_view name) -> uint8_t
+	{
+		if(colour_map <= 0x0FF)
+			return colour_map;
+
+		gap::logger::error("'{}': Colour map {} is too large for the 8 bit palette index!",name,colour_map);
+		++errors;
+		return 0;
+	};
+
+	// In atlas mode the images are trimmed and collected here, then packed
+	// into pages once every image is known.
+	const auto & atlas = assets.atlas_settings();
+	std::vector<AtlasImage> atlas_images;
+
+	// An encoded image that is ready to be placed in IMGD or on an atlas page.
+	struct EncodedImage
+	{
+		IMAGChunkEntry					imag;
+		std::vector<uint8_t>		data;
+		bool										b_atlas = false;
+	};
+
+	auto encode_image = [&](const gap::image::Image & image, gap::image::SourceImage & source, int ox, int oy) -> EncodedImage
+	{
+		const bool b_atlas = atlas.b_enabled && (gap::image::pixelformat::bytes_per_pixel(image.pixel_format) > 0);
+
+		// ----- Crop away any fully transparent border. -----
+		const auto bounds = (b_atlas || image.b_trim) ? source.opaque_bounds() : gap::image::Rect{0, 0, source.width(), source.height()};
+
+		IMAGChunkEntry imag;
+
+		imag.width							= bounds.width;
+		imag.height							= bounds.height;
+		imag.x_origin						= ox - bounds.x;
+		imag.y_origin						= oy - bounds.y;
+		imag.line_offset				= 0;
+		imag.pixel_format				= image.pixel_format;
+		imag.image_data_offset	=	0;
+
+		auto encode = image.encode;
+		encode.b_high_quality |= config.b_high_quality_compression;
+		imag.palette = palette_index(set_palette(image.colour_map, encode), image.name);
+
+		auto imgdata = source.create_sub_target_data(bounds.x,bounds.y,bounds.width,bounds.height,image.pixel_format,config.b_big_endian,encode);
+
+		if(gap::image::pixelformat::is_rle(image.pixel_format))
+		{
+			rle_bytes			+= imgdata.size();
+			rle_raw_bytes	+= gap::image::pixelformat::image_data_size(gap::image::pixelformat::base_format(image.pixel_format),bounds.width,bounds.height);
+		}
+
+		return {imag, std::move(imgdata), b_atlas};
+	};
+
+	auto place_image = [&](EncodedImage && encoded)
+	{
+		auto & imag = encoded.imag;
+
+		if(encoded.b_atlas)
+		{
+			AtlasImage atlas_image;
+			atlas_image.imag_index		= images.size();
+			atlas_image.pixel_format	= imag.pixel_format;
+			atlas_image.width					= imag.width;
+			atlas_image.height				= imag.height;
+			atlas_image.data					= std::move(encoded.data);
+			atlas_images.push_back(std::move(atlas_image));
+
+			images.push_back(imag);
+			return;
+		}
+
+		imag.image_data_offset = image_offset;
+
+		const std::span<const uint8_t> chunk_data(data.data() + chunk_offset + 8, data.size() - (chunk_offset + 8));
+		if(auto offset = image_dedupe.find(chunk_data,encoded.data))
+		{
+			imag.image_data_offset = *offset;
+			++shared_image_count;
+		}
+		else
+		{
+			image_dedupe.add(encoded.data,image_offset);
+			append_padded(data,encoded.data);
+			image_offset = data.size() - (chunk_offset+8);
+		}
+
+		images.push_back(imag);
+	};
+
+	//---------------------------------------------------------------------------
+	//	Jobs
+	//
+	//	A job encodes one image, a batch of consecutive images that take the
+	//	same region of a source image and differ only by angle (e.g. generated
+	//	with 'angle-step') which are rotated together, the header of a tileset
+	//	or one tile.
+	//
+	//	When the assets release their source images the jobs are run in source
+	//	image order and each source image is released as soon as the last
+	//	image or tile cut from it has been encoded. The results are always
+	//	placed in the original order, as soon as every earlier job has been
+	//	placed.
+	//---------------------------------------------------------------------------
+	struct EncodeJob
+	{
+		int																			source			= -1;				// -1 if the job does not use a source image.
+		std::vector<const gap::image::Image *>	images;
+		const gap::tileset::TileSet *						p_tileset		= nullptr;
+		const gap::tileset::Tile *							p_tile			= nullptr;		// nullptr for the tileset header.
+		std::vector<EncodedImage>								results;
+		std::vector<uint8_t>										tile_data;
+		bool																		b_done			= false;
+	};
+
+	std::vector<EncodeJob>	jobs;
+	std::size_t							image_job_count = 0;
+
 	if(b_have_image_data)
 	{
-		std::cout << "Encoding Chunk IMGD\n";
+		gap::logger::verbose("Encoding Chunk IMGD");
 
 		fourcc_append("IMGD",data);
 		fourcc_append("size",data);
 
+		uint32_t image_count = 0;
+
 		assets.enumerate_image_groups([&](const std::string & name,uint32_t group_number,uint16_t base, uint16_t size)->bool
 			{
 //				std::cout << "  GROUP: " << group_number << " BASE: " << base << " INDEX: " << images.size() << '\n';
 
 				groups[group_number].name 	= name;
-				groups[group_number].index 	= images.size();
+				groups[group_number].index 	= image_count;
 				groups[group_number].base 	= base;
 				groups[group_number].size 	= size;
 
 				if(group_number > max_group)
 					max_group = group_number;
 
-				//-----------------------------------------------------------------------
-				//	IMAGES
-				//-----------------------------------------------------------------------
+				std::vector<const gap::image::Image *> group_images;
 				assets.enumerate_group_images(group_number,[&](int /*image_index*/,const gap::image::Image & image)->bool
 				{
-					auto p_image = assets.get_source_subimage(image.source_image,image.x,image.y,image.width,image.height);
-
-					if(image.b_hflip)	p_image->horizontal_flip();
-					if(image.b_vflip)	p_image->vertical_flip();
-
-					int ox = image.x_origin;
-					int oy = image.y_origin;
-					p_image->rotate(image.angle,ox,oy);
-
-					IMAGChunkEntry imag;
+					group_images.push_back(&image);
+					return true;
+				});
 
-					imag.width							= p_image->width();
-					imag.height							= p_image->height();
-					imag.x_origin						= ox;
-					imag.y_origin						= oy;
-					imag.line_offset				= assets.get_target_line_stride(image.source_image)-image.width;
-					imag.pixel_format				= image.pixel_format;
-					imag.palette						= 0;  //TODO: Get the palette index
-					imag.image_data_offset	=	image_offset;
+				for(std::size_t first = 0; first < group_images.size();)
+				{
+					std::size_t last = first + 1;
+					while((last < group_images.size()) && is_same_source_region(*group_images[first], *group_images[last]))
+						++last;
 
-					images.push_back(imag);
+					EncodeJob job;
+					job.source = group_images[first]->source_image;
+					job.images.assign(begin(group_images) + first, begin(group_images) + last);
+					jobs.push_back(std::move(job));
 
-					auto imgdata = p_image->create_sub_target_data(0,0,imag.width,imag.height,image.pixel_format,config.b_big_endian);
-					//auto imgdata = assets.get_target_subimage(image.source_image,image.x,image.y,image.width,image.height,image.pixel_format,config.b_big_endian);
-/*
-					std::cout << "get_target_subimage(x:0,y:0,w:" << (int)imag.width << ",h:" << (int)imag.height
-										<< ",pf: " << image.pixel_format << ") = " << imgdata.size() << " bytes"
-										<< " name:" << image.name << '\n';
-*/
-					data.insert(end(data),begin(imgdata),end(imgdata));
-					auto sz = (data.size() + 3) & ~3;
-					if(sz > data.size())
-						data.resize(sz);
-
-					image_offset = data.size() - (chunk_offset+8);
-					return true;
-				});
+					image_count += last - first;
+					first = last;
+				}
 				return true;
 			});
 	}
 
-	//-----------------------------------------------------------------------
-	//	TILESETS
-	//-----------------------------------------------------------------------
+	image_job_count = jobs.size();
+
 	assets.enumerate_tilesets( [&](const gap::tileset::TileSet & tileset)->bool
 		{
-			TSETChunkEntry tset;
-			tset.width							= tileset.tile_width;
-			tset.height							= tileset.tile_height;
-			tset.pixel_format				= tileset.pixel_format;
-			tset.palette						= 0;
-			tset.tile_count					= tileset.tiles.size();
-			tset.id									= tileset.id;
-			tset.image_data_offset 	= image_offset;
+			EncodeJob header;
+			header.p_tileset = &tileset;
+			jobs.push_back(std::move(header));
 
-			std::cout << std::format("GBIN:TILESET: id={}, name={}, tilesize = {}x{}, {} tiles\n",tileset.id,tileset.name,tileset.tile_width,tileset.tile_height,tileset.tiles.size());
+			for(const auto & tile : tileset.tiles)
+			{
+				EncodeJob job;
+				job.source		= tile.source_image;
+				job.p_tileset	= &tileset;
+				job.p_tile		= &tile;
+				jobs.push_back(std::move(job));
+			}
+			return true;
+		});
 
-			tilesets.push_back(tset);
+	auto run_job = [&](EncodeJob & job)
+	{
+		if(!job.images.empty())
+		{
+			const auto & image = *job.images.front();
+			auto p_image = assets.get_source_subimage(image.source_image,image.x,image.y,image.width,image.height);
+			if(p_image == nullptr)
+			{
+				gap::logger::error("IMGD: Source image {} of image '{}' is not available!",image.source_image,image.name);
+				++errors;
+				return;
+			}
 
-			for(const auto & tile : tileset.tiles)
+			if(image.b_hflip)	p_image->horizontal_flip();
+			if(image.b_vflip)	p_image->vertical_flip();
+
+			if(job.images.size() == 1)
+			{
+				int ox = image.x_origin;
+				int oy = image.y_origin;
+				p_image->rotate(image.angle,ox,oy);
+				job.results.push_back(encode_image(image,*p_image,ox,oy));
+			}
+			else
 			{
-				// TODO: Handle image transform (flip, rotate etc)
-				auto p_image = assets.get_source_subimage(tile.source_image,tile.x,tile.y,tileset.tile_width,tileset.tile_height);
+				std::vector<float> angles;
+				for(auto p_batch_image : job.images)
+					angles.push_back(p_batch_image->angle);
 
-				switch(tile.transform & 0x03)
-				{
-					case gap::tileset::ROTATE_90 	: p_image->rotate_90(); break;
-					case gap::tileset::ROTATE_180	: p_image->rotate_180(); break;
-					case gap::tileset::ROTATE_270	: p_image->rotate_270(); break;
-				}
-				if(tile.transform & gap::tileset::FLIP_HORZ)	p_image->horizontal_flip();
-				if(tile.transform & gap::tileset::FLIP_VERT)	p_image->vertical_flip();
+				auto copies = p_image->rotated_copies(angles,image.x_origin,image.y_origin);
+				for(std::size_t i = 0; i < job.images.size(); ++i)
+					job.results.push_back(encode_image(*job.images[i],*copies[i].p_image,copies[i].x_origin,copies[i].y_origin));
+			}
+		}
+		else if(job.p_tile != nullptr)
+		{
+			const auto & tileset	= *job.p_tileset;
+			const auto & tile			= *job.p_tile;
 
-				auto imgdata = p_image->create_sub_target_data(0,0,tileset.tile_width,tileset.tile_height,tileset.pixel_format,config.b_big_endian);
+			auto p_image = assets.get_source_subimage(tile.source_image,tile.x,tile.y,tileset.tile_width,tileset.tile_height);
+			if(p_image == nullptr)
+			{
+				gap::logger::error("TSET: Source image {} of a tile in tileset '{}' is not available!",tile.source_image,tileset.name);
+				++errors;
+				return;
+			}
 
-	//					auto imgdata = assets.get_target_subimage(tile.source_image,tile.x,tile.y,tileset.tile_width,tileset.tile_height,tileset.pixel_format,config.b_big_endian);
-	//			std::cout << std::format("  TILE: x:{} y:{} dim:{}x{}, datasize:{}\n",tile.x,tile.y,p_image->width(),p_image->height(),imgdata.size());
-				data.insert(end(data),begin(imgdata),end(imgdata));
+			switch(tile.transform & 0x03)
+			{
+				case gap::tileset::ROTATE_90 	: p_image->rotate_90(); break;
+				case gap::tileset::ROTATE_180	: p_image->rotate_180(); break;
+				case gap::tileset::ROTATE_270	: p_image->rotate_270(); break;
 			}
+			if(tile.transform & gap::tileset::FLIP_HORZ)	p_image->horizontal_flip();
+			if(tile.transform & gap::tileset::FLIP_VERT)	p_image->vertical_flip();
 
-			auto sz = (data.size() + 3) & ~3;
-			if(sz > data.size())
-				data.resize(sz);
+			auto encode = tileset.encode;
+			encode.b_high_quality |= config.b_high_quality_compression;
+			set_palette(tileset.colour_map, encode);
+
+			job.tile_data = p_image->create_sub_target_data(0,0,tileset.tile_width,tileset.tile_height,tileset.pixel_format,config.b_big_endian,encode);
+		}
+	};
 
+	//-----------------------------------------------------------------------
+	//	Placement. The atlas pages follow the images and the tilesets follow
+	//	the atlas pages. Each tileset is padded to a 4 byte boundary.
+	//-----------------------------------------------------------------------
+	bool b_images_finished = false;
+
+	auto finish_images = [&]
+	{
+		b_images_finished = true;
+
+		if(shared_image_count > 0)
+			gap::logger::verbose("IMGD: {} images share the data of an identical image", shared_image_count);
+
+		if(rle_raw_bytes > 0)
+			gap::logger::info("IMGD: RLE images {} bytes, {} bytes as raw images ({}%)", rle_bytes, rle_raw_bytes, (rle_bytes * 100) / rle_raw_bytes);
+
+		if(!atlas_images.empty())
+		{
+			append_atlas_pages(data, chunk_offset+8, atlas_images, images, atlas);
 			image_offset = data.size() - (chunk_offset+8);
+		}
+	};
 
-			return true;
-		});
+	auto finish_tileset = [&]
+	{
+		auto sz = (data.size() + 3) & ~3;
+		if(sz > data.size())
+			data.resize(sz);
+
+		image_offset = data.size() - (chunk_offset+8);
+	};
+
+	auto place_job = [&](EncodeJob & job)
+	{
+		for(auto & result : job.results)
+			place_image(std::move(result));
+
+		if(job.p_tileset == nullptr)
+			return;
+
+		if(job.p_tile != nullptr)
+		{
+			data.insert(end(data),begin(job.tile_data),end(job.tile_data));
+			return;
+		}
+
+		const auto & tileset = *job.p_tileset;
+		if(!tilesets.empty())
+			finish_tileset();
+
+		TSETChunkEntry tset;
+		tset.width							= tileset.tile_width;
+		tset.height							= tileset.tile_height;
+		tset.pixel_format				= tileset.pixel_format;
+		tset.tile_count					= tileset.tiles.size();
+		tset.id									= tileset.id;
+		tset.image_data_offset 	= image_offset;
 
+		gap::logger::verbose("GBIN:TILESET: id={}, name={}, tilesize = {}x{}, {} tiles",tileset.id,tileset.name,tileset.tile_width,tileset.tile_height,tileset.tiles.size());
+
+		gap::image::EncodeOptions encode;
+		tset.palette = palette_index(set_palette(tileset.colour_map, encode), tileset.name);
+
+		tilesets.push_back(tset);
+	};
+
+	//-----------------------------------------------------------------------
+	//	Run
+	//-----------------------------------------------------------------------
+	const bool b_release = assets.release_source_images();
+
+	std::vector<std::size_t> order(jobs.size());
+	for(std::size_t i=0; i<order.size(); ++i)
+		order[i] = i;
+	if(b_release)
+		std::stable_sort(begin(order), end(order), [&](std::size_t a, std::size_t b) {return jobs[a].source < jobs[b].source;});
+
+	auto consumers = assets.source_image_consumers();
+	std::size_t next_place = 0;
+
+	for(auto i : order)
+	{
+		auto & job = jobs[i];
+		run_job(job);
+		job.b_done = true;
+
+		if(b_release && (job.source >= 0) && std::cmp_less(job.source, consumers.size()))
+		{
+			consumers[job.source] -= job.images.empty() ? 1 : int(job.images.size());
+			if(consumers[job.source] <= 0)
+			{
+				gap::logger::verbose("IMGD: Releasing source image {}", job.source);
+				assets.release_source_image(job.source);
+			}
+		}
+
+		for(; (next_place < jobs.size()) && jobs[next_place].b_done; ++next_place)
+		{
+			if((next_place == image_job_count) && !b_images_finished)
+				finish_images();
+			place_job(jobs[next_place]);
+			jobs[next_place] = EncodeJob();
+		}
+	}
+
+	if(!b_images_finished)
+		finish_images();
+
+	if(!tilesets.empty())
+		finish_tileset();
 
 	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
@@ -329,7 +762,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 	//---------------------------------------------------------------------------
 	if(!images.empty())
 	{
-		std::cout << "Encoding Chunk IMAG: " << images.size() << " images\n";
+		gap::logger::verbose("Encoding Chunk IMAG: {} images", images.size());
 
 		chunk_offset = data.size();
 		fourcc_append("IMAG",data);
@@ -343,7 +776,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 			endian_append(data,	image.height,		2,	config.b_big_endian);
 			endian_append(data,	image.x_origin,	2,	config.b_big_endian);
 			endian_append(data,	image.y_origin,	2,	config.b_big_endian);
-			endian_append(data,	0,							2,	config.b_big_endian);
+			endian_append(data,	image.line_offset,	2,	config.b_big_endian);
 			data.push_back(image.pixel_format);
 			data.push_back(image.palette);
 			endian_append(data,image.image_data_offset,4,config.b_big_endian);
@@ -355,7 +788,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 	//---------------------------------------------------------------------------
 	//	Image Groups [IGRP]
 	//---------------------------------------------------------------------------
-	std::cout << "Encoding Chunk IGRP\n";
+	gap::logger::verbose("Encoding Chunk IGRP");
 
 	chunk_offset = data.size();
 	fourcc_append("IGRP",data);
@@ -384,7 +817,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 	if(assets.image_sequence_count() > 0)
 	{
 		// ----- Encode the IFRMs first and keep a record of the frame indices -----
-		std::cout << "Encoding Chunk IFRM\n";
+		gap::logger::verbose("Encoding Chunk IFRM");
 
 		std::vector<uint32_t> frames;
 		uint32_t frame_index = 0;
@@ -395,7 +828,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 
 		assets.enumerate_image_sequences([&]([[maybe_unused]] uint32_t id, const gap::assets::ImageSequence & imgseq)->bool
 			{
-				std::cout << std::format("  ISEQ: {:3} : {} COUNT: {}\n", id, imgseq.name, imgseq.frames.size());
+				gap::logger::verbose("  ISEQ: {:3} : {} COUNT: {}", id, imgseq.name, imgseq.frames.size());
 
 				frames.push_back(frame_index);
 				frame_index += imgseq.frames.size();
@@ -407,7 +840,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 					data.push_back(frame.x);
 					data.push_back(frame.y);
 					data.push_back(0);
-					std::cout << std::format("    FRAME: group:{} image:{}\n", frame.group, frame.image );
+					gap::logger::trace("    FRAME: group:{} image:{}", frame.group, frame.image );
 				}
 
 				return true;
@@ -415,7 +848,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 		endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
 		// ----- Encode the ISEQs using the fram indices that we saved earlier -----
-		std::cout << "Encoding Chunk ISEQ\n";
+		gap::logger::verbose("Encoding Chunk ISEQ");
 		frame_index = 0;
 
 		chunk_offset = data.size();
@@ -436,7 +869,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 		/*
 		assets.enumerate_image_sequences([&](uint32_t id, const gap::assets::ImageSequence & imgseq)->bool
 			{
-				std::cout << std::format("  ISEQ: {:3} : {} COUNT: {}\n", id, imgseq.name, imgseq.frames.size());
+				gap::logger::verbose("  ISEQ: {:3} : {} COUNT: {}", id, imgseq.name, imgseq.frames.size());
 
 				chunk_offset = data.size();
 				data.reserve(chunk_offset + 4 + (8 * imgseq.frames.size()));
@@ -457,7 +890,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 					data.push_back(frame.y);
 					data.push_back(0);
 
-					std::cout << std::format("    FRAME: group:{} image:{}\n", frame.group, frame.image );
+					gap::logger::trace("    FRAME: group:{} image:{}", frame.group, frame.image );
 				}
 
 				endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
@@ -491,6 +924,7 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 		endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 	}
 
+	return errors;
 }
 
 
@@ -500,7 +934,6 @@ encode_packed_image_chunks(std::vector<std::uint8_t> & data,const gap::assets::A
 //
 //=============================================================================
 
-static
 int
 encode_colourmap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config)
 {
@@ -510,44 +943,81 @@ encode_colourmap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Asse
 	//---------------------------------------------------------------------------
 	//	COLR Chunk
 	//---------------------------------------------------------------------------
-	std::cout << "Encoding COLR Chunk...\n";
+	gap::logger::verbose("Encoding COLR Chunk...");
 
 	auto chunk_offset = data.size();
 	fourcc_append("COLR",data);
 	fourcc_append("size",data);	
 
-	std::vector<uint32_t> cmap_indices;
-	
+	// Colour maps that are identical to, or the start of, a colour map that has
+	// already been stored share its colours. The largest maps are stored first
+	// and every prefix of them is registered.
+	std::vector<const gap::assets::ColourMap *> cmaps;
 	assets.enumerate_colourmaps([&](const gap::assets::ColourMap & cmap)->bool
 		{
-			cmap_indices.push_back(data.size() - chunk_offset - 8);
-			data.reserve(data.size()+(cmap.colourmap.size()*4));
-
-			for(uint32_t colour : cmap.colourmap)
-			{
-				for(int i=0;i<4;++i,colour >>= 8)
-					data.push_back(colour & 0x0FF);
-			}
+			cmaps.push_back(&cmap);
 			return true;
 		});
+
+	std::vector<std::size_t> order(cmaps.size());
+	for(std::size_t i=0; i<order.size(); ++i)
+		order[i] = i;
+	std::stable_sort(begin(order), end(order), [&](std::size_t a, std::size_t b) {return cmaps[a]->colourmap.size() > cmaps[b]->colourmap.size();});
+
+	gap::DataDedupe colour_dedupe;
+	std::vector<uint32_t> cmap_indices(cmaps.size());
+	std::vector<uint8_t> colours;
+	int shared_count = 0;
+
+	for(auto i : order)
+	{
+		colours.clear();
+		for(uint32_t colour : cmaps[i]->colourmap)
+		{
+			for(int c=0;c<4;++c,colour >>= 8)
+				colours.push_back(colour & 0x0FF);
+		}
+
+		const std::span<const uint8_t> chunk_data(data.data() + chunk_offset + 8, data.size() - (chunk_offset + 8));
+		if(auto offset = colour_dedupe.find(chunk_data,colours))
+		{
+			cmap_indices[i] = *offset;
+			++shared_count;
+			continue;
+		}
+
+		cmap_indices[i] = chunk_data.size();
+		data.insert(data.end(), begin(colours), end(colours));
+		for(std::size_t size = 4; size <= colours.size(); size += 4)
+			colour_dedupe.add(std::span<const uint8_t>(colours.data(), size), cmap_indices[i]);
+	}
+
+	if(shared_count > 0)
+		gap::logger::verbose("COLR: {} of {} colour maps share colours with another map",shared_count,cmaps.size());
+
+	const auto colr_size = data.size() - (chunk_offset + 8);
+	if(colr_size > 0x10000U)
+	{
+		gap::logger::error("COLR: {} bytes of colours is too large for the 16 bit CMAP index!",colr_size);
+		return 1;
+	}
+
 	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
 	//---------------------------------------------------------------------------
 	//	CMAP Chunk
 	//---------------------------------------------------------------------------
-	std::cout << "Encoding CMAP Chunk...\n";
+	gap::logger::verbose("Encoding CMAP Chunk...");
 
 	chunk_offset = data.size();
 	fourcc_append("CMAP",data);
 	fourcc_append("size",data);	
 
-	uint32_t index = 0;
-	assets.enumerate_colourmaps([&](const gap::assets::ColourMap & cmap)->bool
-		{
-			endian_append(data,cmap.colourmap.size(),2,config.b_big_endian);
-			endian_append(data,cmap_indices[index++],2,config.b_big_endian);
-			return true;
-		});
+	for(std::size_t i=0; i<cmaps.size(); ++i)
+	{
+		endian_append(data,cmaps[i]->colourmap.size(),2,config.b_big_endian);
+		endian_append(data,cmap_indices[i],2,config.b_big_endian);
+	}
 	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
 	/*
@@ -588,14 +1058,13 @@ encode_colourmap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Asse
 // 	uint8_t				name[16];
 // };
 
-static
 int
 encode_file_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config)
 {
 	if(assets.file_count() == 0)
 		return 0;
 
-	std::cout << "Encoding FILE Chunks...\n";
+	gap::logger::verbose("Encoding FILE Chunks...");
 
 	//---------------------------------------------------------------------------
 	//	FDAT Chunk
@@ -609,7 +1078,7 @@ encode_file_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets &
 
 	assets.enumerate_files([&](const gap::assets::FileInfo & fileinfo)->bool
 		{
-			std::println("Encoding File - '{}' as '{}' size: {}", fileinfo.source_path, fileinfo.name, fileinfo.data.size());
+			gap::logger::verbose("Encoding File - '{}' as '{}' size: {}", fileinfo.source_path, fileinfo.name, fileinfo.data.size());
 			fdat_indices.push_back(data.size()-chunk_offset-8);
 			data.insert(end(data),begin(fileinfo.data),end(fileinfo.data));
 
@@ -712,17 +1181,32 @@ $10 |            INDEX OFFSET           |    Offset into the TMIX chunk
 $14 |            BLOCK COUNT            |
     +-----------------------------------+
 $14 |            BLOCK OFFSET           |    Offset into the TMBL chunk 
-    +--------+--------+-----------------+
-$18 | BSIZE  | TSIZE  |      ---        |
-    +--------+--------+-----------------+
+    +--------+--------+--------+--------+
+$18 | BSIZE  | TSIZE  | LAYERS | LAYOUT |
+    +--------+--------+--------+--------+
 
 WIDTH   - Width of tilemap in tiles.
 HEIGHT  - Width of tilemap in tiles.
 BSIZE 	-	Block Size in tiles. Block volume = BSIZE * BSIZE
 TSIZE   - Tile Size in bytes.
+LAYERS  - Number of layers. (0 in files from older versions, which is 1 layer)
+LAYOUT  - Order of the blocks and of the tiles within each block.
+            0 = Row major
+            1 = Morton (Z-order)
+            2 = Hilbert curve
 
 Block Size in bytes = BSIZE * BSIZE * TSIZE
 
+The indices of all of the layers of a block are stored together, so the index
+of layer L of block (BX,BY) is at ((BY * BLOCKS WIDE) + BX) * LAYERS + L. The
+layers share the blocks and identical blocks are only stored once.
+
+The indices are always in row major order. The LAYOUT is the order in which
+the blocks are numbered, following the curve over the blocks of the map, and
+the order of the tiles in each block. Morton and Hilbert curves are followed
+over the smallest power of 2 square that covers the blocks, or the block,
+skipping the positions that are outside of it.
+
 
 
 TMIX Chunk - Sparse Tile Map Index Data
@@ -756,16 +1240,70 @@ $08 | BLOCKS ....                       |    Block data for all tilemaps.
     :                 :                 :    The TMAP chunk contains an index into this data.
     +-----------------------------------+
 
+TMBF Chunk - Tile Map Block Flags
+---------------------------------
+
+Only written if a tilemap has tile flags (see TMFL). One entry for each tilemap with flags.
+
+          -------------------->
+        0        1        2        3
+    +--------+--------+--------+--------+
+$00 |   T    |   M    |   B    |   F    |    FourCC defines chunk type - 4 Bytes
+    +--------+--------+--------+--------+
+$04 |               SIZE                |    Chunk Size - 4 Bytes
+    +===================================+
+$08 |            TILEMAP ID             |
+    +-----------------------------------+
+$0C |            BLOCK COUNT            |
+    +--------+--------------------------+
+$10 | FSIZE  |           ---            |
+    +--------+--------------------------+
+$14 | ALL, ANY ....                     |    Two FSIZE values for each block, in block order.
+    :                 :                 :    Rounded up to a multiple of 4 bytes.
+    +-----------------------------------+
+
+ALL     - The flags that are set in every tile of the block.
+ANY     - The flags that are set in at least one tile of the block.
+
+A physics query can skip a block whose ANY does not have the flag it is looking for, or treat the whole block as
+solid if its ALL does. Empty blocks ($FFFE) are all tile 0.
+
+
+TMFL Chunk - Tile Map Tile Flags
+--------------------------------
+
+Only written if a tilemap has tile flags. One entry for each tilemap with flags.
+
+          -------------------->
+        0        1        2        3
+    +--------+--------+--------+--------+
+$00 |   T    |   M    |   F    |   L    |    FourCC defines chunk type - 4 Bytes
+    +--------+--------+--------+--------+
+$04 |               SIZE                |    Chunk Size - 4 Bytes
+    +===================================+
+$08 |            TILEMAP ID             |
+    +-----------------------------------+
+$0C |            TILE COUNT             |
+    +--------+--------+-----------------+
+$10 | FSIZE  | FCOUNT |      ---        |
+    +--------+--------+-----------------+
+$14 | FLAGS ....                        |    FSIZE bytes for each tile value from 0 to TILE COUNT - 1.
+    :                 :                 :    Rounded up to a multiple of 4 bytes.
+    +-----------------------------------+
+
+FSIZE   - Size of the flags of a tile in bytes (1, 2 or 4).
+FCOUNT  - Number of flags. Bit N is the Nth name of the FLAGS list of the TILEMAP command. Tiles with values of
+          TILE COUNT or more have no flags.
+
 */
 
-static
 int
 encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config)
 {
 	if(assets.tilemap_count() == 0)
 		return 0;
 
-	std::cout << "Encoding TileMap Chunks...\n";
+	gap::logger::verbose("Encoding TileMap Chunks...");
 
 	std::vector<uint32_t>	index_offsets;
 	std::vector<uint32_t>	block_offsets;
@@ -815,8 +1353,19 @@ encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets
 			data.reserve(block_data.size() * tilesize);
 
 			// ----- Write the block data -----
-			for(uint64_t value : block_data)
-				endian_append(data,value,tilesize,config.b_big_endian);
+			if(tilemap.layout() == gap::tilemap::LAYOUT_ROW_MAJOR)
+			{
+				for(uint64_t value : block_data)
+					endian_append(data,value,tilesize,config.b_big_endian);
+			}
+			else
+			{
+				// The tiles of each block are written in layout order.
+				const auto order 	= gap::tilemap::layout_order(tilemap.layout(), tilemap.block_size(), tilemap.block_size());
+				for(std::size_t block=0; block<block_data.size(); block+=order.size())
+					for(auto position : order)
+						endian_append(data,block_data[block+position],tilesize,config.b_big_endian);
+			}
 
 			// ----- Align to 4-byte boundary -----
 			auto sz = (data.size() + 3) & ~3;
@@ -827,6 +1376,44 @@ encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets
 		});
 	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
+	//---------------------------------------------------------------------------
+	// Encode TMBF TileMap Block Flags Chunk
+	//---------------------------------------------------------------------------
+	bool b_flags = false;
+	assets.enumerate_tilemaps([&](const gap::tilemap::TileMap & tilemap) {b_flags |= !tilemap.flag_names().empty(); return !b_flags;});
+
+	if(b_flags)
+	{
+		chunk_offset = data.size();
+		fourcc_append("TMBF",data);
+		fourcc_append("size",data);
+
+		assets.enumerate_tilemaps([&](const gap::tilemap::TileMap & tilemap)->bool
+			{
+				if(tilemap.flag_names().empty())
+					return true;
+
+				const auto blocks = tilemap.block_flags();
+				const auto fsize	= tilemap.flag_size();
+
+				endian_append(data,tilemap.id(),4,config.b_big_endian);
+				endian_append(data,blocks.size(),4,config.b_big_endian);
+				endian_append(data,fsize,1,config.b_big_endian);
+				endian_append(data,0U,3,config.b_big_endian);
+
+				for(const auto & block : blocks)
+				{
+					endian_append(data,block.all,fsize,config.b_big_endian);
+					endian_append(data,block.any,fsize,config.b_big_endian);
+				}
+
+				// ----- Align to 4-byte boundary -----
+				data.resize((data.size() + 3) & ~3);
+				return true;
+			});
+		endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
+	}
+
 	//---------------------------------------------------------------------------
 	// Encode TMAP TileMap Chunk
 	//---------------------------------------------------------------------------
@@ -858,13 +1445,47 @@ encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets
 			// ----- Block and Tile sizes
 			endian_append(data,tilemap.block_size(),1,config.b_big_endian);
 			endian_append(data,tilesize,1,config.b_big_endian);
-			endian_append(data,0U,2,config.b_big_endian);
+			endian_append(data,tilemap.layer_count(),1,config.b_big_endian);
+			endian_append(data,tilemap.layout(),1,config.b_big_endian);
 
 			++index;
 			return true;
 		});
 	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
 
+	//---------------------------------------------------------------------------
+	// Encode TMFL TileMap Tile Flags Chunk
+	//---------------------------------------------------------------------------
+	if(b_flags)
+	{
+		chunk_offset = data.size();
+		fourcc_append("TMFL",data);
+		fourcc_append("size",data);
+
+		assets.enumerate_tilemaps([&](const gap::tilemap::TileMap & tilemap)->bool
+			{
+				if(tilemap.flag_names().empty())
+					return true;
+
+				const auto flags	= tilemap.tile_flags();
+				const auto fsize	= tilemap.flag_size();
+
+				endian_append(data,tilemap.id(),4,config.b_big_endian);
+				endian_append(data,flags.size(),4,config.b_big_endian);
+				endian_append(data,fsize,1,config.b_big_endian);
+				endian_append(data,tilemap.flag_names().size(),1,config.b_big_endian);
+				endian_append(data,0U,2,config.b_big_endian);
+
+				for(uint32_t tile_flags : flags)
+					endian_append(data,tile_flags,fsize,config.b_big_endian);
+
+				// ----- Align to 4-byte boundary -----
+				data.resize((data.size() + 3) & ~3);
+				return true;
+			});
+		endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
+	}
+
 
 	/*
 	assets.enumerate_tilemaps([&](const gap::tilemap::TileMap & tilemap)->bool
@@ -913,8 +1534,111 @@ encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets
 }
 
 
+//=============================================================================
+//
+//	SOUND SAMPLE CHUNKS
+//
+//=============================================================================
+/*
+SWAV Chunk - Sound Sample Waveform Info
+---------------------------------------
+
+One entry for each sound sample, in the order of the SOUNDSAMPLE commands.
+
+          -------------------->
+        0        1        2        3
+    +--------+--------+--------+--------+
+$00 |   S    |   W    |   A    |   V    |    FourCC defines chunk type - 4 Bytes
+    +--------+--------+--------+--------+
+$04 |               SIZE                |    Chunk Size - 4 Bytes
+    +===================================+
+$08 |   SAMPLE RATE   | FORMAT |  COMP  |
+    +-----------------+--------+--------+
+$0C |           SAMPLE COUNT            |
+    +-----------------+-----------------+
+$10 |        SAMPLE DATA OFFSET         |    Offset into the WAVD chunk
+    +=================+=================+
+
+WAVD Chunk - Sound Sample Waveform Data
+---------------------------------------
+
+          -------------------->
+        0        1        2        3
+    +--------+--------+--------+--------+
+$00 |   W    |   A    |   V    |   D    |    FourCC defines chunk type - 4 Bytes
+    +--------+--------+--------+--------+
+$04 |               SIZE                |    Chunk Size - 4 Bytes
+    +===================================+
+$08 | SAMPLES ....                      |    The samples of each sound sample, each starting on a
+    :                 :                 :    4 byte boundary. 16 bit samples are in the byte order
+    +-----------------------------------+    of the file.
+*/
+
+int
+encode_sound_sample_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config)
+{
+	if(assets.sound_sample_count() == 0)
+		return 0;
+
+	gap::logger::verbose("Encoding Sound Sample Chunks...");
+
+	//---------------------------------------------------------------------------
+	//	SWAV Chunk
+	//---------------------------------------------------------------------------
+	auto chunk_offset = data.size();
+	fourcc_append("SWAV",data);
+	fourcc_append("size",data);
+
+	std::size_t wavd_size = 0;
+	assets.enumerate_sound_samples([&](const gap::sound::SoundSample & sample)->bool
+		{
+			endian_append(data,sample.sample_rate(),2,config.b_big_endian);
+			data.push_back(sample.format());
+			data.push_back(sample.compression());
+			endian_append(data,std::uint32_t(sample.sample_count()),4,config.b_big_endian);
+			endian_append(data,std::uint32_t(wavd_size),4,config.b_big_endian);
+
+			wavd_size += (sample.data().size() + 3) & ~std::size_t(3);
+			return true;
+		});
+	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
+
+	if(wavd_size > UINT32_MAX)
+	{
+		gap::logger::error("WAVD: {} bytes of sound samples is too large for a chunk!",wavd_size);
+		return 1;
+	}
+
+	//---------------------------------------------------------------------------
+	//	WAVD Chunk
+	//---------------------------------------------------------------------------
+	chunk_offset = data.size();
+	fourcc_append("WAVD",data);
+	fourcc_append("size",data);
+	data.reserve(data.size() + wavd_size);
+
+	assets.enumerate_sound_samples([&](const gap::sound::SoundSample & sample)->bool
+		{
+			const auto & samples	= sample.data();
+			const auto offset			= data.size();
+			data.insert(data.end(), samples.begin(), samples.end());
+
+			// ----- Sound samples hold 16 bit samples little endian. -----
+			if(config.b_big_endian && (gap::sound::format_size(sample.format()) == 2))
+				for(std::size_t i=offset; (i + 1) < data.size(); i += 2)
+					std::swap(data[i], data[i+1]);
+
+			data.resize((data.size() + 3) & ~std::size_t(3));
+			return true;
+		});
+	endian_insert(data,std::uint32_t(data.size()-(chunk_offset+8)),chunk_offset+4,4,config.b_big_endian);
+
+	return 0;
+}
+
+
 std::vector<std::uint8_t>
-encode_gbin(std::string_view name, const gap::assets::Assets & assets,const gap::Configuration & config)
+encode_gbin(std::string_view name, gap::assets::Assets & assets,const gap::Configuration & config)
 {
 
 	std::vector<std::uint8_t> data;
@@ -922,8 +1646,9 @@ encode_gbin(std::string_view name, const gap::assets::Assets & assets,const gap:
 
 	encode_header(data,name,assets,config);
 	//encode_image_chunks(data,assets,config);
-	encode_packed_image_chunks(data,assets,config);
+	errors += encode_packed_image_chunks(data,assets,config);
 	errors += encode_tilemap_chunks(data,assets,config);
+	errors += encode_sound_sample_chunks(data,assets,config);
 	errors += encode_colourmap_chunks(data,assets,config);
 	errors += encode_file_chunks(data,assets,config);
 
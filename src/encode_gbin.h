@@ -19,7 +19,14 @@
 namespace gap
 {
 
-std::vector<std::uint8_t>		encode_gbin(std::string_view name, const gap::assets::Assets & assets,const gap::Configuration & config);
+std::vector<std::uint8_t>		encode_gbin(std::string_view name, gap::assets::Assets & assets,const gap::Configuration & config);
+
+// ----- Individual chunk encoders. Each appends its chunks to 'data'. -----
+int													encode_packed_image_chunks(std::vector<std::uint8_t> & data,gap::assets::Assets & assets,const gap::Configuration & config);
+int													encode_colourmap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config);
+int													encode_file_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config);
+int													encode_tilemap_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config);
+int													encode_sound_sample_chunks(std::vector<std::uint8_t> & data,const gap::assets::Assets & assets,const gap::Configuration & config);
 
 } // namespace gap
 
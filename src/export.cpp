@@ -12,6 +12,7 @@
 #include "encode_definitions.h"
 #include "encode_gbin.h"
 #include "export.h"
+#include "logger.h"
 #include <utility/hexdump.h>
 #include <filesystem>
 #include <format>
@@ -31,11 +32,11 @@ export_assets(gap::assets::Assets & assets,const gap::exporter::ExportInfo & exp
 		case gap::exporter::TYPE_GBIN :						blob = gap::encode_gbin(exportinfo.name,assets,config); break;
 		case gap::exporter::TYPE_DEFINITIONS :		blob = gap::encode_definitions(exportinfo,assets,config); break;
 		default :
-			std::cerr << "Unknown or unsupported export type! (" << exportinfo.filename << ')' << std::endl;
+			gap::logger::error("Unknown or unsupported export type! ({})", exportinfo.filename);
 			return -1;
 	} 
 
-	std::cout << "=============================================================================\n\n"; 
+	gap::logger::info("=============================================================================\n");
 	// std::cout << ade::hexdump(blob.data(),blob.size());
 
 
@@ -46,7 +47,7 @@ export_assets(gap::assets::Assets & assets,const gap::exporter::ExportInfo & exp
 				std::ofstream outfile(config.output_prefix + exportinfo.filename,std::ios_base::binary | std::ios_base::out);
 				if(outfile.fail())
 				{
-					std::cerr << "Failed to create output file " << exportinfo.filename << std::endl;
+					gap::logger::error("Failed to create output file {}", exportinfo.filename);
 					return -1;
 				}
 				outfile.write((const char *)blob.data(),blob.size());
@@ -58,7 +59,7 @@ export_assets(gap::assets::Assets & assets,const gap::exporter::ExportInfo & exp
 				std::ofstream outfile(config.output_prefix + exportinfo.filename,std::ios_base::binary | std::ios_base::out);
 				if(outfile.fail())
 				{
-					std::cerr << "Failed to create output file " << (config.output_prefix + exportinfo.filename) << std::endl;
+					gap::logger::error("Failed to create output file {}", config.output_prefix + exportinfo.filename);
 					return -1;
 				}
 
@@ -97,7 +98,7 @@ export_assets(gap::assets::Assets & assets,const gap::exporter::ExportInfo & exp
 				std::ofstream outfile(config.output_prefix + exportinfo.filename,std::ios_base::binary | std::ios_base::out);
 				if(outfile.fail())
 				{
-					std::cerr << "Failed to create output file " << exportinfo.filename << std::endl;
+					gap::logger::error("Failed to create output file {}", exportinfo.filename);
 					return -1;
 				}
 				outfile << "//=============================================================================\n";
@@ -112,7 +113,7 @@ export_assets(gap::assets::Assets & assets,const gap::exporter::ExportInfo & exp
 			break;
 
 		default :
-			std::cerr << "Unknown or unsupported export format! (" << exportinfo.filename << ')' << std::endl;
+			gap::logger::error("Unknown or unsupported export format! ({})", exportinfo.filename);
 			return -1;
 	}
 
@@ -11,6 +11,9 @@
 #ifndef GUARD_ADE_GAMES_ASSET_PACKER_FILESYSTEM_H
 #define GUARD_ADE_GAMES_ASSET_PACKER_FILESYSTEM_H
 
+#include <algorithm>
+#include <functional>
+#include <span>
 #include "configuration.h"
 #include "adefs/adefs.h"
 #include "utility/loadfile.h"
@@ -38,6 +41,20 @@ public:
 																return data;
 															}	
 
+	// Pass the file to 'callback' in pieces of up to 'chunk_size' bytes. A file
+	// on the systems filesystem is read a piece at a time rather than loaded.
+	bool												stream( const std::string & filename, std::size_t chunk_size, const std::function<bool(std::span<std::uint8_t>)> & callback )
+															{
+																auto data = m_adefs.load(filename);
+																if(data.empty() || (chunk_size == 0))
+																	return ade::readfile(filename, chunk_size, callback);
+
+																for(std::size_t offset=0; offset<data.size(); offset+=chunk_size)
+																	if(!callback(std::span<std::uint8_t>(data).subspan(offset, std::min(chunk_size, data.size() - offset))))
+																		return false;
+																return true;
+															}
+
 };
 
 
@@ -8,10 +8,21 @@
 //	MAINTAINER:			AJP - Adrian Purser <ade@arcadestuff.com>
 //	CREATED:				25-SEP-2019 Adrian Purser <ade@arcadestuff.com>
 //=============================================================================
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "image.h"
+#include "image_transform.h"
+#include "image_dither.h"
+#include "image_rle.h"
+#include "image_compress.h"
 #include "adepng/adepng.h"
+#include "logger.h"
 
 namespace gap::image
 {
@@ -19,6 +30,10 @@ namespace gap::image
 std::uint8_t
 parse_pixelformat_name(const std::string & name)
 {
+	// ----- Run length encoded formats are named RLE-<base format> -----
+	if((name.size() > 4) && (ade::hash::hash_ascii_string_as_lower(name.c_str(),4) == ade::hash::hash_ascii_string_as_lower("rle-")))
+		return gap::image::pixelformat::RLE | parse_pixelformat_name(name.substr(4));
+
 	auto hash = ade::hash::hash_ascii_string_as_lower(name.c_str(),name.size());
 	std::uint8_t pf = 0;
 
@@ -36,15 +51,41 @@ parse_pixelformat_name(const std::string & name)
 		case ade::hash::hash_ascii_string_as_lower("A8") 				:	pf = gap::image::pixelformat::A8; 			break;
 		case ade::hash::hash_ascii_string_as_lower("A4") 				:	pf = gap::image::pixelformat::A4; 			break;
 		case ade::hash::hash_ascii_string_as_lower("I8") 				:	pf = gap::image::pixelformat::I8; 			break;
+		case ade::hash::hash_ascii_string_as_lower("I4") 				:	pf = gap::image::pixelformat::I4; 			break;
+		case ade::hash::hash_ascii_string_as_lower("BC1") 			:
+		case ade::hash::hash_ascii_string_as_lower("DXT1") 			:	pf = gap::image::pixelformat::BC1; 			break;
+		case ade::hash::hash_ascii_string_as_lower("BC3") 			:
+		case ade::hash::hash_ascii_string_as_lower("DXT5") 			:	pf = gap::image::pixelformat::BC3; 			break;
+		case ade::hash::hash_ascii_string_as_lower("ETC1") 			:	pf = gap::image::pixelformat::ETC1; 		break;
+		case ade::hash::hash_ascii_string_as_lower("ETC2") 			:	pf = gap::image::pixelformat::ETC2; 		break;
+		case ade::hash::hash_ascii_string_as_lower("ETC2_RGBA") :	pf = gap::image::pixelformat::ETC2_RGBA; break;
 		default : break;
 	}
 
 	return pf;
 }
 
+std::uint8_t
+parse_dither_name(const std::string & name)
+{
+	switch(ade::hash::hash_ascii_string_as_lower(name.c_str(),name.size()))
+	{
+		case ade::hash::hash_ascii_string_as_lower("ordered")					:
+		case ade::hash::hash_ascii_string_as_lower("bayer")						:	return DITHER_ORDERED;
+		case ade::hash::hash_ascii_string_as_lower("diffusion")				:
+		case ade::hash::hash_ascii_string_as_lower("fs")							:
+		case ade::hash::hash_ascii_string_as_lower("floyd-steinberg")	:	return DITHER_DIFFUSION;
+		default : break;
+	}
+	return DITHER_NONE;
+}
+
 std::string
 get_pixelformat_name(std::uint8_t pixelformat)
 {
+	if(gap::image::pixelformat::is_rle(pixelformat))
+		return "RLE-" + get_pixelformat_name(gap::image::pixelformat::base_format(pixelformat));
+
 	switch(pixelformat)
 	{
 		case gap::image::pixelformat::ARGB8888 	:	return("ARGB8888");
@@ -59,10 +100,53 @@ get_pixelformat_name(std::uint8_t pixelformat)
 		case gap::image::pixelformat::A8				:	return("A8");
 		case gap::image::pixelformat::A4				:	return("A4");
 		case gap::image::pixelformat::I8				:	return("I8");
+		case gap::image::pixelformat::BC1				:	return("BC1");
+		case gap::image::pixelformat::BC3				:	return("BC3");
+		case gap::image::pixelformat::ETC1			:	return("ETC1");
+		case gap::image::pixelformat::ETC2			:	return("ETC2");
+		case gap::image::pixelformat::ETC2_RGBA	:	return("ETC2_RGBA");
+		case gap::image::pixelformat::I4				:	return("I4");
 	}
 	return std::string();
 }
 
+int
+Palette::nearest_colour(std::uint32_t colour) const
+{
+	if((colour & 0xFF000000U) == 0)
+		colour = 0;
+
+	if(!m_lookup.empty())
+	{
+		auto it = m_lookup.find(colour);
+		if(it != m_lookup.end())
+			return it->second;
+	}
+
+	int				best_index		= 0;
+	uint32_t	best_distance	= std::numeric_limits<uint32_t>::max();
+
+	for(std::size_t i=0; i<m_palette.size(); ++i)
+	{
+		uint32_t distance = 0;
+		for(int shift=0; shift<32; shift+=8)
+		{
+			const int d = int((colour >> shift) & 0x0FF) - int((m_palette[i] >> shift) & 0x0FF);
+			distance += d * d;
+		}
+
+		if(distance < best_distance)
+		{
+			best_distance	= distance;
+			best_index		= i;
+			if(distance == 0)
+				break;
+		}
+	}
+
+	return best_index;
+}
+
 
 std::unique_ptr<SourceImage>
 load(const std::string & filename,gap::FileSystem & filesystem)
@@ -70,15 +154,20 @@ load(const std::string & filename,gap::FileSystem & filesystem)
 	auto file = filesystem.load(filename);
 	if(file.empty())
 	{
-		std::cerr << "LOADIMAGE: Failed to load image '" << filename << "'\n";
+		gap::logger::error("LOADIMAGE: Failed to load image '{}'", filename);
 		return nullptr;
 	}
 
+	return decode(file);
+}
 
+std::unique_ptr<SourceImage>
+decode(std::span<const std::uint8_t> file)
+{
 	adepng::PNGDecode decode;
 	if(decode.decode(file.data(),file.size(),4))
 	{
-		std::cerr << "IMAGE: Failed to decode image!\n";
+		gap::logger::error("IMAGE: Failed to decode image!");
 		return nullptr;
 	}
 
@@ -133,27 +222,113 @@ SourceImage::SourceImage(int width,int height,const std::uint8_t * p_data,int li
 
 
 std::vector<uint8_t>
-SourceImage::create_sub_target_data(int x, int y, int width, int height, uint8_t pixel_format, bool big_endian)
+SourceImage::create_sub_target_data(int x, int y, int width, int height, uint8_t pixel_format, bool big_endian, const EncodeOptions & options)
 {
 	std::vector<uint8_t>	data;
 
+	const uint8_t base_pf = gap::image::pixelformat::base_format(pixel_format);
+	const bool		b_indexed	= gap::image::pixelformat::is_indexed(base_pf);
+
+	if(	(gap::image::pixelformat::is_rle(pixel_format) && (b_indexed || (gap::image::pixelformat::bytes_per_pixel(base_pf) == 0))) )
+	{
+		gap::logger::error("create_sub_target_data: Unsupported Pixel Format!");
+		return data;
+	}
+
+	if(b_indexed && ((options.p_palette == nullptr) || options.p_palette->empty()))
+	{
+		gap::logger::error("create_sub_target_data: No colour map for indexed pixel format {}!", get_pixelformat_name(pixel_format));
+		return data;
+	}
+
+	if(b_indexed && (options.p_palette->size() > gap::image::pixelformat::palette_limit(base_pf)))
+	{
+		gap::logger::error(	"create_sub_target_data: Colour map has {} colours, pixel format {} can only use {}!",
+												options.p_palette->size(), get_pixelformat_name(pixel_format), gap::image::pixelformat::palette_limit(base_pf) );
+		return data;
+	}
+
+	//---------------------------------------------------------------------------
+	//	Source pixels. The region is copied if it needs processing before it is
+	//	encoded or if it extends outside of the image.
+	//---------------------------------------------------------------------------
+	const bool b_rle			= gap::image::pixelformat::is_rle(pixel_format);
+	const bool b_process	= options.b_premultiply || (options.dither != DITHER_NONE);
+	const bool b_inside		= (x >= 0) && (y >= 0) && ((x + width) <= m_width) && ((y + height) <= m_height);
+
+	std::vector<uint32_t>	region;
+	const uint32_t *			p_pixels	= b_inside ? get_pixel_address(x,y) : nullptr;
+	int										stride		= m_width;
+
+	if(b_process || !b_inside || b_rle)
+	{
+		region.reserve(std::size_t(width) * height);
+		for(int iy=0;iy<height;++iy)
+			for(int ix=0;ix<width;++ix)
+				region.push_back(get_pixel(x+ix,y+iy));
+
+		if(options.b_premultiply)
+			premultiply_alpha(region);
+		if(options.dither != DITHER_NONE)
+			dither(region, width, height, base_pf, options.dither);
+
+		p_pixels	= region.data();
+		stride		= width;
+	}
+
+	if(b_rle)
+		return rle_encode(region, width, height, pixel_format, big_endian);
+
+	// ----- Block formats are byte streams and are not affected by endianness. -----
+	if(gap::image::pixelformat::is_block_format(pixel_format))
+		return compress_blocks(p_pixels, stride, width, height, pixel_format, options.b_high_quality);
+
+	//---------------------------------------------------------------------------
+	//	Encode
+	//---------------------------------------------------------------------------
 	data.reserve(gap::image::pixelformat::image_data_size(pixel_format,width,height));
 	int bpp = gap::image::pixelformat::bytes_per_pixel(pixel_format);
 
+	// Indexed formats store the colour map index of the nearest colour. Each
+	// distinct colour is only searched for once.
+	std::unordered_map<uint32_t,uint32_t> nearest;
+
+	auto encode = [&](uint32_t colour) -> uint32_t
+	{
+		if(!b_indexed)
+			return gap::image::pixelformat::encode_pixel(colour,pixel_format);
+
+		auto [it, b_new] = nearest.try_emplace(colour, 0);
+		if(b_new)
+			it->second = options.p_palette->nearest_colour(colour);
+		return it->second;
+	};
+
 	switch(pixel_format)
 	{
+		// ----- Two pixels per byte, the first in the low nibble. -----
 		case gap::image::pixelformat::L4 :
 		case gap::image::pixelformat::A4 :
-		case gap::image::pixelformat::I8 :
-			std::cerr << "create_sub_target_data: Unsupported Pixel Format!" << std::endl;
+		case gap::image::pixelformat::I4 :
+			for(int iy=0;iy<height;++iy)
+			{
+				const uint32_t * p_line = p_pixels + (std::size_t(iy) * stride);
+				for(int ix=0;ix<width;ix+=2)
+				{
+					const uint32_t low	= encode(p_line[ix]) & 0x0F;
+					const uint32_t high	= (ix+1) < width ? encode(p_line[ix+1]) & 0x0F : 0;
+					data.push_back(low | (high << 4));
+				}
+			}
 			break;
 
 		default :
 			for(int iy=0;iy<height;++iy)
 			{
+				const uint32_t * p_line = p_pixels + (std::size_t(iy) * stride);
 				for(int ix=0;ix<width;++ix)
 				{
-					std::uint32_t pixel = gap::image::pixelformat::encode_pixel(get_pixel(x+ix,y+iy),pixel_format);
+					std::uint32_t pixel = encode(p_line[ix]);
 					for(int c=0;c<bpp;++c)
 						data.push_back((big_endian ? (pixel >> (((bpp-1)-c)*8))  : (pixel >> (c*8)) ) & 0x0FF);
 				}
@@ -230,9 +405,115 @@ SourceImage::duplicate_subimage(int x, int y, int width, int height)
 	return std::make_unique<SourceImage>(width,height,get_pixel_address(x,y),m_width-width);
 }
 
+//-----------------------------------------------------------------------------
+//	Opaque pixel search. The alpha channel is the top byte of each ARGB8888
+//	pixel so four pixels are tested at a time by masking the alpha bytes and
+//	comparing against zero.
+//-----------------------------------------------------------------------------
+static constexpr uint32_t ALPHA_MASK = 0xFF000000U;
+
+// Index of the first pixel with a non-zero alpha, or 'count' if there is none.
+static
+int
+find_first_opaque(const uint32_t * p_pixels, int count)
+{
+	int i = 0;
+#if defined(__SSE2__)
+	const __m128i mask = _mm_set1_epi32(int(ALPHA_MASK));
+	const __m128i zero = _mm_setzero_si128();
+	for(; (i + 4) <= count; i += 4)
+	{
+		const __m128i alpha = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p_pixels + i)), mask);
+		const int transparent = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(alpha, zero)));
+		if(transparent != 0x0F)
+			return i + std::countr_one(unsigned(transparent));
+	}
+#endif
+	for(; i < count; ++i)
+		if(p_pixels[i] & ALPHA_MASK)
+			return i;
+	return count;
+}
+
+// One past the index of the last pixel with a non-zero alpha, or 0 if there
+// is none.
+static
+int
+find_last_opaque(const uint32_t * p_pixels, int count)
+{
+	int i = count;
+#if defined(__SSE2__)
+	const __m128i mask = _mm_set1_epi32(int(ALPHA_MASK));
+	const __m128i zero = _mm_setzero_si128();
+	for(; i >= 4; i -= 4)
+	{
+		const __m128i alpha = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p_pixels + i - 4)), mask);
+		const int transparent = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(alpha, zero)));
+		if(transparent != 0x0F)
+			return i - std::countl_one(unsigned(transparent) << 28);
+	}
+#endif
+	for(; i > 0; --i)
+		if(p_pixels[i-1] & ALPHA_MASK)
+			return i;
+	return 0;
+}
+
+//-----------------------------------------------------------------------------
+//	The smallest rectangle that contains every pixel with a non-zero alpha.
+//	A fully transparent image has empty bounds.
+//-----------------------------------------------------------------------------
+Rect
+SourceImage::opaque_bounds() const
+{
+	const uint32_t * p_data = m_source_data.data();
+	auto line = [&](int y) {return p_data + (y * m_width);};
+
+	int top = 0;
+	while((top < m_height) && (find_first_opaque(line(top), m_width) == m_width))
+		++top;
+
+	if(top == m_height)
+		return Rect{};
+
+	int bottom = m_height;
+	while(find_first_opaque(line(bottom-1), m_width) == m_width)
+		--bottom;
+
+	// Each line only needs to be searched outside of the columns that are
+	// already known to be inside the bounds.
+	int left	= m_width;
+	int right	= 0;
+	for(int y=top; y<bottom; ++y)
+	{
+		left	= find_first_opaque(line(y), left);
+		right	= std::max(right, left);
+		right	+= find_last_opaque(line(y) + right, m_width - right);
+	}
+
+	return Rect{left, top, right-left, bottom-top};
+}
+
+static
+float
+normalise_angle(float angle)
+{
+	angle = std::fmod(angle, 360.0f);
+	return angle < 0.0f ? angle + 360.0f : angle;
+}
+
+static
+bool
+is_right_angle(float angle)
+{
+	return (angle == 0.0f) || (angle == 90.0f) || (angle == 180.0f) || (angle == 270.0f);
+}
+
 void
 SourceImage::rotate(float angle,int & originx, int & originy)
 {
+	angle = normalise_angle(angle);
+
 	if(angle == 0.0f)
 		return;
 
@@ -244,75 +525,94 @@ SourceImage::rotate(float angle,int & originx, int & originy)
 	else if(angle == 270.0f)	{rotate_270();	originx = oy; 					originy = m_height-ox;}
 	else
 	{
-		const float rad 	= (180.0f - angle) * (M_PI / 180.0f);
-		const float s			= sin(rad);
-		const float c			= cos(rad);
+		auto rotated = gap::image::rotate(RotationSource(m_source_data.data(), m_width, m_height), angle, ox, oy);
 
-		const int 	side 	= (std::max(m_width,m_height) * 3);
-		const int 	half 	= side/2;
+		m_source_data = std::move(rotated.pixels);
+		m_width 			= rotated.width;
+		m_height 			= rotated.height;
+		originx 			= rotated.x_origin;
+		originy 			= rotated.y_origin;
+	}
+}
 
-		std::vector<uint32_t> buffer;
-		buffer.reserve((side*3) * (side*3));
-		int minx = side-1;
-		int maxx = 0;
-		int miny = side-1;
-		int maxy = 0;
+//-----------------------------------------------------------------------------
+//	Rotate copies of this image by each of 'angles'. Right angles are rotated
+//	exactly. The remaining angles share a single premultiplied copy of the
+//	image and are rotated in parallel.
+//-----------------------------------------------------------------------------
+std::vector<RotatedCopy>
+SourceImage::rotated_copies(std::span<const float> angles,int originx, int originy) const
+{
+	std::vector<RotatedCopy>	copies(angles.size());
+	std::vector<double>				arbitrary_angles;
+	std::vector<std::size_t>	arbitrary_indices;
 
-		for(int y=0;y<side;++y)
+	for(std::size_t i=0; i<angles.size(); ++i)
+	{
+		const float angle = normalise_angle(angles[i]);
+		if(is_right_angle(angle))
 		{
-			for(int x=0;x<side;++x)
-			{
-				const float xx = (float)(half-x);
-				const float yy = (float)(half-y);
-				const float xr = (xx*c) - (yy*s);
-				const float yr = (xx*s) + (yy*c);
-				int xi = (int)xr + originx;
-				int yi = (int)yr + originy;
-				float xf = xr + (float)originx;
-				float yf = yr + (float)originy;
-
-				if((xi<0) || (yi<0) || (xi>=m_width) || (yi>=m_height))
-					buffer.push_back(0);
-				else
-				{
-					auto colour = get_pixel(xf,yf);
-					buffer.push_back(colour);
-					if(colour != 0)
-					{
-						if(x > maxx)		maxx = x;
-						if(x < minx)		minx = x;
-						if(y > maxy)		maxy = y;
-						if(y < miny)		miny = y;
-					}
-				}
-			}
+			auto & copy 		= copies[i];
+			copy.p_image		= std::make_unique<SourceImage>(*this);
+			copy.x_origin 	= originx;
+			copy.y_origin 	= originy;
+			copy.p_image->rotate(angle, copy.x_origin, copy.y_origin);
 		}
+		else
+		{
+			arbitrary_angles.push_back(angle);
+			arbitrary_indices.push_back(i);
+		}
+	}
 
-		originx = half-minx;
-		originy = half-miny;
-
-		m_width 	= (maxx - minx) + 1;
-		m_height 	= (maxy - miny) + 1;
-
-		m_source_data.clear();
-		m_source_data.reserve(m_width * m_height);
+	if(!arbitrary_angles.empty())
+	{
+		auto rotated = gap::image::rotate(RotationSource(m_source_data.data(), m_width, m_height), arbitrary_angles, originx, originy);
 
-		for(int y=miny;y<=maxy;++y)
-			for(int x=minx;x<=maxx;++x)
-				m_source_data.push_back(buffer[(y*side) + x]);
+		for(std::size_t i=0; i<rotated.size(); ++i)
+		{
+			auto & copy 		= copies[arbitrary_indices[i]];
+			copy.p_image		= std::make_unique<SourceImage>(rotated[i].width, rotated[i].height, std::move(rotated[i].pixels));
+			copy.x_origin		= rotated[i].x_origin;
+			copy.y_origin		= rotated[i].y_origin;
+			copy.p_image->set_source_pixelformat(m_source_pixelformat);
+			copy.p_image->set_target_pixelformat(m_target_pixelformat);
+		}
 	}
 
+	return copies;
 }
 
+//-----------------------------------------------------------------------------
+//	Right angle rotations are transposes with one axis reversed. They are done
+//	in TRANSPOSE_BLOCK sized tiles so that both the reads and the writes of a
+//	tile stay in cache.
+//-----------------------------------------------------------------------------
+static constexpr int TRANSPOSE_BLOCK = 32;
+
 void
 SourceImage::rotate_90()
 {
-	std::vector<uint32_t>		buffer;
-	buffer.reserve(m_source_data.size());
+	std::vector<uint32_t>	buffer(m_source_data.size());
+	const uint32_t * 			p_src 	= m_source_data.data();
+	uint32_t *						p_dest	= buffer.data();
 
-	for(int x=0;x<m_width;++x)
-		for(int y=m_height-1;y>=0;--y)
-			buffer.push_back(get_pixel(x,y));
+	// dest(x,y) = src(y, height-1-x)
+	for(int by=0;by<m_height;by+=TRANSPOSE_BLOCK)
+	{
+		const int ey = std::min(by+TRANSPOSE_BLOCK,m_height);
+		for(int bx=0;bx<m_width;bx+=TRANSPOSE_BLOCK)
+		{
+			const int ex = std::min(bx+TRANSPOSE_BLOCK,m_width);
+			for(int y=by;y<ey;++y)
+			{
+				const uint32_t * p_row = p_src + (std::size_t(y) * m_width);
+				const int dx = (m_height-1)-y;
+				for(int x=bx;x<ex;++x)
+					p_dest[(std::size_t(x) * m_height) + dx] = p_row[x];
+			}
+		}
+	}
 
 	std::swap(m_source_data,buffer);
 	std::swap(m_width,m_height);
@@ -321,25 +621,31 @@ SourceImage::rotate_90()
 void
 SourceImage::rotate_180()
 {
-	std::vector<uint32_t>		buffer;
-	buffer.reserve(m_source_data.size());
-
-	for(int y=m_height-1;y>=0;--y)
-		for(int x=m_width-1;x>=0;--x)
-			buffer.push_back(get_pixel(x,y));
-
-	std::swap(m_source_data,buffer);
+	std::reverse(begin(m_source_data),end(m_source_data));
 }
 
 void
 SourceImage::rotate_270()
 {
-	std::vector<uint32_t>		buffer;
-	buffer.reserve(m_source_data.size());
+	std::vector<uint32_t>	buffer(m_source_data.size());
+	const uint32_t * 			p_src 	= m_source_data.data();
+	uint32_t *						p_dest	= buffer.data();
 
-	for(int x=m_width-1;x>=0;--x)
-		for(int y=0;y<m_height;++y)
-			buffer.push_back(get_pixel(x,y));
+	// dest(x,y) = src(width-1-y, x)
+	for(int by=0;by<m_height;by+=TRANSPOSE_BLOCK)
+	{
+		const int ey = std::min(by+TRANSPOSE_BLOCK,m_height);
+		for(int bx=0;bx<m_width;bx+=TRANSPOSE_BLOCK)
+		{
+			const int ex = std::min(bx+TRANSPOSE_BLOCK,m_width);
+			for(int y=by;y<ey;++y)
+			{
+				const uint32_t * p_row = p_src + (std::size_t(y) * m_width);
+				for(int x=bx;x<ex;++x)
+					p_dest[(std::size_t((m_width-1)-x) * m_height) + y] = p_row[x];
+			}
+		}
+	}
 
 	std::swap(m_source_data,buffer);
 	std::swap(m_width,m_height);
@@ -350,24 +656,19 @@ SourceImage::horizontal_flip()
 {
 	for(int y=0;y<m_height;++y)
 	{
-		const int i = y*m_width;
-		std::reverse(&m_source_data[i],&m_source_data[i+m_width-1]);
+		auto row = begin(m_source_data) + (std::size_t(y) * m_width);
+		std::reverse(row,row+m_width);
 	}
 }
 
 void
 SourceImage::vertical_flip()
 {
-	std::vector<uint32_t>		buffer;
-	buffer.reserve(m_source_data.size());
-
-	for(int y=0;y<m_height;++y)
+	for(int top=0,bottom=m_height-1;top<bottom;++top,--bottom)
 	{
-		std::copy( 	&m_source_data[y * m_width],
-								&m_source_data[(y+1) * m_width],
-								&buffer[((m_height-1) - y) * m_width]);
+		auto top_row = begin(m_source_data) + (std::size_t(top) * m_width);
+		std::swap_ranges(top_row,top_row+m_width,begin(m_source_data) + (std::size_t(bottom) * m_width));
 	}
-	std::swap(m_source_data,buffer);
 }
 
 } // namespace gap::image
@@ -16,6 +16,9 @@
 #include <string>
 #include <cmath>
 #include <utility>
+#include <memory>
+#include <span>
+#include <unordered_map>
 #include "filesystem.h"
 #include "utility/hash.h"
 
@@ -55,8 +58,56 @@ enum
 	A8,
 	A4,
 	I8,								//	Indexed (256 colour palette)
+	BC1,							//	4x4 blocks of 8 bytes. RGB + 1-bit alpha. See image_compress.h
+	BC3,							//	4x4 blocks of 16 bytes. Interpolated alpha + BC1 colour
+	ETC1,							//	4x4 blocks of 8 bytes. RGB
+	ETC2,							//	4x4 blocks of 8 bytes. RGB
+	ETC2_RGBA,				//	4x4 blocks of 16 bytes. EAC alpha + ETC2 colour
+	I4,								//	Indexed (16 colour palette), two pixels per byte
 };
 
+enum
+{
+	RLE								= 0x80			//	Flag. Image data is run length encoded in the base format. See image_rle.h
+};
+
+constexpr bool						is_rle(const std::uint8_t pixel_format)				{return (pixel_format & RLE) != 0;}
+constexpr std::uint8_t		base_format(const std::uint8_t pixel_format)	{return pixel_format & ~RLE;}
+
+// Size of each 4x4 block of a block compressed format, or 0 for pixel formats.
+constexpr int	block_bytes(const std::uint8_t	pixel_format)
+							{
+								switch(pixel_format)
+								{
+									case gap::image::pixelformat::BC1 :
+									case gap::image::pixelformat::ETC1 :
+									case gap::image::pixelformat::ETC2 :				return 8;
+									case gap::image::pixelformat::BC3 :
+									case gap::image::pixelformat::ETC2_RGBA :		return 16;
+									default : break;
+								}
+								return 0;
+							}
+
+constexpr bool						is_block_format(const std::uint8_t pixel_format)	{return block_bytes(pixel_format) != 0;}
+
+// Number of colour map entries an indexed format can address, or 0 if the
+// format is not indexed.
+constexpr int							palette_limit(const std::uint8_t pixel_format)
+													{
+														switch(pixel_format)
+														{
+															case gap::image::pixelformat::I8 :	return 256;
+															case gap::image::pixelformat::I4 :	return 16;
+															default : break;
+														}
+														return 0;
+													}
+
+constexpr bool						is_indexed(const std::uint8_t pixel_format)				{return palette_limit(pixel_format) != 0;}
+
+// Bytes per pixel of a pixel format. 0 for formats that pack more than one
+// pixel into a byte (L4, A4) or compress 4x4 blocks.
 constexpr int	bytes_per_pixel(const std::uint8_t	pixel_format)
 							{
 								switch(pixel_format)
@@ -91,7 +142,13 @@ constexpr int	image_data_size(const std::uint8_t	pixel_format, int width, int he
 									case gap::image::pixelformat::A8 :					
 									case gap::image::pixelformat::I8 :					return width * height;
 									case gap::image::pixelformat::L4 :
-									case gap::image::pixelformat::A4 :					return (width/2) * height;
+									case gap::image::pixelformat::A4 :
+									case gap::image::pixelformat::I4 :					return ((width+1)/2) * height;		// Each line starts on a byte boundary.
+									case gap::image::pixelformat::BC1 :
+									case gap::image::pixelformat::BC3 :
+									case gap::image::pixelformat::ETC1 :
+									case gap::image::pixelformat::ETC2 :
+									case gap::image::pixelformat::ETC2_RGBA :		return ((width+3)/4) * ((height+3)/4) * block_bytes(pixel_format);		// Partial blocks are padded.
 
 									default : break;
 								}
@@ -129,6 +186,7 @@ image_pixel_offset(const std::uint8_t	pixel_format,int x,int y,int stride)
 	{
 		case gap::image::pixelformat::L4 :
 		case gap::image::pixelformat::A4 :
+		case gap::image::pixelformat::I4 :
 			return ((stride * y) + x) / 2;	
 			break;
 
@@ -146,25 +204,56 @@ image_pixel_offset(const std::uint8_t	pixel_format,int x,int y,int stride)
 std::uint8_t 		parse_pixelformat_name(const std::string & name);
 std::string			get_pixelformat_name(std::uint8_t pixelformat);
 
+class Palette;
+
+//=============================================================================
+//	Encoding Options
+//=============================================================================
+enum
+{
+	DITHER_NONE,
+	DITHER_ORDERED,						// 4x4 Bayer matrix
+	DITHER_DIFFUSION					// Floyd-Steinberg error diffusion
+};
+
+struct EncodeOptions
+{
+	bool							b_premultiply		= false;
+	std::uint8_t			dither					= DITHER_NONE;
+	bool							b_high_quality	= false;			// Slower block compression for release builds
+	const Palette *		p_palette				= nullptr;		// Colour map for the indexed formats. Set by the encoder.
+};
+
+std::uint8_t 		parse_dither_name(const std::string & name);
+
 //=============================================================================
 //	Palette
 //=============================================================================
 class Palette
 {
 private:
-	std::vector<std::uint32_t>		m_palette;
+	std::vector<std::uint32_t>									m_palette;
+	std::unordered_map<std::uint32_t,int>				m_lookup;			// Colour to index. Empty until build_lookup() is called.
 
 public:
 	Palette() = default;
 	explicit Palette(int size) : m_palette(size) {}
-	Palette(const std::vector<std::uint32_t> palette) : m_palette(palette) {}
+	Palette(const std::vector<std::uint32_t> palette) : m_palette(palette) {build_lookup();}
 
-	std::uint32_t & operator[](int index)		{return m_palette[index];}
-	void						resize(int size)				{m_palette.resize(size);}
+	std::uint32_t & operator[](int index)		{m_lookup.clear(); return m_palette[index];}
+	void						resize(int size)				{m_lookup.clear(); m_palette.resize(size);}
 	bool						empty()	const 					{return m_palette.empty();}
+	int							size() const						{return m_palette.size();}
+	const std::vector<std::uint32_t> &	colours() const		{return m_palette;}
 	
 	int							find_colour(std::uint32_t colour) const
 									{
+										if(!m_lookup.empty())
+										{
+											auto it = m_lookup.find(colour);
+											return it == m_lookup.end() ? -1 : it->second;
+										}
+
 										int index = 0;
 										for(auto c : m_palette)
 										{
@@ -181,14 +270,45 @@ public:
 										{
 											if(std::cmp_greater_equal(index,m_palette.size()))
 												resize(index+1);
+											m_lookup.clear();
 											m_palette[index] = colour; 
 										}
 									}
+
+	// Hash the colours so that find_colour() and exact matches in
+	// nearest_colour() do not scan the palette. Changing the palette drops
+	// the table. The first of any duplicate colours is used.
+	void						build_lookup()
+									{
+										m_lookup.clear();
+										m_lookup.reserve(m_palette.size());
+										for(std::size_t i=0; i<m_palette.size(); ++i)
+											m_lookup.try_emplace(m_palette[i], int(i));
+									}
+
+	int							nearest_colour(std::uint32_t colour) const;
 };
 
 //=============================================================================
 //	Source Image Data
 //=============================================================================
+class SourceImage;
+
+struct Rect
+{
+	int														x						= 0;
+	int														y						= 0;
+	int														width				= 0;
+	int														height			= 0;
+};
+
+struct RotatedCopy
+{
+	std::unique_ptr<SourceImage>	p_image;
+	int														x_origin		= 0;
+	int														y_origin		= 0;
+};
+
 class
 SourceImage
 {
@@ -207,6 +327,7 @@ public:
 	SourceImage() = default;
 	SourceImage(int width,int height,const std::uint32_t * p_data = nullptr,int line_offset = 0);
 	SourceImage(int width,int height,const std::uint8_t * p_data = nullptr,int line_offset = 0);
+	SourceImage(int width,int height,std::vector<std::uint32_t> && data) : m_source_data(std::move(data)), m_width(width), m_height(height) {}
 	
 	int 															width() const 								{return m_width;}
 	int 															height() const 								{return m_height;}
@@ -218,30 +339,6 @@ public:
 	void 															set_source_pixelformat(std::uint8_t pixelformat)		{m_source_pixelformat = pixelformat;}
 	void 															set_target_pixelformat(std::uint8_t pixelformat)		{m_target_pixelformat = pixelformat;}
 
-	uint32_t 					mix_colour(uint32_t c1, uint32_t c2, uint32_t mix) const
-										{
-											if((c1==0) && (c2==0))
-												return 0;
-										//	if(c1 == 0)	return c2;
-										//	if(c2 == 0)	return c1;
-
-											const uint32_t a1 = (c1>>24) & 0x0FF;
-											const uint32_t a2 = (c2>>24) & 0x0FF;
-											const uint32_t r1 = (c1>>16) & 0x0FF;
-											const uint32_t r2 = (c2>>16) & 0x0FF;
-											const uint32_t g1 = (c1>>8) & 0x0FF;
-											const uint32_t g2 = (c2>>8) & 0x0FF;
-											const uint32_t b1 = c1 & 0x0FF;
-											const uint32_t b2 = c2 & 0x0FF;
-
-											const uint32_t a = ((a1 * mix)/255) + ((a2 * (255-mix))/255);
-											const uint32_t r = ((r1 * mix)/255) + ((r2 * (255-mix))/255);
-											const uint32_t g = ((g1 * mix)/255) + ((g2 * (255-mix))/255);
-											const uint32_t b = ((b1 * mix)/255) + ((b2 * (255-mix))/255);
-
-											return ((a & 0x0FF) << 24) | ((r & 0x0FF) << 16) | ((g & 0x0FF) << 8) | (b & 0x0FF);
-										}
-
 	uint32_t 					get_pixel(int x, int y) const
 										{
 											x = std::max(0,std::min(x,m_width-1));
@@ -249,39 +346,15 @@ public:
 											return m_source_data[(y * (m_width)) + x];
 										}
 
-	uint32_t 					get_pixel(float x, float y) const
-										{
-											double dx,dy;
-											float fx = modf(x,&dx);
-											float fy = modf(y,&dy);
-											const int ix = (int)dx;
-											const int iy = (int)dy;
-
-											int x2;//,y2;
-											if(fx < 0.5f) {x2 = ix-1;fx +=0.5f;}
-											else					{x2 = ix+1;fx = 1.5f-fx;}
-											if(fy < 0.5f) {/*y2 = iy-1*/;fy +=0.5f;}
-											else					{/*y2 = iy+1*/;fy = 1.5f-fy;}
-
-											const auto c1a = get_pixel(ix,iy);
-											const auto c1b = get_pixel(x2,iy);
-											const auto c2a = get_pixel(ix,iy);
-											const auto c2b = get_pixel(x2,iy);
-
-											const auto c1 = mix_colour(c1a,c1b,(uint32_t)(fx*255.0f));
-											const auto c2 = mix_colour(c2a,c2b,(uint32_t)(fx*255.0f));
-											auto c3 = mix_colour(c1,c2,(uint32_t)(fy*255.0f));
-											
-											return c3;
-										}
-
 	std::unique_ptr<SourceImage>	duplicate_subimage(int x, int y, int width, int height);
+	Rect													opaque_bounds() const;
 
 //	void									create_target_data(bool big_endian);
-	std::vector<uint8_t>	create_sub_target_data(int x, int y, int width, int height, uint8_t pixel_format, bool big_endian);
+	std::vector<uint8_t>	create_sub_target_data(int x, int y, int width, int height, uint8_t pixel_format, bool big_endian, const EncodeOptions & options = {});
 	const uint32_t * 			get_pixel_address(int x,int y)		{return m_source_data.data() + (y*m_width) + x;}
 
 	void									rotate(float angle,int & originx, int & originy);
+	std::vector<RotatedCopy>	rotated_copies(std::span<const float> angles,int originx, int originy) const;
 	void									rotate_90();
 	void									rotate_180();
 	void									rotate_270();
@@ -331,11 +404,15 @@ struct Image
 	float							angle						= 0.0f;
 	bool							b_hflip					= false;
 	bool							b_vflip					= false;
+	bool							b_trim					= false;			// Crop fully transparent rows and columns.
+	int								colour_map			= -1;			// Colour map for the indexed formats.
+	EncodeOptions			encode;
 };
 
 
 
 std::unique_ptr<SourceImage>			load(const std::string & filename,gap::FileSystem & filesystem);
+std::unique_ptr<SourceImage>			decode(std::span<const std::uint8_t> file);
 //TargetImage			CreateTargetImage(const SourceImage & source,bool big_endian);
 
 } // namespace gap::image
@@ -0,0 +1,1090 @@
+//=============================================================================
+//	FILE:					image_compress.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Block compressed texture formats (BC1, BC3, ETC1, ETC2)
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include "image_compress.h"
+#include "image.h"
+
+namespace gap::image
+{
+
+using Block = std::array<uint32_t,16>;			// ARGB8888, row major
+
+static constexpr int CHANNEL_SHIFT[4]					= {16, 8, 0, 24};		// Red, Green, Blue, Alpha
+static constexpr int MIN_BLOCKS_PER_THREAD		= 256;
+static constexpr int MAX_ERROR								= std::numeric_limits<int>::max();
+
+static inline int	channel(uint32_t colour, int c)	{return (colour >> CHANNEL_SHIFT[c]) & 0x0FF;}
+static inline int	alpha(uint32_t colour)					{return colour >> 24;}
+static inline int	square(int v)										{return v * v;}
+
+static inline
+int
+colour_error(uint32_t a, uint32_t b)
+{
+	return square(channel(a,0) - channel(b,0)) + square(channel(a,1) - channel(b,1)) + square(channel(a,2) - channel(b,2));
+}
+
+static inline
+uint32_t
+make_colour(int a, int r, int g, int b)
+{
+	return (uint32_t(a) << 24) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+}
+
+static inline
+void
+write_u64_be(uint8_t * p_out, uint64_t value)
+{
+	for(int c=0;c<8;++c)
+		p_out[c] = (value >> ((7-c)*8)) & 0x0FF;
+}
+
+static inline
+uint64_t
+read_u64_be(const uint8_t * p_data)
+{
+	uint64_t value = 0;
+	for(int c=0;c<8;++c)
+		value = (value << 8) | p_data[c];
+	return value;
+}
+
+//=============================================================================
+//
+//	BC1 / BC3 Colour
+//
+//	Two RGB565 endpoints (little endian) and 16 2-bit indices. If the first
+//	endpoint is greater than the second the palette is the two endpoints and
+//	two colours interpolated at 1/3 and 2/3, otherwise it is the endpoints,
+//	their midpoint and transparent black. BC3 always uses the first form.
+//
+//=============================================================================
+static inline
+uint16_t
+pack_565(int r, int g, int b)
+{
+	return uint16_t(((((r * 31) + 127) / 255) << 11) | ((((g * 63) + 127) / 255) << 5) | (((b * 31) + 127) / 255));
+}
+
+static inline
+uint32_t
+unpack_565(uint16_t colour)
+{
+	const int r = (colour >> 11) & 0x1F;
+	const int g = (colour >> 5) & 0x3F;
+	const int b = colour & 0x1F;
+	return make_colour(0x0FF, (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+static inline
+uint32_t
+blend(uint32_t a, uint32_t b, int weight_a, int weight_b)
+{
+	const int total = weight_a + weight_b;
+	int values[3];
+	for(int c=0;c<3;++c)
+		values[c] = ((channel(a,c) * weight_a) + (channel(b,c) * weight_b) + (total / 2)) / total;
+	return make_colour(0x0FF, values[0], values[1], values[2]);
+}
+
+static
+void
+bc1_palette(uint16_t c0, uint16_t c1, bool b_four_colour, uint32_t palette[4])
+{
+	palette[0] = unpack_565(c0);
+	palette[1] = unpack_565(c1);
+
+	if(b_four_colour || (c0 > c1))
+	{
+		palette[2] = blend(palette[0], palette[1], 2, 1);
+		palette[3] = blend(palette[0], palette[1], 1, 2);
+	}
+	else
+	{
+		palette[2] = blend(palette[0], palette[1], 1, 1);
+		palette[3] = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//	Quantise a pair of endpoints, choose the nearest palette entry for each
+//	pixel and write the block. Pixels set in 'transparent' select the
+//	transparent entry, which also selects the three colour palette. Returns
+//	the squared error of the opaque pixels.
+//-----------------------------------------------------------------------------
+static
+int
+bc1_encode_endpoints(const Block & block, uint16_t transparent, bool b_three_colour, const float lo[3], const float hi[3], uint8_t * p_out)
+{
+	auto to_565 = [](const float * p) {return pack_565(std::clamp(int(std::lround(p[0])),0,255), std::clamp(int(std::lround(p[1])),0,255), std::clamp(int(std::lround(p[2])),0,255));};
+
+	uint16_t c0 = to_565(hi);
+	uint16_t c1 = to_565(lo);
+
+	b_three_colour |= (transparent != 0);
+	if(b_three_colour == (c0 > c1))
+		std::swap(c0, c1);
+
+	uint32_t palette[4];
+	bc1_palette(c0, c1, false, palette);
+	const int entries = (c0 > c1) ? 4 : 3;
+
+	uint32_t	indices = 0;
+	int				error		= 0;
+	for(int i=0; i<16; ++i)
+	{
+		int index = 3;
+		if(!(transparent & (1 << i)))
+		{
+			int best = MAX_ERROR;
+			for(int e=0; e<entries; ++e)
+			{
+				const int e_error = colour_error(block[i], palette[e]);
+				if(e_error < best)
+				{
+					best	= e_error;
+					index	= e;
+				}
+			}
+			error += best;
+		}
+		indices |= uint32_t(index) << (i * 2);
+	}
+
+	p_out[0] = c0 & 0x0FF;
+	p_out[1] = c0 >> 8;
+	p_out[2] = c1 & 0x0FF;
+	p_out[3] = c1 >> 8;
+	for(int c=0;c<4;++c)
+		p_out[4 + c] = (indices >> (c * 8)) & 0x0FF;
+
+	return error;
+}
+
+//-----------------------------------------------------------------------------
+//	Endpoints at the extremes of the principal axis of the selected pixels,
+//	found by power iteration on the colour covariance.
+//-----------------------------------------------------------------------------
+static
+void
+fit_principal_axis(const Block & block, uint16_t mask, float lo[3], float hi[3])
+{
+	float mean[3]	= {0.0f, 0.0f, 0.0f};
+	int		count		= 0;
+	for(int i=0; i<16; ++i)
+		if(mask & (1 << i))
+		{
+			for(int c=0;c<3;++c)
+				mean[c] += channel(block[i],c);
+			++count;
+		}
+
+	if(count == 0)
+	{
+		std::fill_n(lo, 3, 0.0f);
+		std::fill_n(hi, 3, 0.0f);
+		return;
+	}
+
+	for(auto & m : mean)
+		m /= count;
+
+	float covariance[3][3] = {};
+	for(int i=0; i<16; ++i)
+		if(mask & (1 << i))
+		{
+			const float d[3] = {channel(block[i],0) - mean[0], channel(block[i],1) - mean[1], channel(block[i],2) - mean[2]};
+			for(int r=0;r<3;++r)
+				for(int c=0;c<3;++c)
+					covariance[r][c] += d[r] * d[c];
+		}
+
+	float axis[3] = {1.0f, 1.0f, 1.0f};
+	for(int iteration=0; iteration<8; ++iteration)
+	{
+		float next[3];
+		for(int r=0;r<3;++r)
+			next[r] = (covariance[r][0] * axis[0]) + (covariance[r][1] * axis[1]) + (covariance[r][2] * axis[2]);
+
+		const float length = std::max({std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2])});
+		if(length < 1e-6f)
+			break;
+		for(int c=0;c<3;++c)
+			axis[c] = next[c] / length;
+	}
+
+	const float length_sq = (axis[0] * axis[0]) + (axis[1] * axis[1]) + (axis[2] * axis[2]);
+
+	float t_min = 0.0f;
+	float t_max = 0.0f;
+	for(int i=0; i<16; ++i)
+		if(mask & (1 << i))
+		{
+			float t = 0.0f;
+			for(int c=0;c<3;++c)
+				t += (channel(block[i],c) - mean[c]) * axis[c];
+			t /= length_sq;
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+
+	for(int c=0;c<3;++c)
+	{
+		lo[c] = mean[c] + (axis[c] * t_min);
+		hi[c] = mean[c] + (axis[c] * t_max);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//	Least squares endpoints for the indices chosen in an encoded block. Each
+//	opaque pixel contributes weight w of the first endpoint and 1-w of the
+//	second. Returns false if the system is degenerate.
+//-----------------------------------------------------------------------------
+static
+bool
+refine_endpoints(const Block & block, const uint8_t * p_encoded, float lo[3], float hi[3])
+{
+	const uint16_t	c0				= p_encoded[0] | (p_encoded[1] << 8);
+	const uint16_t	c1				= p_encoded[2] | (p_encoded[3] << 8);
+	const uint32_t	indices		= p_encoded[4] | (p_encoded[5] << 8) | (p_encoded[6] << 16) | (uint32_t(p_encoded[7]) << 24);
+	const bool			b_four		= c0 > c1;
+
+	static constexpr float WEIGHTS_FOUR[4]	= {1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f};
+	static constexpr float WEIGHTS_THREE[4]	= {1.0f, 0.0f, 0.5f, 0.0f};
+
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = {}, bx[3] = {};
+
+	for(int i=0; i<16; ++i)
+	{
+		const int index = (indices >> (i * 2)) & 3;
+		if(!b_four && (index == 3))
+			continue;
+
+		const float w = b_four ? WEIGHTS_FOUR[index] : WEIGHTS_THREE[index];
+		aa += w * w;
+		ab += w * (1.0f - w);
+		bb += (1.0f - w) * (1.0f - w);
+		for(int c=0;c<3;++c)
+		{
+			ax[c] += w * channel(block[i],c);
+			bx[c] += (1.0f - w) * channel(block[i],c);
+		}
+	}
+
+	const float determinant = (aa * bb) - (ab * ab);
+	if(std::fabs(determinant) < 1e-3f)
+		return false;
+
+	for(int c=0;c<3;++c)
+	{
+		hi[c] = ((bb * ax[c]) - (ab * bx[c])) / determinant;
+		lo[c] = ((aa * bx[c]) - (ab * ax[c])) / determinant;
+	}
+	return true;
+}
+
+static
+void
+encode_bc1_colour(const Block & block, bool b_alpha, bool b_high_quality, uint8_t * p_out)
+{
+	uint16_t transparent = 0;
+	if(b_alpha)
+		for(int i=0; i<16; ++i)
+			if(alpha(block[i]) < 128)
+				transparent |= 1 << i;
+
+	float lo[3], hi[3];
+	fit_principal_axis(block, ~transparent, lo, hi);
+	int best_error = bc1_encode_endpoints(block, transparent, false, lo, hi, p_out);
+
+	if(!b_high_quality || (best_error == 0))
+		return;
+
+	uint8_t candidate[8];
+
+	// ----- The three colour palette sometimes fits better. BC3 ignores it. -----
+	if(b_alpha && (transparent == 0))
+	{
+		const int error = bc1_encode_endpoints(block, 0, true, lo, hi, candidate);
+		if(error < best_error)
+		{
+			best_error = error;
+			std::copy_n(candidate, 8, p_out);
+		}
+	}
+
+	for(int iteration=0; (iteration<4) && (best_error > 0); ++iteration)
+	{
+		const bool b_three_colour = b_alpha && ((p_out[0] | (p_out[1] << 8)) <= (p_out[2] | (p_out[3] << 8)));
+		if(!refine_endpoints(block, p_out, lo, hi))
+			break;
+
+		const int error = bc1_encode_endpoints(block, transparent, b_three_colour, lo, hi, candidate);
+		if(error >= best_error)
+			break;
+
+		best_error = error;
+		std::copy_n(candidate, 8, p_out);
+	}
+}
+
+static
+void
+decode_bc1_colour(const uint8_t * p_data, bool b_four_colour, Block & block)
+{
+	const uint16_t	c0			= p_data[0] | (p_data[1] << 8);
+	const uint16_t	c1			= p_data[2] | (p_data[3] << 8);
+	const uint32_t	indices	= p_data[4] | (p_data[5] << 8) | (p_data[6] << 16) | (uint32_t(p_data[7]) << 24);
+
+	uint32_t palette[4];
+	bc1_palette(c0, c1, b_four_colour, palette);
+
+	for(int i=0; i<16; ++i)
+		block[i] = palette[(indices >> (i * 2)) & 3];
+}
+
+//=============================================================================
+//
+//	BC3 Alpha
+//
+//	Two 8-bit endpoints and 16 3-bit indices (48 bits, little endian). If the
+//	first endpoint is greater the palette has six interpolated values,
+//	otherwise it has four plus 0 and 255.
+//
+//=============================================================================
+static
+void
+bc_alpha_palette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if(a0 > a1)
+	{
+		for(int i=2; i<8; ++i)
+			palette[i] = (((8 - i) * a0) + ((i - 1) * a1) + 3) / 7;
+	}
+	else
+	{
+		for(int i=2; i<6; ++i)
+			palette[i] = (((6 - i) * a0) + ((i - 1) * a1) + 2) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static
+int
+bc_alpha_encode_endpoints(const Block & block, int a0, int a1, uint8_t * p_out)
+{
+	int palette[8];
+	bc_alpha_palette(a0, a1, palette);
+
+	uint64_t	indices	= 0;
+	int				error		= 0;
+	for(int i=0; i<16; ++i)
+	{
+		int best	= MAX_ERROR;
+		int index	= 0;
+		for(int e=0; e<8; ++e)
+		{
+			const int e_error = square(alpha(block[i]) - palette[e]);
+			if(e_error < best)
+			{
+				best	= e_error;
+				index	= e;
+			}
+		}
+		error		+= best;
+		indices	|= uint64_t(index) << (i * 3);
+	}
+
+	p_out[0] = a0;
+	p_out[1] = a1;
+	for(int c=0;c<6;++c)
+		p_out[2 + c] = (indices >> (c * 8)) & 0x0FF;
+
+	return error;
+}
+
+static
+void
+encode_bc_alpha(const Block & block, bool b_high_quality, uint8_t * p_out)
+{
+	int a_min = 255;
+	int a_max = 0;
+	int inner_min = 255;
+	int inner_max = 0;
+	for(auto pixel : block)
+	{
+		const int a = alpha(pixel);
+		a_min = std::min(a_min, a);
+		a_max = std::max(a_max, a);
+		if((a != 0) && (a != 255))
+		{
+			inner_min = std::min(inner_min, a);
+			inner_max = std::max(inner_max, a);
+		}
+	}
+
+	int best_error = bc_alpha_encode_endpoints(block, a_max, a_min, p_out);
+	if(!b_high_quality || (best_error == 0))
+		return;
+
+	uint8_t candidate[8];
+	auto attempt = [&](int a0, int a1)
+	{
+		const int error = bc_alpha_encode_endpoints(block, a0, a1, candidate);
+		if(error < best_error)
+		{
+			best_error = error;
+			std::copy_n(candidate, 8, p_out);
+		}
+	};
+
+	// ----- The six value palette holds 0 and 255 exactly, leaving the endpoints for the rest. -----
+	if((inner_min <= inner_max) && ((a_min == 0) || (a_max == 255)))
+		attempt(inner_min, inner_max);
+
+	for(int d0=-2; d0<=2; ++d0)
+		for(int d1=-2; d1<=2; ++d1)
+		{
+			const int a0 = std::clamp(a_max + d0, 0, 255);
+			const int a1 = std::clamp(a_min + d1, 0, 255);
+			if(a0 > a1)
+				attempt(a0, a1);
+		}
+}
+
+static
+void
+decode_bc_alpha(const uint8_t * p_data, Block & block)
+{
+	int palette[8];
+	bc_alpha_palette(p_data[0], p_data[1], palette);
+
+	uint64_t indices = 0;
+	for(int c=0;c<6;++c)
+		indices |= uint64_t(p_data[2 + c]) << (c * 8);
+
+	for(int i=0; i<16; ++i)
+		block[i] = (block[i] & 0x0FFFFFFU) | (uint32_t(palette[(indices >> (i * 3)) & 7]) << 24);
+}
+
+//=============================================================================
+//
+//	ETC1 / ETC2 Colour
+//
+//	A 64-bit big endian block split into two 2x4 (flip = 0) or 4x2 (flip = 1)
+//	sub-blocks, each with a base colour and a modifier table. Base colours are
+//	either 4 bits per channel each (individual mode) or 5 bits for the first
+//	and a signed 3-bit delta for the second (differential mode). Each pixel
+//	has a 2-bit index selecting a modifier that is added to all channels of
+//	its sub-block's base colour. Pixel indices are ordered down the columns.
+//
+//=============================================================================
+static constexpr int ETC_MODIFIERS[8][2] =
+{
+	{ 2,   8}, { 5,  17}, { 9,  29}, {13,  42},
+	{18,  60}, {24,  80}, {33, 106}, {47, 183}
+};
+
+// Index 0 is +small, 1 is +large, 2 is -small and 3 is -large.
+static inline
+int
+etc_modifier(int table, int index)
+{
+	const int modifier = ETC_MODIFIERS[table][index & 1];
+	return (index & 2) ? -modifier : modifier;
+}
+
+struct EtcSubBlock
+{
+	uint32_t	pixels[8];
+	int				positions[8];			// Bit position of each pixel's index, x * 4 + y
+};
+
+struct EtcFit
+{
+	int				error			= MAX_ERROR;
+	int				table			= 0;
+	uint8_t		indices[8]	= {};
+};
+
+static
+void
+etc_split(const Block & block, int flip, EtcSubBlock sub_blocks[2])
+{
+	int counts[2] = {0, 0};
+	for(int y=0; y<4; ++y)
+		for(int x=0; x<4; ++x)
+		{
+			const int s = flip ? (y >> 1) : (x >> 1);
+			sub_blocks[s].pixels[counts[s]]			= block[(y * 4) + x];
+			sub_blocks[s].positions[counts[s]]	= (x * 4) + y;
+			++counts[s];
+		}
+}
+
+//-----------------------------------------------------------------------------
+//	Choose the table and indices with the least error for a base colour. When
+//	no channel can clamp, the error of a modifier m for a pixel whose offsets
+//	from the base are d is sum(d*d) - 2m*sum(d) + 3m*m, so only the sums are
+//	needed for each pixel.
+//-----------------------------------------------------------------------------
+static
+EtcFit
+etc_fit(const EtcSubBlock & sub_block, const int base[3])
+{
+	int values[8][3];
+	int sums[8];
+	int squares[8];
+	for(int p=0; p<8; ++p)
+	{
+		sums[p]			= 0;
+		squares[p]	= 0;
+		for(int c=0;c<3;++c)
+		{
+			values[p][c] = channel(sub_block.pixels[p],c);
+			const int d = values[p][c] - base[c];
+			sums[p]			+= d;
+			squares[p]	+= d * d;
+		}
+	}
+
+	const int base_min = std::min({base[0], base[1], base[2]});
+	const int base_max = std::max({base[0], base[1], base[2]});
+
+	EtcFit best;
+
+	for(int table=0; (table<8) && (best.error > 0); ++table)
+	{
+		const int		large			= ETC_MODIFIERS[table][1];
+		const bool	b_clamps	= ((base_min - large) < 0) || ((base_max + large) > 255);
+
+		EtcFit fit;
+		fit.table = table;
+		fit.error = 0;
+
+		for(int p=0; (p<8) && (fit.error < best.error); ++p)
+		{
+			if(!b_clamps)
+			{
+				// The error is a parabola with its minimum at sum(d)/3, so take the nearest modifier.
+				const int index			= (sums[p] < 0 ? 2 : 0) | ((std::abs(sums[p]) * 2) > (3 * (ETC_MODIFIERS[table][0] + large)) ? 1 : 0);
+				const int modifier	= etc_modifier(table, index);
+				fit.indices[p]	= index;
+				fit.error				+= squares[p] - (2 * modifier * sums[p]) + (3 * modifier * modifier);
+				continue;
+			}
+
+			int best_pixel = MAX_ERROR;
+			for(int index=0; index<4; ++index)
+			{
+				const int modifier = etc_modifier(table, index);
+				int error = 0;
+				for(int c=0;c<3;++c)
+					error += square(std::clamp(base[c] + modifier, 0, 255) - values[p][c]);
+
+				if(error < best_pixel)
+				{
+					best_pixel			= error;
+					fit.indices[p]	= index;
+				}
+			}
+			fit.error += best_pixel;
+		}
+
+		if(fit.error < best.error)
+			best = fit;
+	}
+
+	return best;
+}
+
+static inline int expand_4(int v) {return (v << 4) | v;}
+static inline int expand_5(int v) {return (v << 3) | (v >> 2);}
+
+struct EtcBase
+{
+	int				q[3];						// Quantised base colour
+	EtcFit		fit;
+};
+
+struct EtcBases
+{
+	std::array<EtcBase,18>		bases;
+	int												count		= 0;
+
+	void						push_back(const EtcBase & base)	{bases[count++] = base;}
+	const EtcBase &	front() const										{return bases[0];}
+	EtcBase *				begin()													{return bases.data();}
+	EtcBase *				end()														{return bases.data() + count;}
+	const EtcBase *	begin() const										{return bases.data();}
+	const EtcBase *	end() const											{return bases.data() + count;}
+};
+
+//-----------------------------------------------------------------------------
+//	Quantised base colours to try for a sub-block - its average and, in high
+//	quality mode, the neighbouring values along each channel and the grey
+//	axis.
+//-----------------------------------------------------------------------------
+static
+EtcBases
+etc_bases(const EtcSubBlock & sub_block, int bits, bool b_high_quality)
+{
+	const int max = (1 << bits) - 1;
+
+	float average[3] = {0.0f, 0.0f, 0.0f};
+	for(auto pixel : sub_block.pixels)
+		for(int c=0;c<3;++c)
+			average[c] += channel(pixel,c);
+
+	int q[3];
+	for(int c=0;c<3;++c)
+		q[c] = std::clamp(int(std::lround((average[c] / 8.0f) * max / 255.0f)), 0, max);
+
+	static constexpr int OFFSETS[][3] =
+	{
+		{ 0, 0, 0},
+		{-1,-1,-1}, { 1, 1, 1},
+		{-1, 0, 0}, { 1, 0, 0}, { 0,-1, 0}, { 0, 1, 0}, { 0, 0,-1}, { 0, 0, 1}
+	};
+
+	EtcBases bases;
+	for(const auto & offset : OFFSETS)
+	{
+		EtcBase base;
+		bool b_valid = true;
+		for(int c=0;c<3;++c)
+		{
+			base.q[c] = q[c] + offset[c];
+			b_valid &= (base.q[c] >= 0) && (base.q[c] <= max);
+		}
+
+		if(b_valid)
+			bases.push_back(base);
+		if(!b_high_quality)
+			break;
+	}
+
+	for(auto & base : bases)
+	{
+		int colour[3];
+		for(int c=0;c<3;++c)
+			colour[c] = (bits == 4) ? expand_4(base.q[c]) : expand_5(base.q[c]);
+		base.fit = etc_fit(sub_block, colour);
+	}
+
+	return bases;
+}
+
+static
+uint64_t
+etc_bits(bool b_differential, int flip, const EtcBase & base0, const EtcBase & base1, const EtcSubBlock sub_blocks[2])
+{
+	uint64_t bits = 0;
+
+	for(int c=0;c<3;++c)
+	{
+		const int shift = 56 - (c * 8);
+		if(b_differential)
+			bits |= (uint64_t(base0.q[c]) << (shift + 3)) | (uint64_t((base1.q[c] - base0.q[c]) & 7) << shift);
+		else
+			bits |= (uint64_t(base0.q[c]) << (shift + 4)) | (uint64_t(base1.q[c]) << shift);
+	}
+
+	bits |= uint64_t(base0.fit.table) << 37;
+	bits |= uint64_t(base1.fit.table) << 34;
+	bits |= uint64_t(b_differential ? 1 : 0) << 33;
+	bits |= uint64_t(flip) << 32;
+
+	const EtcBase * p_bases[2] = {&base0, &base1};
+	for(int s=0; s<2; ++s)
+		for(int p=0; p<8; ++p)
+		{
+			const int index			= p_bases[s]->fit.indices[p];
+			const int position	= sub_blocks[s].positions[p];
+			bits |= (uint64_t(index >> 1) << (16 + position)) | (uint64_t(index & 1) << position);
+		}
+
+	return bits;
+}
+
+static
+void
+encode_etc_colour(const Block & block, bool b_high_quality, uint8_t * p_out)
+{
+	int64_t		best_error	= MAX_ERROR;
+	uint64_t	best_bits		= 0;
+
+	for(int flip=0; flip<2; ++flip)
+	{
+		EtcSubBlock sub_blocks[2];
+		etc_split(block, flip, sub_blocks);
+
+		// ----- Individual mode. The sub-blocks are independent. -----
+		{
+			const auto bases0 = etc_bases(sub_blocks[0], 4, b_high_quality);
+			const auto bases1 = etc_bases(sub_blocks[1], 4, b_high_quality);
+			auto by_error = [](const EtcBase & a, const EtcBase & b) {return a.fit.error < b.fit.error;};
+			const auto & base0 = *std::min_element(bases0.begin(), bases0.end(), by_error);
+			const auto & base1 = *std::min_element(bases1.begin(), bases1.end(), by_error);
+
+			const int64_t error = int64_t(base0.fit.error) + base1.fit.error;
+			if(error < best_error)
+			{
+				best_error	= error;
+				best_bits		= etc_bits(false, flip, base0, base1, sub_blocks);
+			}
+		}
+
+		// ----- Differential mode. The second base must be within -4..+3 of the first. -----
+		{
+			const auto bases0 = etc_bases(sub_blocks[0], 5, b_high_quality);
+			auto bases1 = etc_bases(sub_blocks[1], 5, b_high_quality);
+
+			// Also try the second sub-block's average pulled into range of each first base.
+			const int average1[3] = {bases1.front().q[0], bases1.front().q[1], bases1.front().q[2]};
+			for(const auto & base0 : bases0)
+			{
+				EtcBase clamped;
+				int colour[3];
+				for(int c=0;c<3;++c)
+				{
+					clamped.q[c]	= std::clamp(average1[c], base0.q[c] - 4, base0.q[c] + 3);
+					colour[c]			= expand_5(clamped.q[c]);
+				}
+				clamped.fit = etc_fit(sub_blocks[1], colour);
+				bases1.push_back(clamped);
+			}
+
+			for(const auto & base0 : bases0)
+				for(const auto & base1 : bases1)
+				{
+					bool b_valid = true;
+					for(int c=0;c<3;++c)
+					{
+						const int delta = base1.q[c] - base0.q[c];
+						b_valid &= (delta >= -4) && (delta <= 3);
+					}
+
+					const int64_t error = int64_t(base0.fit.error) + base1.fit.error;
+					if(b_valid && (error < best_error))
+					{
+						best_error	= error;
+						best_bits		= etc_bits(true, flip, base0, base1, sub_blocks);
+					}
+				}
+		}
+	}
+
+	write_u64_be(p_out, best_bits);
+}
+
+static
+void
+decode_etc_colour(const uint8_t * p_data, Block & block)
+{
+	const uint64_t	bits						= read_u64_be(p_data);
+	const bool			b_differential	= (bits >> 33) & 1;
+	const int				flip						= (bits >> 32) & 1;
+	const int				tables[2]				= {int((bits >> 37) & 7), int((bits >> 34) & 7)};
+
+	int bases[2][3];
+	for(int c=0;c<3;++c)
+	{
+		const int shift = 56 - (c * 8);
+		if(b_differential)
+		{
+			const int q0		= (bits >> (shift + 3)) & 0x1F;
+			const int delta	= int((bits >> shift) & 7) - (((bits >> shift) & 4) ? 8 : 0);
+			bases[0][c] = expand_5(q0);
+			bases[1][c] = expand_5((q0 + delta) & 0x1F);			// Overflow selects the ETC2 T, H and planar modes which are not produced.
+		}
+		else
+		{
+			bases[0][c] = expand_4((bits >> (shift + 4)) & 0x0F);
+			bases[1][c] = expand_4((bits >> shift) & 0x0F);
+		}
+	}
+
+	for(int y=0; y<4; ++y)
+		for(int x=0; x<4; ++x)
+		{
+			const int s					= flip ? (y >> 1) : (x >> 1);
+			const int position	= (x * 4) + y;
+			const int index			= int(((bits >> (16 + position)) & 1) << 1) | int((bits >> position) & 1);
+			const int modifier	= etc_modifier(tables[s], index);
+
+			block[(y * 4) + x] = make_colour(	0x0FF,
+																				std::clamp(bases[s][0] + modifier, 0, 255),
+																				std::clamp(bases[s][1] + modifier, 0, 255),
+																				std::clamp(bases[s][2] + modifier, 0, 255) );
+		}
+}
+
+//=============================================================================
+//
+//	ETC2 EAC Alpha
+//
+//	A 64-bit big endian block - 8-bit base, 4-bit multiplier, 4-bit table and
+//	16 3-bit indices ordered down the columns. Each alpha value is the base
+//	plus the selected table modifier times the multiplier.
+//
+//=============================================================================
+static constexpr int EAC_MODIFIERS[16][8] =
+{
+	{-3, -6,  -9, -15, 2, 5, 8, 14},
+	{-3, -7, -10, -13, 2, 6, 9, 12},
+	{-2, -5,  -8, -13, 1, 4, 7, 12},
+	{-2, -4,  -6, -13, 1, 3, 5, 12},
+	{-3, -6,  -8, -12, 2, 5, 7, 11},
+	{-3, -7,  -9, -11, 2, 6, 8, 10},
+	{-4, -7,  -8, -11, 3, 6, 7, 10},
+	{-3, -5,  -8, -11, 2, 4, 7, 10},
+	{-2, -6,  -8, -10, 1, 5, 7,  9},
+	{-2, -5,  -8, -10, 1, 4, 7,  9},
+	{-2, -4,  -8, -10, 1, 3, 7,  9},
+	{-2, -5,  -7, -10, 1, 4, 6,  9},
+	{-3, -4,  -7, -10, 2, 3, 6,  9},
+	{-1, -2,  -3, -10, 0, 1, 2,  9},
+	{-4, -6,  -8,  -9, 3, 5, 7,  8},
+	{-3, -5,  -7,  -9, 2, 4, 6,  8}
+};
+
+static
+int
+eac_encode(const Block & block, int base, int multiplier, int table, int best_error, uint64_t & bits)
+{
+	int				error		= 0;
+	uint64_t	indices	= 0;
+
+	for(int y=0; (y<4) && (error < best_error); ++y)
+		for(int x=0; x<4; ++x)
+		{
+			const int a = alpha(block[(y * 4) + x]);
+			int best	= MAX_ERROR;
+			int index	= 0;
+			for(int i=0; i<8; ++i)
+			{
+				const int i_error = square(std::clamp(base + (EAC_MODIFIERS[table][i] * multiplier), 0, 255) - a);
+				if(i_error < best)
+				{
+					best	= i_error;
+					index	= i;
+				}
+			}
+			error		+= best;
+			indices	|= uint64_t(index) << (45 - (((x * 4) + y) * 3));
+		}
+
+	if(error < best_error)
+		bits = (uint64_t(base) << 56) | (uint64_t(multiplier) << 52) | (uint64_t(table) << 48) | indices;
+
+	return error;
+}
+
+static
+void
+encode_eac_alpha(const Block & block, bool b_high_quality, uint8_t * p_out)
+{
+	int a_min = 255;
+	int a_max = 0;
+	for(auto pixel : block)
+	{
+		a_min = std::min(a_min, alpha(pixel));
+		a_max = std::max(a_max, alpha(pixel));
+	}
+
+	int				best_error	= MAX_ERROR;
+	uint64_t	best_bits		= 0;
+	const int	spread			= b_high_quality ? 2 : 0;
+
+	for(int table=0; (table<16) && (best_error > 0); ++table)
+	{
+		// Centre the table's range of modifiers on the range of alpha values.
+		const int range				= EAC_MODIFIERS[table][7] - EAC_MODIFIERS[table][3];
+		const int multiplier	= std::clamp((a_max - a_min + (range / 2)) / range, 1, 15);
+		const int base				= ((a_max + a_min) - ((EAC_MODIFIERS[table][7] + EAC_MODIFIERS[table][3]) * multiplier) + 1) / 2;
+
+		for(int m = std::max(1, multiplier - (spread / 2)); m <= std::min(15, multiplier + (spread / 2)); ++m)
+			for(int b = base - spread; b <= base + spread; ++b)
+				best_error = std::min(best_error, eac_encode(block, std::clamp(b, 0, 255), m, table, best_error, best_bits));
+	}
+
+	write_u64_be(p_out, best_bits);
+}
+
+static
+void
+decode_eac_alpha(const uint8_t * p_data, Block & block)
+{
+	const uint64_t	bits				= read_u64_be(p_data);
+	const int				base				= (bits >> 56) & 0x0FF;
+	const int				multiplier	= (bits >> 52) & 0x0F;
+	const int				table				= (bits >> 48) & 0x0F;
+
+	for(int y=0; y<4; ++y)
+		for(int x=0; x<4; ++x)
+		{
+			const int index = (bits >> (45 - (((x * 4) + y) * 3))) & 7;
+			const int a			= std::clamp(base + (EAC_MODIFIERS[table][index] * multiplier), 0, 255);
+			block[(y * 4) + x] = (block[(y * 4) + x] & 0x0FFFFFFU) | (uint32_t(a) << 24);
+		}
+}
+
+//=============================================================================
+//
+//	Images
+//
+//=============================================================================
+static
+void
+encode_block(const Block & block, uint8_t pixel_format, bool b_high_quality, uint8_t * p_out)
+{
+	switch(pixel_format)
+	{
+		case gap::image::pixelformat::BC1 :
+			encode_bc1_colour(block, true, b_high_quality, p_out);
+			break;
+
+		case gap::image::pixelformat::BC3 :
+			encode_bc_alpha(block, b_high_quality, p_out);
+			encode_bc1_colour(block, false, b_high_quality, p_out + 8);
+			break;
+
+		case gap::image::pixelformat::ETC1 :
+		case gap::image::pixelformat::ETC2 :
+			encode_etc_colour(block, b_high_quality, p_out);
+			break;
+
+		case gap::image::pixelformat::ETC2_RGBA :
+			encode_eac_alpha(block, b_high_quality, p_out);
+			encode_etc_colour(block, b_high_quality, p_out + 8);
+			break;
+
+		default : break;
+	}
+}
+
+static
+void
+decode_block(const uint8_t * p_data, uint8_t pixel_format, Block & block)
+{
+	switch(pixel_format)
+	{
+		case gap::image::pixelformat::BC1 :
+			decode_bc1_colour(p_data, false, block);
+			break;
+
+		case gap::image::pixelformat::BC3 :
+			decode_bc1_colour(p_data + 8, true, block);
+			decode_bc_alpha(p_data, block);
+			break;
+
+		case gap::image::pixelformat::ETC1 :
+		case gap::image::pixelformat::ETC2 :
+			decode_etc_colour(p_data, block);
+			break;
+
+		case gap::image::pixelformat::ETC2_RGBA :
+			decode_etc_colour(p_data + 8, block);
+			decode_eac_alpha(p_data, block);
+			break;
+
+		default : break;
+	}
+}
+
+std::vector<uint8_t>
+compress_blocks(const uint32_t * p_pixels, int stride, int width, int height, uint8_t pixel_format, bool b_high_quality)
+{
+	const int block_bytes = gap::image::pixelformat::block_bytes(pixel_format);
+	if((block_bytes == 0) || (width <= 0) || (height <= 0))
+		return {};
+
+	const int blocks_x = (width + 3) / 4;
+	const int blocks_y = (height + 3) / 4;
+
+	std::vector<uint8_t> data(std::size_t(blocks_x) * blocks_y * block_bytes);
+
+	auto encode_row = [&](int by)
+	{
+		Block block;
+		for(int bx=0; bx<blocks_x; ++bx)
+		{
+			for(int y=0; y<4; ++y)
+			{
+				const uint32_t * p_line = p_pixels + (std::size_t(std::min((by * 4) + y, height - 1)) * stride);
+				for(int x=0; x<4; ++x)
+					block[(y * 4) + x] = p_line[std::min((bx * 4) + x, width - 1)];
+			}
+
+			encode_block(block, pixel_format, b_high_quality, data.data() + (((std::size_t(by) * blocks_x) + bx) * block_bytes));
+		}
+	};
+
+	// ----- Each row of blocks is independent. Small images are not worth a thread. -----
+	std::atomic<int> next = 0;
+
+	auto worker = [&]
+	{
+		for(int by = next++; by < blocks_y; by = next++)
+			encode_row(by);
+	};
+
+	const std::size_t block_count		= std::size_t(blocks_x) * blocks_y;
+	const std::size_t thread_count	= std::clamp<std::size_t>(std::min<std::size_t>(blocks_y, block_count / MIN_BLOCKS_PER_THREAD), 1, std::max(1U, std::thread::hardware_concurrency()));
+	{
+		std::vector<std::jthread> threads;
+		for(std::size_t i=1; i<thread_count; ++i)
+			threads.emplace_back(worker);
+		worker();
+	}
+
+	return data;
+}
+
+std::vector<uint32_t>
+decompress_blocks(std::span<const uint8_t> data, int width, int height, uint8_t pixel_format)
+{
+	const int block_bytes = gap::image::pixelformat::block_bytes(pixel_format);
+	if(	(block_bytes == 0) || (width <= 0) || (height <= 0) ||
+			(data.size() < std::size_t(gap::image::pixelformat::image_data_size(pixel_format, width, height))) )
+		return {};
+
+	const int blocks_x = (width + 3) / 4;
+	const int blocks_y = (height + 3) / 4;
+
+	std::vector<uint32_t> image(std::size_t(width) * height);
+
+	Block block;
+	for(int by=0; by<blocks_y; ++by)
+		for(int bx=0; bx<blocks_x; ++bx)
+		{
+			decode_block(data.data() + (((std::size_t(by) * blocks_x) + bx) * block_bytes), pixel_format, block);
+
+			for(int y=0; (y<4) && (((by * 4) + y) < height); ++y)
+				for(int x=0; (x<4) && (((bx * 4) + x) < width); ++x)
+					image[(std::size_t((by * 4) + y) * width) + (bx * 4) + x] = block[(y * 4) + x];
+		}
+
+	return image;
+}
+
+} // namespace gap::image
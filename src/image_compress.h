@@ -0,0 +1,44 @@
+//=============================================================================
+//	FILE:					image_compress.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Block compressed texture formats (BC1, BC3, ETC1, ETC2)
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_COMPRESS_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_COMPRESS_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace gap::image
+{
+
+//-----------------------------------------------------------------------------
+//	The image is split into 4x4 pixel blocks which are stored left to right,
+//	top to bottom. Each block is 8 bytes (BC1, ETC1, ETC2) or 16 bytes (BC3,
+//	ETC2_RGBA). Blocks that extend past the right or bottom edge of the image
+//	repeat the edge pixels. Rows of blocks are encoded in parallel.
+//
+//	BC1 stores pixels with alpha below 128 as transparent. ETC2 data only uses
+//	the ETC1 compatible individual and differential modes so ETC1 and ETC2
+//	share an encoder.
+//
+//	The fast mode fits the colours of each block to their principal axis (BC)
+//	or average (ETC). The high quality mode refines BC endpoints with a least
+//	squares fit and searches neighbouring ETC base colours and more alpha
+//	ranges. It is several times slower and is meant for release builds.
+//-----------------------------------------------------------------------------
+std::vector<uint8_t>	compress_blocks(const uint32_t * p_pixels, int stride, int width, int height, uint8_t pixel_format, bool b_high_quality);
+
+// Reference decoder. Expands block data to ARGB8888. Returns an empty vector
+// if the data is too small for the image.
+std::vector<uint32_t>	decompress_blocks(std::span<const uint8_t> data, int width, int height, uint8_t pixel_format);
+
+} // namespace gap::image
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_COMPRESS_H
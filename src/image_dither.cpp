@@ -0,0 +1,190 @@
+//=============================================================================
+//	FILE:					image_dither.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Premultiplied alpha and dithering for reduced depth pixel
+//								formats
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+#include "image_dither.h"
+#include "image.h"
+
+namespace gap::image
+{
+
+//-----------------------------------------------------------------------------
+//	The number of bits that encode_pixel() keeps for each colour channel.
+//	Luminance formats keep a single channel which is dithered once and
+//	copied to red, green and blue.
+//-----------------------------------------------------------------------------
+struct ChannelBits
+{
+	std::array<int,3>		bits						= {8,8,8};			// Red, Green, Blue
+	bool								b_luminance			= false;
+
+	bool								is_full_depth() const	{return (bits[0] >= 8) && (bits[1] >= 8) && (bits[2] >= 8);}
+	int									channel_count() const	{return b_luminance ? 1 : 3;}
+};
+
+static constexpr int CHANNEL_SHIFT[3] = {16, 8, 0};
+
+static constexpr
+ChannelBits
+channel_bits(uint8_t pixel_format)
+{
+	switch(pixel_format)
+	{
+		case gap::image::pixelformat::RGB565 :		return ChannelBits{{5,6,5}, false};
+		case gap::image::pixelformat::ARGB1555 :	return ChannelBits{{5,5,5}, false};
+		case gap::image::pixelformat::ARGB4444 :	return ChannelBits{{4,4,4}, false};
+		case gap::image::pixelformat::AL44 :
+		case gap::image::pixelformat::L4 :				return ChannelBits{{4,4,4}, true};
+		default : break;
+	}
+	return ChannelBits{};
+}
+
+// Replace the colour channels with the luminance that encode_pixel() uses.
+static inline
+uint32_t
+to_grey(uint32_t colour)
+{
+	const uint32_t l = (((colour >> 16) & 0x0FF) + ((colour >> 8) & 0x0FF) + (colour & 0x0FF)) / 3;
+	return (colour & 0xFF000000U) | (l * 0x010101U);
+}
+
+static inline
+uint32_t
+set_channels(uint32_t alpha, const int * p_values, const ChannelBits & format)
+{
+	uint32_t colour = alpha;
+	for(int c=0; c<3; ++c)
+		colour |= uint32_t(p_values[format.b_luminance ? 0 : c]) << CHANNEL_SHIFT[c];
+	return colour;
+}
+
+void
+premultiply_alpha(std::span<uint32_t> pixels)
+{
+	for(auto & pixel : pixels)
+		pixel = premultiply(pixel);
+}
+
+//-----------------------------------------------------------------------------
+//	Ordered dither. Each channel is scaled to the output range and a 4x4
+//	Bayer threshold decides whether it rounds up or down, so flat areas
+//	between two output levels become a regular pattern of both.
+//-----------------------------------------------------------------------------
+static constexpr uint8_t BAYER_4X4[4][4] =
+{
+	{ 0,  8,  2, 10},
+	{12,  4, 14,  6},
+	{ 3, 11,  1,  9},
+	{15,  7, 13,  5}
+};
+
+static
+void
+dither_ordered(std::span<uint32_t> pixels, int width, int height, const ChannelBits & format)
+{
+	const int channels = format.channel_count();
+
+	for(int y=0; y<height; ++y)
+	{
+		const uint8_t * p_thresholds = BAYER_4X4[y & 3];
+		uint32_t * p_line = pixels.data() + (std::size_t(y) * width);
+
+		for(int x=0; x<width; ++x)
+		{
+			const uint32_t colour = format.b_luminance ? to_grey(p_line[x]) : p_line[x];
+			const int threshold = (((p_thresholds[x & 3] * 2) + 1) * 255) / 32;		// Centre of each 1/16th of [0,255)
+
+			int values[3];
+			for(int c=0; c<channels; ++c)
+			{
+				const int bits	= format.bits[c];
+				const int max		= (1 << bits) - 1;
+				const int level	= ((int((colour >> CHANNEL_SHIFT[c]) & 0x0FF) * max) + threshold) / 255;
+				values[c] = level << (8 - bits);
+			}
+
+			p_line[x] = set_channels(colour & 0xFF000000U, values, format);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+//	Floyd-Steinberg error diffusion. Each channel is rounded to the nearest
+//	output level and the difference from the level's expanded 8 bit value is
+//	passed on to the neighbouring pixels (7/16 right, 3/16, 5/16 and 1/16 to
+//	the line below).
+//-----------------------------------------------------------------------------
+static
+void
+dither_diffusion(std::span<uint32_t> pixels, int width, int height, const ChannelBits & format)
+{
+	const int channels = format.channel_count();
+
+	// Errors are held in 1/16ths for the current and next lines, with a spare
+	// entry at each end so that the edges need no special cases.
+	std::vector<int> current((width + 2) * channels, 0);
+	std::vector<int> next((width + 2) * channels, 0);
+
+	for(int y=0; y<height; ++y)
+	{
+		std::fill(begin(next), end(next), 0);
+		uint32_t * p_line = pixels.data() + (std::size_t(y) * width);
+
+		for(int x=0; x<width; ++x)
+		{
+			const uint32_t colour = format.b_luminance ? to_grey(p_line[x]) : p_line[x];
+
+			int values[3];
+			for(int c=0; c<channels; ++c)
+			{
+				const int bits	= format.bits[c];
+				const int max		= (1 << bits) - 1;
+				const int i			= ((x + 1) * channels) + c;
+
+				const int v					= std::clamp(int((colour >> CHANNEL_SHIFT[c]) & 0x0FF) + ((current[i] + 8) >> 4), 0, 255);
+				const int level			= ((v * max) + 127) / 255;
+				const int error			= v - (((level * 255) + (max / 2)) / max);
+
+				current[i + channels]	+= error * 7;
+				next[i - channels]		+= error * 3;
+				next[i]								+= error * 5;
+				next[i + channels]		+= error;
+
+				values[c] = level << (8 - bits);
+			}
+
+			p_line[x] = set_channels(colour & 0xFF000000U, values, format);
+		}
+
+		std::swap(current, next);
+	}
+}
+
+void
+dither(std::span<uint32_t> pixels, int width, int height, uint8_t pixel_format, uint8_t mode)
+{
+	const auto format = channel_bits(pixel_format);
+	if(format.is_full_depth())
+		return;
+
+	switch(mode)
+	{
+		case DITHER_ORDERED		: dither_ordered(pixels, width, height, format);		break;
+		case DITHER_DIFFUSION	: dither_diffusion(pixels, width, height, format);	break;
+		default : break;
+	}
+}
+
+} // namespace gap::image
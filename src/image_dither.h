@@ -0,0 +1,51 @@
+//=============================================================================
+//	FILE:					image_dither.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Premultiplied alpha and dithering for reduced depth pixel
+//								formats
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_DITHER_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_DITHER_H
+
+#include <cstdint>
+#include <span>
+
+namespace gap::image
+{
+
+// Multiply the colour channels of an ARGB8888 pixel by its alpha, rounded
+// to the nearest value.
+constexpr
+uint32_t
+premultiply(uint32_t colour)
+{
+	const uint32_t a = colour >> 24;
+	if(a == 255)	return colour;
+	if(a == 0)		return 0;
+
+	const uint32_t r = ((((colour >> 16) & 0x0FF) * a) + 127) / 255;
+	const uint32_t g = ((((colour >> 8) & 0x0FF) * a) + 127) / 255;
+	const uint32_t b = (((colour & 0x0FF) * a) + 127) / 255;
+	return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Multiply the colour channels of each ARGB8888 pixel by its alpha.
+void			premultiply_alpha(std::span<uint32_t> pixels);
+
+//-----------------------------------------------------------------------------
+//	Dither the colour (or luminance) channels of an ARGB8888 image ready for
+//	encoding to 'pixel_format'. The result is still ARGB8888, with each
+//	channel set so that encode_pixel()'s truncation produces the dithered
+//	value. Alpha is not dithered. Formats that keep 8 bits per colour channel
+//	are left unchanged.
+//-----------------------------------------------------------------------------
+void			dither(std::span<uint32_t> pixels, int width, int height, uint8_t pixel_format, uint8_t mode);
+
+} // namespace gap::image
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_DITHER_H
@@ -0,0 +1,198 @@
+//=============================================================================
+//	FILE:					image_palette.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Colour histograms and palette generation for the indexed
+//								pixel formats
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include "image_palette.h"
+#include "image.h"
+
+namespace gap::image
+{
+
+static constexpr int CHANNEL_SHIFT[4] = {24, 16, 8, 0};		// Alpha, Red, Green, Blue
+
+static inline
+uint32_t
+normalise(uint32_t colour)
+{
+	return (colour & 0xFF000000U) ? colour : 0;
+}
+
+void
+ColourHistogram::add(std::span<const uint32_t> pixels)
+{
+	for(auto pixel : pixels)
+		++m_counts[normalise(pixel)];
+}
+
+void
+ColourHistogram::add(const SourceImage & image, int x, int y, int width, int height)
+{
+	for(int iy=0; iy<height; ++iy)
+		for(int ix=0; ix<width; ++ix)
+			++m_counts[normalise(image.get_pixel(x + ix, y + iy))];
+}
+
+void
+ColourHistogram::merge(const ColourHistogram & other)
+{
+	for(const auto & [colour, count] : other.m_counts)
+		m_counts[colour] += count;
+}
+
+//=============================================================================
+//
+//	Median Cut
+//
+//	The colours start in a single box. The box with the greatest channel
+//	range, weighted by the number of pixels in it, is split at the median
+//	pixel of that channel until there is a box for each palette entry. Each
+//	entry is the average colour of the pixels in its box.
+//
+//=============================================================================
+struct Entry
+{
+	uint32_t		colour	= 0;
+	uint32_t		count		= 0;
+};
+
+struct Box
+{
+	std::size_t	begin				= 0;
+	std::size_t	end					= 0;
+	uint64_t		population	= 0;
+	int					channel			= 0;			// Channel with the widest range.
+	int					range				= 0;
+
+	uint64_t		score() const		{return (end - begin) > 1 ? uint64_t(range) * population : 0;}
+};
+
+static
+Box
+make_box(const std::vector<Entry> & entries, std::size_t begin, std::size_t end)
+{
+	Box box;
+	box.begin	= begin;
+	box.end		= end;
+
+	int low[4]	= {255, 255, 255, 255};
+	int high[4]	= {0, 0, 0, 0};
+
+	for(auto i = begin; i < end; ++i)
+	{
+		box.population += entries[i].count;
+		for(int c=0; c<4; ++c)
+		{
+			const int v = (entries[i].colour >> CHANNEL_SHIFT[c]) & 0x0FF;
+			low[c]	= std::min(low[c], v);
+			high[c]	= std::max(high[c], v);
+		}
+	}
+
+	for(int c=0; c<4; ++c)
+		if((high[c] - low[c]) > box.range)
+		{
+			box.range		= high[c] - low[c];
+			box.channel	= c;
+		}
+
+	return box;
+}
+
+static
+Entry
+average_colour(const std::vector<Entry> & entries, const Box & box)
+{
+	uint64_t sums[4] = {0, 0, 0, 0};
+	for(auto i = box.begin; i < box.end; ++i)
+		for(int c=0; c<4; ++c)
+			sums[c] += uint64_t((entries[i].colour >> CHANNEL_SHIFT[c]) & 0x0FF) * entries[i].count;
+
+	Entry average;
+	average.count = uint32_t(std::min<uint64_t>(box.population, UINT32_MAX));
+	for(int c=0; c<4; ++c)
+		average.colour |= uint32_t((sums[c] + (box.population / 2)) / box.population) << CHANNEL_SHIFT[c];
+	return average;
+}
+
+std::vector<uint32_t>
+build_palette(const ColourHistogram & histogram, int max_colours)
+{
+	std::vector<uint32_t>	palette;
+	std::vector<Entry>		entries;
+
+	for(const auto & [colour, count] : histogram.counts())
+	{
+		if(colour == 0)
+			palette.push_back(0);
+		else
+			entries.push_back({colour, count});
+	}
+
+	// Sorted so that the result does not depend on the order of the hash table.
+	std::sort(begin(entries), end(entries), [](const Entry & a, const Entry & b) {return a.colour < b.colour;});
+
+	auto by_count = [](const Entry & a, const Entry & b) {return a.count != b.count ? a.count > b.count : a.colour < b.colour;};
+
+	const int slots = max_colours - int(palette.size());
+	if(slots <= 0)
+		return palette;
+
+	if(std::cmp_less_equal(entries.size(), slots))
+	{
+		std::sort(begin(entries), end(entries), by_count);
+		for(const auto & entry : entries)
+			palette.push_back(entry.colour);
+		return palette;
+	}
+
+	std::vector<Box> boxes = {make_box(entries, 0, entries.size())};
+
+	while(std::cmp_less(boxes.size(), slots))
+	{
+		auto it = std::max_element(begin(boxes), end(boxes), [](const Box & a, const Box & b) {return a.score() < b.score();});
+		if(it->score() == 0)
+			break;
+
+		const Box		box		= *it;
+		const int		shift	= CHANNEL_SHIFT[box.channel];
+		std::sort(	begin(entries) + box.begin, begin(entries) + box.end,
+								[shift](const Entry & a, const Entry & b)
+								{
+									const uint32_t va = (a.colour >> shift) & 0x0FF;
+									const uint32_t vb = (b.colour >> shift) & 0x0FF;
+									return va != vb ? va < vb : a.colour < b.colour;
+								} );
+
+		// ----- Split at the median pixel, keeping at least one colour on each side. -----
+		uint64_t		sum		= 0;
+		std::size_t	split	= box.begin;
+		while(((split + 1) < box.end) && ((sum + entries[split].count) <= (box.population / 2)))
+			sum += entries[split++].count;
+		split = std::max(split, box.begin + 1);
+
+		*it = make_box(entries, box.begin, split);
+		boxes.push_back(make_box(entries, split, box.end));
+	}
+
+	std::vector<Entry> colours;
+	for(const auto & box : boxes)
+		colours.push_back(average_colour(entries, box));
+
+	std::sort(begin(colours), end(colours), by_count);
+	for(const auto & colour : colours)
+		palette.push_back(colour.colour);
+
+	return palette;
+}
+
+} // namespace gap::image
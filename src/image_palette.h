@@ -0,0 +1,54 @@
+//=============================================================================
+//	FILE:					image_palette.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Colour histograms and palette generation for the indexed
+//								pixel formats
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_PALETTE_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_PALETTE_H
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace gap::image
+{
+
+class SourceImage;
+
+//-----------------------------------------------------------------------------
+//	Number of pixels of each distinct ARGB8888 colour. Fully transparent
+//	pixels are all counted as 0x00000000 so that they share one entry.
+//-----------------------------------------------------------------------------
+class ColourHistogram
+{
+private:
+	std::unordered_map<uint32_t,uint32_t>		m_counts;
+
+public:
+	void						add(std::span<const uint32_t> pixels);
+	void						add(const SourceImage & image, int x, int y, int width, int height);
+	void						merge(const ColourHistogram & other);
+
+	std::size_t			size() const noexcept											{return m_counts.size();}
+	bool						contains(uint32_t colour) const						{return m_counts.contains(colour);}
+	const std::unordered_map<uint32_t,uint32_t> &	counts() const noexcept		{return m_counts;}
+};
+
+//-----------------------------------------------------------------------------
+//	Build a palette of at most 'max_colours' entries. If the histogram has
+//	that many colours or fewer they are used exactly, otherwise the colours
+//	are reduced by median cut. Transparent is entry 0 when it is present and
+//	the other entries are ordered by the number of pixels they cover.
+//-----------------------------------------------------------------------------
+std::vector<uint32_t>		build_palette(const ColourHistogram & histogram, int max_colours);
+
+} // namespace gap::image
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_PALETTE_H
@@ -0,0 +1,143 @@
+//=============================================================================
+//	FILE:					image_rle.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Run length (span list) encoding of sprite images
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include "image_rle.h"
+#include "image.h"
+
+namespace gap::image
+{
+
+static constexpr int MAX_RUN = 255;
+
+static inline
+bool
+is_transparent(uint32_t pixel)
+{
+	return (pixel & 0xFF000000U) == 0;
+}
+
+static inline
+void
+append_value(std::vector<uint8_t> & data, uint32_t value, int size, bool big_endian)
+{
+	for(int c=0;c<size;++c)
+		data.push_back((big_endian ? (value >> (((size-1)-c)*8)) : (value >> (c*8))) & 0x0FF);
+}
+
+static inline
+uint32_t
+read_u32(std::span<const uint8_t> data, std::size_t offset, bool big_endian)
+{
+	uint32_t value = 0;
+	for(int c=0;c<4;++c)
+		value |= uint32_t(data[offset + c]) << (big_endian ? (3-c)*8 : c*8);
+	return value;
+}
+
+std::vector<uint8_t>
+rle_encode(std::span<const uint32_t> pixels, int width, int height, uint8_t pixel_format, bool big_endian)
+{
+	pixel_format = gap::image::pixelformat::base_format(pixel_format);
+	const int bpp = gap::image::pixelformat::bytes_per_pixel(pixel_format);
+
+	// ----- Line offset table, filled in as each line is encoded. -----
+	std::vector<uint8_t> data(std::size_t(height) * 4, 0);
+
+	for(int y=0; y<height; ++y)
+	{
+		const uint32_t line_offset = data.size();
+		for(int c=0;c<4;++c)
+			data[(y*4) + c] = (big_endian ? (line_offset >> ((3-c)*8)) : (line_offset >> (c*8))) & 0x0FF;
+
+		const uint32_t * p_line = pixels.data() + (std::size_t(y) * width);
+
+		for(int x=0; x<width;)
+		{
+			const int start = x;
+			while((x < width) && is_transparent(p_line[x]))
+				++x;
+			if(x == width)
+				break;
+
+			int skip = x - start;
+			while(skip > MAX_RUN)
+			{
+				data.push_back(MAX_RUN);
+				data.push_back(0);
+				skip -= MAX_RUN;
+			}
+
+			const int run_start = x;
+			while((x < width) && !is_transparent(p_line[x]))
+				++x;
+
+			for(int run = run_start; run < x; run += MAX_RUN, skip = 0)
+			{
+				const int count = std::min(MAX_RUN, x - run);
+				data.push_back(skip);
+				data.push_back(count);
+				for(int i=0; i<count; ++i)
+					append_value(data, gap::image::pixelformat::encode_pixel(p_line[run + i], pixel_format), bpp, big_endian);
+			}
+		}
+
+		// ----- End of line -----
+		data.push_back(0);
+		data.push_back(0);
+	}
+
+	return data;
+}
+
+std::vector<uint8_t>
+rle_decode(std::span<const uint8_t> data, int width, int height, uint8_t pixel_format, bool big_endian)
+{
+	pixel_format = gap::image::pixelformat::base_format(pixel_format);
+	const std::size_t bpp = gap::image::pixelformat::bytes_per_pixel(pixel_format);
+
+	if((bpp == 0) || (data.size() < (std::size_t(height) * 4)))
+		return {};
+
+	std::vector<uint8_t> image(std::size_t(width) * height * bpp, 0);
+
+	for(int y=0; y<height; ++y)
+	{
+		std::size_t offset = read_u32(data, std::size_t(y) * 4, big_endian);
+		uint8_t * p_line = image.data() + (std::size_t(y) * width * bpp);
+		int x = 0;
+
+		for(;;)
+		{
+			if((offset + 2) > data.size())
+				return {};
+
+			const int skip	= data[offset];
+			const int count	= data[offset + 1];
+			offset += 2;
+
+			if((skip == 0) && (count == 0))
+				break;
+
+			x += skip;
+			const std::size_t size = count * bpp;
+			if(((x + count) > width) || ((offset + size) > data.size()))
+				return {};
+
+			std::copy_n(data.data() + offset, size, p_line + (x * bpp));
+			offset	+= size;
+			x				+= count;
+		}
+	}
+
+	return image;
+}
+
+} // namespace gap::image
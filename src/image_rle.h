@@ -0,0 +1,43 @@
+//=============================================================================
+//	FILE:					image_rle.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Run length (span list) encoding of sprite images
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_RLE_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_RLE_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace gap::image
+{
+
+//-----------------------------------------------------------------------------
+//	An RLE image starts with a table of HEIGHT 32 bit offsets, one per line,
+//	from the start of the image data to the line's spans. Each line is a list
+//	of spans -
+//
+//		SKIP (u8)		Number of transparent pixels to skip.
+//		COUNT (u8)	Number of pixels that follow.
+//		PIXELS			COUNT pixels in the base pixel format.
+//
+//	and is terminated by a span with SKIP and COUNT both zero. Runs longer than
+//	255 pixels are split across spans. Transparent pixels at the end of a line
+//	are not stored. A pixel is transparent if its source alpha is zero.
+//-----------------------------------------------------------------------------
+std::vector<uint8_t>	rle_encode(std::span<const uint32_t> pixels, int width, int height, uint8_t pixel_format, bool big_endian);
+
+// Reference decoder. Expands RLE data to the raw base pixel format with
+// transparent pixels set to zero. Returns an empty vector if the data is
+// malformed.
+std::vector<uint8_t>	rle_decode(std::span<const uint8_t> data, int width, int height, uint8_t pixel_format, bool big_endian);
+
+} // namespace gap::image
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_RLE_H
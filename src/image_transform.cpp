@@ -0,0 +1,244 @@
+//=============================================================================
+//	FILE:					image_transform.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Arbitrary angle image rotation
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include "image_transform.h"
+#include "image_dither.h"
+
+namespace gap::image
+{
+
+static constexpr int				FRACTION_BITS		= 16;
+static constexpr int64_t		FIXED_ONE				= int64_t(1) << FRACTION_BITS;
+
+//=============================================================================
+//
+//	PIXEL HELPERS
+//
+//=============================================================================
+
+static inline
+uint32_t
+unpremultiply(uint32_t colour)
+{
+	// Reciprocal of each alpha value in 16.16 fixed point.
+	static const auto s_reciprocal = []
+	{
+		std::array<uint32_t,256> table{};
+		for(uint32_t a=1; a<256; ++a)
+			table[a] = ((255U << 16) + (a / 2)) / a;
+		return table;
+	}();
+
+	const uint32_t a = colour >> 24;
+	if(a == 255)	return colour;
+	if(a == 0)		return 0;
+
+	const uint32_t recip = s_reciprocal[a];
+	const uint32_t r = std::min<uint32_t>(((((colour >> 16) & 0x0FF) * recip) + 0x8000) >> 16, 255);
+	const uint32_t g = std::min<uint32_t>(((((colour >> 8) & 0x0FF) * recip) + 0x8000) >> 16, 255);
+	const uint32_t b = std::min<uint32_t>((((colour & 0x0FF) * recip) + 0x8000) >> 16, 255);
+	return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+// Linear interpolation of all four channels. 'f' is the weight of 'c2' in
+// the range 0-256. Two channels are processed at a time.
+static inline
+uint32_t
+lerp(uint32_t c1, uint32_t c2, uint32_t f)
+{
+	const uint32_t rb = ((((c1 & 0x00FF00FF) * (256 - f)) + ((c2 & 0x00FF00FF) * f)) >> 8) & 0x00FF00FF;
+	const uint32_t ag = ((((c1 >> 8) & 0x00FF00FF) * (256 - f)) + (((c2 >> 8) & 0x00FF00FF) * f)) & 0xFF00FF00;
+	return ag | rb;
+}
+
+//=============================================================================
+//
+//	ROTATION SOURCE
+//
+//=============================================================================
+
+RotationSource::RotationSource(const uint32_t * p_pixels, int width, int height)
+	: m_pixels(std::size_t(width + 2) * (height + 2), 0U)
+	, m_width(width)
+	, m_height(height)
+	, m_stride(width + 2)
+{
+	for(int y=0; y<height; ++y)
+	{
+		const uint32_t * p_src 	= p_pixels + (std::size_t(y) * width);
+		uint32_t * 			 p_dest = m_pixels.data() + (std::size_t(y + 1) * m_stride) + 1;
+		for(int x=0; x<width; ++x)
+			p_dest[x] = premultiply(p_src[x]);
+	}
+}
+
+//=============================================================================
+//
+//	ROTATE
+//
+//	Each destination pixel centre is mapped back into the source -
+//
+//		src = origin + (dx*cos + dy*sin, dy*cos - dx*sin)
+//
+//	where (dx,dy) is the offset of the pixel centre from the destination
+//	origin. The mapping is linear so the source coordinate is stepped
+//	incrementally, in fixed point, along each row.
+//
+//=============================================================================
+
+Rotation::Rotation(double angle)
+	: sin_a(std::sin(angle * (M_PI / 180.0)))
+	, cos_a(std::cos(angle * (M_PI / 180.0)))
+{
+}
+
+RotatedImage
+rotate(const RotationSource & source, const Rotation & rotation, int x_origin, int y_origin)
+{
+	RotatedImage result;
+
+	const double c 		= rotation.cos_a;
+	const double s 		= rotation.sin_a;
+
+	//---------------------------------------------------------------------------
+	//	Bounding box of the rotated source rectangle, relative to the origin.
+	//	The box is grown by a pixel on each side to take in the filtered edge.
+	//---------------------------------------------------------------------------
+	double min_x = std::numeric_limits<double>::max();
+	double min_y = std::numeric_limits<double>::max();
+	double max_x = std::numeric_limits<double>::lowest();
+	double max_y = std::numeric_limits<double>::lowest();
+
+	for(const auto & [cx, cy] : {	std::pair{0, 0}, std::pair{source.width(), 0},
+															std::pair{0, source.height()}, std::pair{source.width(), source.height()} } )
+	{
+		const double dx = cx - x_origin;
+		const double dy = cy - y_origin;
+		const double rx = (dx * c) - (dy * s);
+		const double ry = (dx * s) + (dy * c);
+		min_x = std::min(min_x, rx);	max_x = std::max(max_x, rx);
+		min_y = std::min(min_y, ry);	max_y = std::max(max_y, ry);
+	}
+
+	const int left 		= (int)std::floor(min_x) - 1;
+	const int top 		= (int)std::floor(min_y) - 1;
+	const int width		= ((int)std::ceil(max_x) + 1) - left;
+	const int height	= ((int)std::ceil(max_y) + 1) - top;
+
+	std::vector<uint32_t> buffer(std::size_t(width) * height, 0U);
+
+	//---------------------------------------------------------------------------
+	//	Scan the box. Coordinates are in source pixel centre space (pixel 'i'
+	//	is centred on 0) so that the integer part addresses the top left of the
+	//	2x2 filter footprint.
+	//---------------------------------------------------------------------------
+	const int64_t step_u	= std::llround(c * FIXED_ONE);
+	const int64_t step_v	= std::llround(-s * FIXED_ONE);
+
+	const uint32_t max_u	= source.width();			// Footprint top left may be -1 to width-1
+	const uint32_t max_v	= source.height();
+
+	int crop_left 	= width;
+	int crop_right	= -1;
+	int crop_top		= height;
+	int crop_bottom	= -1;
+
+	for(int y=0; y<height; ++y)
+	{
+		const double dx = (left + 0.5);
+		const double dy = (top + y + 0.5);
+		int64_t u = std::llround(((x_origin - 0.5) + (dx * c) + (dy * s)) * FIXED_ONE);
+		int64_t v = std::llround(((y_origin - 0.5) - (dx * s) + (dy * c)) * FIXED_ONE);
+
+		uint32_t * p_dest = buffer.data() + (std::size_t(y) * width);
+
+		for(int x=0; x<width; ++x, u += step_u, v += step_v)
+		{
+			const int iu = (int)(u >> FRACTION_BITS);
+			const int iv = (int)(v >> FRACTION_BITS);
+
+			if((uint32_t(iu + 1) > max_u) || (uint32_t(iv + 1) > max_v))
+				continue;
+
+			const uint32_t fu = (uint32_t(u) >> (FRACTION_BITS - 8)) & 0x0FF;
+			const uint32_t fv = (uint32_t(v) >> (FRACTION_BITS - 8)) & 0x0FF;
+
+			const uint32_t * p0 = source.address(iu, iv);
+			const uint32_t * p1 = p0 + source.stride();
+
+			const uint32_t colour = lerp(lerp(p0[0], p0[1], fu), lerp(p1[0], p1[1], fu), fv);
+			if((colour >> 24) == 0)
+				continue;
+
+			p_dest[x] = unpremultiply(colour);
+
+			crop_left 	= std::min(crop_left, x);
+			crop_right 	= std::max(crop_right, x);
+			crop_top 		= std::min(crop_top, y);
+			crop_bottom = y;
+		}
+	}
+
+	if(crop_right < 0)
+		return result;
+
+	//---------------------------------------------------------------------------
+	//	Crop to the visible pixels.
+	//---------------------------------------------------------------------------
+	result.width 		= (crop_right - crop_left) + 1;
+	result.height 	= (crop_bottom - crop_top) + 1;
+	result.x_origin	= -(left + crop_left);
+	result.y_origin	= -(top + crop_top);
+	result.pixels.resize(std::size_t(result.width) * result.height);
+
+	for(int y=0; y<result.height; ++y)
+	{
+		const uint32_t * p_src = buffer.data() + (std::size_t(crop_top + y) * width) + crop_left;
+		std::copy(p_src, p_src + result.width, result.pixels.data() + (std::size_t(y) * result.width));
+	}
+
+	return result;
+}
+
+std::vector<RotatedImage>
+rotate(const RotationSource & source, std::span<const double> angles, int x_origin, int y_origin)
+{
+	std::vector<Rotation> rotations;
+	rotations.reserve(angles.size());
+	for(double angle : angles)
+		rotations.emplace_back(angle);
+
+	std::vector<RotatedImage> results(angles.size());
+	std::atomic<std::size_t> next = 0;
+
+	auto worker = [&]
+	{
+		for(std::size_t i = next++; i < rotations.size(); i = next++)
+			results[i] = rotate(source, rotations[i], x_origin, y_origin);
+	};
+
+	const std::size_t thread_count = std::min<std::size_t>(rotations.size(), std::max(1U, std::thread::hardware_concurrency()));
+	{
+		std::vector<std::jthread> threads;
+		for(std::size_t i=1; i<thread_count; ++i)
+			threads.emplace_back(worker);
+		worker();
+	}
+
+	return results;
+}
+
+} // namespace gap::image
@@ -0,0 +1,79 @@
+//=============================================================================
+//	FILE:					image_transform.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Arbitrary angle image rotation
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_TRANSFORM_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_TRANSFORM_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace gap::image
+{
+
+//-----------------------------------------------------------------------------
+//	A premultiplied alpha copy of an ARGB8888 image with a one pixel
+//	transparent border. The border lets the bilinear filter read the 2x2
+//	neighbourhood of any sample without clamping, and premultiplying stops
+//	the colour of transparent pixels bleeding into the edges.
+//-----------------------------------------------------------------------------
+class RotationSource
+{
+private:
+	std::vector<uint32_t>		m_pixels;
+	int											m_width		= 0;
+	int											m_height	= 0;
+	int											m_stride	= 0;
+
+public:
+	RotationSource(const uint32_t * p_pixels, int width, int height);
+
+	int											width() const							{return m_width;}
+	int											height() const						{return m_height;}
+	int											stride() const						{return m_stride;}
+
+	// Address of pixel (x,y). x and y may be -1 to address the border.
+	const uint32_t *				address(int x, int y) const		{return m_pixels.data() + ((y + 1) * m_stride) + (x + 1);}
+};
+
+struct RotatedImage
+{
+	std::vector<uint32_t>		pixels;
+	int											width			= 0;
+	int											height		= 0;
+	int											x_origin	= 0;
+	int											y_origin	= 0;
+};
+
+struct Rotation
+{
+	double									sin_a			= 0.0;
+	double									cos_a			= 1.0;
+
+	Rotation() = default;
+	explicit Rotation(double angle);
+};
+
+//-----------------------------------------------------------------------------
+//	Rotate 'source' clockwise by 'angle' degrees around (x_origin,y_origin).
+//	The result is cropped to its non-transparent pixels and the origin is
+//	returned relative to the cropped image. A fully transparent result has
+//	zero width and height.
+//-----------------------------------------------------------------------------
+RotatedImage								rotate(const RotationSource & source, const Rotation & rotation, int x_origin, int y_origin);
+inline RotatedImage					rotate(const RotationSource & source, double angle, int x_origin, int y_origin)		{return rotate(source, Rotation(angle), x_origin, y_origin);}
+
+// Rotate the same source by each of 'angles'. The angles are shared out
+// between worker threads and the results are returned in the same order.
+std::vector<RotatedImage>		rotate(const RotationSource & source, std::span<const double> angles, int x_origin, int y_origin);
+
+} // namespace gap::image
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_IMAGE_TRANSFORM_H
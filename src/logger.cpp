@@ -0,0 +1,99 @@
+//=============================================================================
+//	FILE:					logger.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Levelled, buffered console output
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include "logger.h"
+
+namespace gap::logger
+{
+
+static constexpr std::size_t	BUFFER_SIZE = 64 * 1024;
+
+class OutputBuffer
+{
+private:
+	std::mutex		m_mutex;
+	std::string		m_buffer;
+
+public:
+	OutputBuffer()	{m_buffer.reserve(BUFFER_SIZE);}
+	~OutputBuffer()	{flush();}
+
+	void	append(std::string_view text)
+				{
+					std::lock_guard lock(m_mutex);
+
+					if((m_buffer.size() + text.size()) > BUFFER_SIZE)
+					{
+						write_out();
+						if(text.size() > BUFFER_SIZE)
+						{
+							std::fwrite(text.data(), 1, text.size(), stdout);
+							return;
+						}
+					}
+
+					m_buffer.append(text);
+				}
+
+	void	flush()
+				{
+					std::lock_guard lock(m_mutex);
+					write_out();
+					std::fflush(stdout);
+				}
+
+private:
+	void	write_out()
+				{
+					if(!m_buffer.empty())
+						std::fwrite(m_buffer.data(), 1, m_buffer.size(), stdout);
+					m_buffer.clear();
+				}
+};
+
+static std::atomic<int>		sg_level = NORMAL;
+static OutputBuffer				sg_output;
+
+void
+set_level(int level)
+{
+	sg_level.store(level < QUIET ? QUIET : (level > TRACE ? TRACE : level), std::memory_order_relaxed);
+}
+
+int
+level()
+{
+	return sg_level.load(std::memory_order_relaxed);
+}
+
+void
+write(int level, std::string_view text)
+{
+	if(enabled(level))
+		sg_output.append(text);
+}
+
+void
+flush()
+{
+	sg_output.flush();
+}
+
+void
+write_error(std::string_view text)
+{
+	sg_output.flush();
+	std::fwrite(text.data(), 1, text.size(), stderr);
+}
+
+} // namespace gap::logger
@@ -0,0 +1,64 @@
+//=============================================================================
+//	FILE:					logger.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Levelled, buffered console output
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_LOGGER_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_LOGGER_H
+
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace gap::logger
+{
+
+enum
+{
+	QUIET,						// Errors only
+	NORMAL,						// Progress
+	VERBOSE,					// Per asset details
+	TRACE							// Debug dumps (tilemaps etc)
+};
+
+void		set_level(int level);
+int			level();
+inline bool	enabled(int level)		{return level <= gap::logger::level();}
+
+//-----------------------------------------------------------------------------
+//	Output is accumulated in a buffer and written to stdout in large batches.
+//	The buffer is flushed when it fills, before an error is written to stderr
+//	and at exit.
+//-----------------------------------------------------------------------------
+void		write(int level, std::string_view text);
+void		flush();
+
+template<typename... Args>
+void		print(int level, std::format_string<Args...> fmt, Args &&... args)
+				{
+					if(enabled(level))
+						write(level, std::format(fmt, std::forward<Args>(args)...) + '\n');
+				}
+
+template<typename... Args> void	info(std::format_string<Args...> fmt, Args &&... args)		{print(NORMAL, fmt, std::forward<Args>(args)...);}
+template<typename... Args> void	verbose(std::format_string<Args...> fmt, Args &&... args)	{print(VERBOSE, fmt, std::forward<Args>(args)...);}
+template<typename... Args> void	trace(std::format_string<Args...> fmt, Args &&... args)		{print(TRACE, fmt, std::forward<Args>(args)...);}
+
+// Errors are always written, unbuffered, to stderr.
+void		write_error(std::string_view text);
+
+template<typename... Args>
+void		error(std::format_string<Args...> fmt, Args &&... args)
+				{
+					write_error(std::format(fmt, std::forward<Args>(args)...) + '\n');
+				}
+
+} // namespace gap::logger
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_LOGGER_H
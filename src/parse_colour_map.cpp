@@ -17,11 +17,17 @@
 #include <memory>
 #include <mutex>
 #include <filesystem>
+#include <algorithm>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include "parse_colour_map.h"
-#include "utility/loadfile.h"
-#include "utility/tokenize.h"
+#include "utility/line_scanner.h"
 #include "filesystem.h"
 #include "export.h"
+#include "image.h"
+#include "logger.h"
 
 
 //=============================================================================
@@ -43,64 +49,200 @@ GIMP Palette
 */
 
 
+static
+uint32_t
+make_colour(uint32_t red, uint32_t green, uint32_t blue, uint32_t alpha = 0x0FF)
+{
+	return ((alpha & 0x0FF) << 24) | ((red & 0x0FF) << 16) | ((green & 0x0FF) << 8) | (blue & 0x0FF);
+}
+
+// Parse 'count' decimal fields from the start of 'line'.
+static
+bool
+parse_fields(std::string_view line, uint32_t * p_values, int count)
+{
+	for(int i=0;i<count;++i)
+		if(!ade::parse_number(ade::next_field(line),p_values[i]))
+			return false;
+	return true;
+}
+
 static
 gap::assets::ColourMap
-load_gimp_palette( const std::string & filename, gap::FileSystem & filesystem )
+load_gimp_palette( std::span<const std::uint8_t> data )
 {
-	const auto data = filesystem.load(filename);
+	gap::assets::ColourMap cmap;
+
+	ade::LineScanner scanner(data);
+	std::string_view line;
+	while(scanner.next(line))
+	{
+		line = ade::trim(line.substr(0,line.find('#')));
+		if( line.empty() || line.starts_with("GIMP Palette") || line.starts_with("Name:") || line.starts_with("Columns:") )
+			continue;
 
-	std::string line;
+		uint32_t c[3];
+		if(parse_fields(line,c,3))
+			cmap.colourmap.push_back(make_colour(c[0],c[1],c[2]));
+	}
 
-	auto parse_line = [](const std::string & line, gap::assets::ColourMap & cmap)
-		{
-			auto tokens = ade::tokenize(line," \t");
-			if(tokens.size() >= 3)
-			{
-				uint32_t c[3];
-				for(int i=0;i<3;++i)
-				{
-					auto token = std::string(tokens[i]);
-					c[i] = std::strtoul(token.c_str(),nullptr,10) & 0x0FF;
-				}
-				cmap.colourmap.push_back( 0x0FF000000 | (c[0]<<16) | (c[1]<<8) | c[2] );
-			}
-		};
+	return cmap;
+}
 
+//=============================================================================
+//
+//	JASC PALETTE (Paint Shop Pro)
+//
+//=============================================================================
+/*
+JASC-PAL
+0100
+47
+24 20 59
+49 37 110
+*/
+
+static
+gap::assets::ColourMap
+load_jasc_palette( std::span<const std::uint8_t> data )
+{
 	gap::assets::ColourMap cmap;
-	cmap.source = filename;
 
-	for(auto ch : data)
+	ade::LineScanner scanner(data);
+	std::string_view line;
+	std::size_t count = 0;
+
+	if(	!scanner.next(line) || (ade::trim(line) != "JASC-PAL") ||
+			!scanner.next(line) ||
+			!scanner.next(line) || !ade::parse_number(ade::trim(line),count) )
 	{
-		if((ch == 13) || (ch == 10))
-		{
-			auto pos = line.find_first_of("#");
-			if(pos != std::string::npos)
-				line = line.substr(0,pos);
-			if( !line.empty() && !(line.substr(0,12) == "GIMP Palette") )
-				parse_line(line,cmap);
-			line.clear();
-		}
-		else
-			line.push_back(ch);
+		gap::logger::error("COLOURMAP: Invalid JASC-PAL header!");
+		return cmap;
 	}
 
-	if( !line.empty() && (line.substr(0,12) != "GIMP Palette") )
-		parse_line(line,cmap);
+	cmap.colourmap.reserve(count);
+	while((cmap.colourmap.size() < count) && scanner.next(line))
+	{
+		uint32_t c[4] = {0,0,0,0x0FF};			// Alpha is optional.
+		if(parse_fields(line,c,4) || parse_fields(line,c,3))
+			cmap.colourmap.push_back(make_colour(c[0],c[1],c[2],c[3]));
+	}
 
 	return cmap;
 }
 
+//=============================================================================
+//
+//	HEX PALETTES (paint.net .txt and .hex)
+//
+//	One colour per line as RRGGBB or AARRGGBB hex digits, optionally starting
+//	with '#'. paint.net comment lines start with ';'.
+//
+//=============================================================================
+static
+gap::assets::ColourMap
+load_hex_palette( std::span<const std::uint8_t> data )
+{
+	gap::assets::ColourMap cmap;
 
+	ade::LineScanner scanner(data);
+	std::string_view line;
+	while(scanner.next(line))
+	{
+		line = ade::trim(line.substr(0,line.find(';')));
+		if(line.starts_with('#'))
+			line.remove_prefix(1);
 
-gap::assets::ColourMap 	load_colour_map( const std::string & filename, gap::FileSystem & filesystem )
+		uint32_t colour = 0;
+		if(((line.size() == 6) || (line.size() == 8)) && ade::parse_number(line,colour,16))
+			cmap.colourmap.push_back(line.size() == 6 ? colour | 0xFF000000U : colour);
+	}
+
+	return cmap;
+}
+
+//=============================================================================
+//
+//	PNG SWATCH
+//
+//	Each distinct colour in the image, in the order that it is first found
+//	scanning left to right, top to bottom. Transparent pixels are skipped so
+//	swatches drawn at any scale or with gaps between the colours can be used.
+//
+//=============================================================================
+static
+gap::assets::ColourMap
+load_png_swatch( const std::string & filename, gap::FileSystem & filesystem )
+{
+	gap::assets::ColourMap cmap;
+
+	auto p_image = gap::image::load(filename,filesystem);
+	if(p_image == nullptr)
+		return cmap;
+
+	std::unordered_set<uint32_t> colours;
+	for(int y=0;y<p_image->height();++y)
+		for(int x=0;x<p_image->width();++x)
+		{
+			const uint32_t colour = p_image->get_pixel(x,y);
+			if(((colour & 0xFF000000U) != 0) && colours.insert(colour).second)
+				cmap.colourmap.push_back(colour);
+		}
+
+	return cmap;
+}
+
+//=============================================================================
+//
+//	LOAD
+//
+//	Loaded colour maps are kept by path so that a palette shared by several
+//	scripts or commands is only read and parsed once.
+//
+//=============================================================================
+static
+gap::assets::ColourMap
+load_colour_map_file( const std::string & filename, gap::FileSystem & filesystem )
 {
 	std::filesystem::path path(filename);
 	auto ext = path.extension().string();
 	std::transform(begin(ext),end(ext),begin(ext),::toupper);
 
-	if(ext == ".GPL")		return load_gimp_palette(filename, filesystem);
+	if(ext == ".PNG")
+		return load_png_swatch(filename,filesystem);
 
+	const auto data = filesystem.load(filename);
+	if(data.empty())
+		return {};
 
+	if(ext == ".GPL")		return load_gimp_palette(data);
+	if(ext == ".PAL")		return load_jasc_palette(data);
+	if(ext == ".TXT")		return load_hex_palette(data);
+	if(ext == ".HEX")		return load_hex_palette(data);
+
+	gap::logger::error("COLOURMAP: Unsupported colour map file type '{}'!",path.extension().string());
 	return {};
 }
 
+gap::assets::ColourMap 	load_colour_map( const std::string & filename, gap::FileSystem & filesystem )
+{
+	static std::mutex																						s_mutex;
+	static std::unordered_map<std::string,gap::assets::ColourMap>	s_cache;
+
+	const auto key = std::filesystem::path(filename).lexically_normal().generic_string();
+
+	{
+		std::lock_guard lock(s_mutex);
+		if(auto it = s_cache.find(key); it != s_cache.end())
+			return it->second;
+	}
+
+	auto cmap = load_colour_map_file(filename,filesystem);
+	if(cmap.empty())
+		return cmap;
+
+	cmap.source = filename;
+
+	std::lock_guard lock(s_mutex);
+	return s_cache.try_emplace(key,std::move(cmap)).first->second;
+}
@@ -19,6 +19,7 @@
 #include "parse_gap.h"
 #include "parse_colour_map.h"
 #include "utility/hash.h"
+#include "utility/tokenize.h"
 
 #define GAPCMD_LOADIMAGE				"loadimage"
 #define GAPCMD_IMAGE						"image"
@@ -36,6 +37,9 @@
 #define GAPCMD_FILE							"file"
 #define GAPCMD_COLOURMAP				"colourmap"
 #define GAPCMD_SOUNDSAMPLE			"soundsample"
+#define GAPCMD_SAMPLERATE				"samplerate"
+#define GAPCMD_ATLAS						"atlas"
+#define GAPCMD_TRIM							"trim"
 
 using namespace std::literals::string_literals;
 
@@ -219,9 +223,12 @@ ParserGAP::parse_line(std::string_view line,int line_number)
 		case ade::hash::hash_ascii_string_as_lower(GAPCMD_FILE) :						result = command_file(line_number,cmd); 					break;
 		case ade::hash::hash_ascii_string_as_lower(GAPCMD_COLOURMAP) :			result = command_colourmap(line_number,cmd); 			break;
 		case ade::hash::hash_ascii_string_as_lower(GAPCMD_SOUNDSAMPLE) :		result = command_soundsample(line_number,cmd); 		break;
+		case ade::hash::hash_ascii_string_as_lower(GAPCMD_SAMPLERATE) :			result = command_samplerate(line_number,cmd); 		break;
+		case ade::hash::hash_ascii_string_as_lower(GAPCMD_ATLAS) :					result = command_atlas(line_number,cmd); 					break;
+		case ade::hash::hash_ascii_string_as_lower(GAPCMD_TRIM) :						result = command_trim(line_number,cmd); 					break;
 
 		default :
-			std::cerr << "GAP: Unknown command '" << cmd.command << "'\n";
+			gap::logger::error("GAP: Unknown command '{}'", cmd.command);
 			result = -1;
 			break;
 	}
@@ -243,6 +250,7 @@ ParserGAP::command_loadimage(int line_number, const CommandLine & command)
 
 	std::string src;
 	std::string format;
+	std::string colourmap;
 
 	for(const auto & [key,value] : command.args)
 	{
@@ -251,6 +259,8 @@ ParserGAP::command_loadimage(int line_number, const CommandLine & command)
 		{
 			case ade::hash::hash_ascii_string_as_lower("src") 		:	src 		= value; break;
 			case ade::hash::hash_ascii_string_as_lower("format") 	:	format 	= value; break;
+			case ade::hash::hash_ascii_string_as_lower("colourmap") :
+			case ade::hash::hash_ascii_string_as_lower("colormap") 	:	colourmap	= value; break;
 			default :
 				// TODO: Warning - unknown arg
 				break;
@@ -260,19 +270,40 @@ ParserGAP::command_loadimage(int line_number, const CommandLine & command)
 	if(src.empty())
 		return on_error(line_number,"Missing image path!");
 
-	auto p_image = gap::image::load(src,m_filesystem);
-	if(p_image == nullptr)
-		return on_error(line_number,std::string("Failed to load image! - ") + src);
-
+	uint8_t pf = 0;
 	if(!format.empty())
 	{
-		auto pf = gap::image::parse_pixelformat_name(format);
+		pf = gap::image::parse_pixelformat_name(format);
 		if(pf == 0)
 			return on_error(line_number,std::string("Unknown Pixel Format! - ") + format);
-		p_image->set_target_pixelformat(pf);
 	}
 
-	m_current_source_image = m_p_assets->add_source_image(std::move(p_image));
+	m_source_colourmap = -1;
+	if(!colourmap.empty() && ((m_source_colourmap = m_p_assets->find_colour_map(colourmap)) < 0))
+		return on_error(line_number,"Unknown colour map '" + colourmap + "'!");
+
+	// ----- An image that has already been loaded is shared rather than decoded again. -----
+	const auto file = m_filesystem.load(src);
+	if(file.empty())
+		return on_error(line_number,std::string("Failed to load image! - ") + src);
+
+	const auto hash = ade::hash::hash_bytes(file.data(),file.size());
+
+	m_current_source_image = m_p_assets->find_source_image(src,hash,pf);
+	if(m_current_source_image >= 0)
+	{
+		gap::logger::verbose("LOADIMAGE: {} is already loaded, using source image {}",src,m_current_source_image);
+		return 0;
+	}
+
+	auto p_image = gap::image::decode(file);
+	if(p_image == nullptr)
+		return on_error(line_number,std::string("Failed to load image! - ") + src);
+
+	if(pf != 0)
+		p_image->set_target_pixelformat(pf);
+
+	m_current_source_image = m_p_assets->add_source_image(std::move(p_image),src,hash);
 
 //	std::cout << "  Image added into slot " << m_current_source_image << std::endl;
 
@@ -283,7 +314,8 @@ int
 ParserGAP::command_imagegroup(int line_number, const CommandLine & command)
 {
 
-	int 					base 	= 0;
+	int 					base 		= 0;
+	int						colours	= 256;
 	std::string		name;
 
 	for(const auto & [key,value] : command.args)
@@ -294,6 +326,8 @@ ParserGAP::command_imagegroup(int line_number, const CommandLine & command)
 		{
 			case ade::hash::hash_ascii_string_as_lower("base") 		:	base	= std::strtol(value.c_str(),nullptr,10); 	break;
 			case ade::hash::hash_ascii_string_as_lower("name") 		:	name	= value; 	break;
+			case ade::hash::hash_ascii_string_as_lower("colours")	:
+			case ade::hash::hash_ascii_string_as_lower("colors")	:	colours	= std::strtol(value.c_str(),nullptr,10); 	break;
 
 			default :
 				// TODO: Warning - unknown arg
@@ -304,7 +338,10 @@ ParserGAP::command_imagegroup(int line_number, const CommandLine & command)
 	if(name.empty())
 		return on_error(line_number, "Missing parameter 'name' in imagegroup!");
 
-	auto group = m_p_assets->add_image_group(name, base);
+	if((colours < 1) || (colours > 256))
+		return on_error(line_number, std::format("Invalid 'colours' value {} in imagegroup! Must be 1 to 256.",colours));
+
+	auto group = m_p_assets->add_image_group(name, base, colours);
 	if(group < 0)
 		return on_error(line_number, std::format("Failed to add imagegroup '{}'!",name));
 
@@ -312,11 +349,70 @@ ParserGAP::command_imagegroup(int line_number, const CommandLine & command)
 }
 
 int
-ParserGAP::command_image(int /*line_number*/, const CommandLine & command)
+ParserGAP::command_atlas(int line_number, const CommandLine & command)
+{
+	gap::assets::AtlasSettings settings = m_p_assets->atlas_settings();
+	settings.b_enabled = true;
+
+	for(const auto & [key,value] : command.args)
+	{
+		auto hash = ade::hash::hash_ascii_string_as_lower(key.c_str(),key.size());
+
+		switch(hash)
+		{
+			case ade::hash::hash_ascii_string_as_lower("enable") 	:	settings.b_enabled		= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0); 	break;
+			case ade::hash::hash_ascii_string_as_lower("w") 			:
+			case ade::hash::hash_ascii_string_as_lower("width") 	:	settings.page_width		= std::strtol(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("h") 			:
+			case ade::hash::hash_ascii_string_as_lower("height") 	:	settings.page_height	= std::strtol(value.c_str(),nullptr,10); 	break;
+
+			default :
+				// TODO: Warning - unknown arg
+				break;
+		}
+	}
+
+	if((settings.page_width < 1) || (settings.page_width > 0x0FFFF) || (settings.page_height < 1) || (settings.page_height > 0x0FFFF))
+		return on_error(line_number, std::format("Invalid atlas page size {}x{}!",settings.page_width,settings.page_height));
+
+	m_p_assets->set_atlas_settings(settings);
+
+	gap::logger::verbose("ATLAS: {}, page size {}x{}", settings.b_enabled ? "enabled" : "disabled", settings.page_width, settings.page_height);
+
+	return 0;
+}
+
+int
+ParserGAP::command_trim(int /*line_number*/, const CommandLine & command)
+{
+	m_b_trim = true;
+
+	for(const auto & [key,value] : command.args)
+	{
+		auto hash = ade::hash::hash_ascii_string_as_lower(key.c_str(),key.size());
+
+		switch(hash)
+		{
+			case ade::hash::hash_ascii_string_as_lower("enable") 	:	m_b_trim = value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0); 	break;
+
+			default :
+				// TODO: Warning - unknown arg
+				break;
+		}
+	}
+
+	return 0;
+}
+
+int
+ParserGAP::command_image(int line_number, const CommandLine & command)
 {
 	//TODO: Add 'scale' parameters
 
 	gap::image::Image	image;
+	image.b_trim 			= m_b_trim;
+	image.colour_map	= m_source_colourmap;
+	std::string				colourmap;
 
 	bool 		b_width 						= false;
 	bool 		b_height						= false;
@@ -353,6 +449,11 @@ ParserGAP::command_image(int /*line_number*/, const CommandLine & command)
 			case ade::hash::hash_ascii_string_as_lower("vf") 					:
 			case ade::hash::hash_ascii_string_as_lower("vflip")				:	image.b_vflip		= !!std::strtol(value.c_str(),nullptr,10);	break;
 
+			case ade::hash::hash_ascii_string_as_lower("trim")				:	image.b_trim		= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0);	break;
+
+			case ade::hash::hash_ascii_string_as_lower("premultiply")	:	image.encode.b_premultiply	= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0);	break;
+			case ade::hash::hash_ascii_string_as_lower("dither")			:	image.encode.dither					= gap::image::parse_dither_name(value);	break;
+
 			case ade::hash::hash_ascii_string_as_lower("angle") 			:
 			case ade::hash::hash_ascii_string_as_lower("rotate")			:	image.angle			= std::strtof(value.c_str(),nullptr); b_have_angle = true;	break;
 
@@ -368,6 +469,8 @@ ParserGAP::command_image(int /*line_number*/, const CommandLine & command)
 			case ade::hash::hash_ascii_string_as_lower("pf") 					:
 			case ade::hash::hash_ascii_string_as_lower("format")			:	image.pixel_format = gap::image::parse_pixelformat_name(value); break;
 			case ade::hash::hash_ascii_string_as_lower("name") 				:	image.name 			= value; break;
+			case ade::hash::hash_ascii_string_as_lower("colourmap")		:
+			case ade::hash::hash_ascii_string_as_lower("colormap")		:	colourmap				= value; break;
 
 			case ade::hash::hash_ascii_string_as_lower("count")				: count						=	std::strtol(value.c_str(),nullptr,10); 	break;
 
@@ -392,6 +495,9 @@ ParserGAP::command_image(int /*line_number*/, const CommandLine & command)
 	if(image.pixel_format == 0)
 		image.pixel_format = m_p_assets->get_target_pixelformat(m_current_source_image);
 
+	if(!colourmap.empty() && ((image.colour_map = m_p_assets->find_colour_map(colourmap)) < 0))
+		return on_error(line_number,"Unknown colour map '" + colourmap + "'!");
+
 	if((image.width <= 0) || (image.height <= 0))
 		return 0;
 
@@ -439,8 +545,12 @@ ParserGAP::command_imagearray(int line_number, const CommandLine & command)
 	int 				yorigin	= 0;
 	bool				hflip		= false;
 	bool				vflip		= false;
+	bool				trim		= m_b_trim;
+	gap::image::EncodeOptions	encode;
 	uint8_t 		format 	= 0;
+	int					colour_map	= m_source_colourmap;
 	std::string	name;
+	std::string	colourmap;
 
 	for(const auto & [key,value] : command.args)
 	{
@@ -469,7 +579,12 @@ ParserGAP::command_imagearray(int line_number, const CommandLine & command)
 			case ade::hash::hash_ascii_string_as_lower("vf") 			:
 			case ade::hash::hash_ascii_string_as_lower("vmirror") :
 			case ade::hash::hash_ascii_string_as_lower("vflip")		:	vflip			= !!std::strtol(value.c_str(),nullptr,10);	break;
+			case ade::hash::hash_ascii_string_as_lower("trim")		:	trim			= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0);	break;
+			case ade::hash::hash_ascii_string_as_lower("premultiply")	:	encode.b_premultiply	= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0);	break;
+			case ade::hash::hash_ascii_string_as_lower("dither")	:	encode.dither	= gap::image::parse_dither_name(value);	break;
 			case ade::hash::hash_ascii_string_as_lower("name") 		:	name 			= value; break;
+			case ade::hash::hash_ascii_string_as_lower("colourmap") :
+			case ade::hash::hash_ascii_string_as_lower("colormap")	:	colourmap	= value; break;
 			default :
 				// TODO: Warning - unknown arg
 				break;
@@ -481,6 +596,9 @@ ParserGAP::command_imagearray(int line_number, const CommandLine & command)
 	if(width <= 0) 		return on_error(line_number,std::string("Invalid/Missing 'width' parameter!"));
 	if(height <= 0) 	return on_error(line_number,std::string("Invalid/Missing 'height' parameter!"));
 
+	if(!colourmap.empty() && ((colour_map = m_p_assets->find_colour_map(colourmap)) < 0))
+		return on_error(line_number,"Unknown colour map '" + colourmap + "'!");
+
 	for(int yi = 0;yi < ycount;++yi)
 	{
 		for(int xi = 0;xi < xcount;++xi)
@@ -495,6 +613,9 @@ ParserGAP::command_imagearray(int line_number, const CommandLine & command)
 			image.pixel_format	= format;
 			image.b_hflip				= hflip;
 			image.b_vflip				= vflip;
+			image.b_trim				= trim;
+			image.encode				= encode;
+			image.colour_map		= colour_map;
 			image.source_image	= m_current_source_image;
 			if(!name.empty())
 				image.name = std::format("{}_{}_{}",name,xi,yi);
@@ -588,6 +709,8 @@ int
 ParserGAP::command_tileset(int line_number, const CommandLine & command)
 {
 	gap::tileset::TileSet	tileset;
+	tileset.colour_map = m_source_colourmap;
+	std::string						colourmap;
 
 	for(const auto & [key,value] : command.args)
 	{
@@ -602,6 +725,12 @@ ParserGAP::command_tileset(int line_number, const CommandLine & command)
 			case ade::hash::hash_ascii_string_as_lower("pf") 			:
 			case ade::hash::hash_ascii_string_as_lower("format")	:	tileset.pixel_format 	= gap::image::parse_pixelformat_name(value); break;
 			case ade::hash::hash_ascii_string_as_lower("name") 		:	tileset.name 					= value; break;
+			case ade::hash::hash_ascii_string_as_lower("premultiply")	:	tileset.encode.b_premultiply	= value.empty() || (std::strtol(value.c_str(),nullptr,10) != 0);	break;
+			case ade::hash::hash_ascii_string_as_lower("dither")	:	tileset.encode.dither	= gap::image::parse_dither_name(value);	break;
+			case ade::hash::hash_ascii_string_as_lower("colours")	:
+			case ade::hash::hash_ascii_string_as_lower("colors")	:	tileset.palette_size	= std::strtol(value.c_str(),nullptr,10);	break;
+			case ade::hash::hash_ascii_string_as_lower("colourmap") :
+			case ade::hash::hash_ascii_string_as_lower("colormap")	:	colourmap							= value; break;
 			default :
 				// TODO: Warning - unknown arg
 				break;
@@ -621,6 +750,15 @@ ParserGAP::command_tileset(int line_number, const CommandLine & command)
 		if(tileset.pixel_format == 0)
 			tileset.pixel_format = m_p_assets->get_target_pixelformat(m_current_source_image);
 
+		if(gap::image::pixelformat::is_rle(tileset.pixel_format))
+			return on_error(line_number,std::string("Run length encoded pixel formats can not be used for tilesets!"));
+
+		if((tileset.palette_size < 1) || (tileset.palette_size > 256))
+			return on_error(line_number,std::format("Invalid 'colours' value {}! Must be 1 to 256.",tileset.palette_size));
+
+		if(!colourmap.empty() && ((tileset.colour_map = m_p_assets->find_colour_map(colourmap)) < 0))
+			return on_error(line_number,"Unknown colour map '" + colourmap + "'!");
+
 		m_p_assets->add_tileset(tileset);
 	}
 
@@ -958,9 +1096,12 @@ ID                           Numerical identifier of the tileset.
 NAME                         Name of the tilemap that can be used for searching.
 W or WIDTH                   Width, in tiles. (If omitted, assumes dimension of loaded tilemap)
 H or HEIGHT                  Height, in tiles. (If omitted, assumes dimension of loaded tilemap)
-BLKSIZE or BLOCKSIZE         Block Size, in tiles. Default = 8. (This represents the width and height of the blocks)
+BLKSIZE or BLOCKSIZE         Block Size, in tiles, from 1 to 255. Default = 8. (This represents the width and height of the blocks)
 TILESIZE                     Tile size, in bytes. Default = auto. (If not specified, will detect size based upon the data)
 LAYER                        The layer to use as the source of tile data. Default = 0
+LAYERS                       A list of layers, eg. "1,2,3", that are stored together in this tilemap.
+LAYOUT                       The order of the blocks and the tiles in them. ROWMAJOR, MORTON (or ZORDER) or HILBERT.
+FLAGS                        A list of tile properties, eg. "solid,ladder,hazard", to store as a bit per tile.
 */
 
 int
@@ -974,7 +1115,9 @@ ParserGAP::command_tilemap(int line_number, const CommandLine & command)
 	uint32_t 			height			= 0;
 	uint32_t 			blocksize		= 8;
 	uint32_t 			tilesize		= 0;
-	uint32_t 			layer_id		= 0;
+	std::vector<uint32_t>	layer_ids;
+	std::string						layout;
+	std::vector<std::string>	flag_names;
 
 	//---------------------------------------------------------------------------
 	//	Parse Arguments
@@ -988,12 +1131,27 @@ ParserGAP::command_tilemap(int line_number, const CommandLine & command)
 			case ade::hash::hash_ascii_string_as_lower("id") 					:	id				= std::strtol(value.c_str(),nullptr,10); 	break;
 			case ade::hash::hash_ascii_string_as_lower("x") 					:	x			 		= std::strtol(value.c_str(),nullptr,10); 	break;
 			case ade::hash::hash_ascii_string_as_lower("y") 					:	y					= std::strtol(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("w") 					:	[[fallthrough]];
 			case ade::hash::hash_ascii_string_as_lower("width") 			:	width 		= std::strtol(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("h") 					:	[[fallthrough]];
 			case ade::hash::hash_ascii_string_as_lower("height") 			:	height		= std::strtol(value.c_str(),nullptr,10); 	break;
 			case ade::hash::hash_ascii_string_as_lower("blksize") 		:	[[fallthrough]];
 			case ade::hash::hash_ascii_string_as_lower("blocksize") 	:	blocksize = std::strtol(value.c_str(),nullptr,10); 	break;
 			case ade::hash::hash_ascii_string_as_lower("tilesize") 		:	tilesize 	= std::strtol(value.c_str(),nullptr,10); 	break;
-			case ade::hash::hash_ascii_string_as_lower("layer") 			:	layer_id 	= std::strtol(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("layer") 			:	layer_ids = {uint32_t(std::strtol(value.c_str(),nullptr,10))}; break;
+			case ade::hash::hash_ascii_string_as_lower("layout") 			:	layout		= value; break;
+			case ade::hash::hash_ascii_string_as_lower("flags") 			:
+				flag_names.clear();
+				for(const auto & flag : ade::tokenize(value, ",; "))
+					if(!flag.empty())
+						flag_names.emplace_back(flag);
+				break;
+			case ade::hash::hash_ascii_string_as_lower("layers") 			:
+				layer_ids.clear();
+				for(const auto & layer : ade::tokenize(value, ",; "))
+					if(!layer.empty())
+						layer_ids.push_back(std::strtol(layer.data(),nullptr,10));
+				break;
 			default :
 				// TODO: Warning - unknown arg
 				break;
@@ -1008,62 +1166,129 @@ ParserGAP::command_tilemap(int line_number, const CommandLine & command)
 
 	m_p_current_tilemap->enumerate_layers([&](const gap::tilemap::SourceTileMapLayer & layer)->bool
 		{
-			std::cout << std::format("LAYER: {:5} :{:24}: {}x{}\n", layer.m_id, layer.m_name, layer.m_width, layer.m_height);
+			gap::logger::verbose("LAYER: {:5} :{:24}: {}x{}", layer.m_id, layer.m_name, layer.m_width, layer.m_height);
 			return true;
 		});
 
-	auto p_layer = m_p_current_tilemap->get_layer(layer_id);
-	if(p_layer == nullptr)
-		return on_error(line_number,std::format("Layer {} not found in tilemap!", layer_id));
-	const auto & layer = *p_layer;
+	if(layer_ids.empty())
+		layer_ids.push_back(0);
 
-	if(blocksize == 0)
-		return on_error(line_number,std::format("Invalid Block Size (0)!"));
+	if(layer_ids.size() > 255)
+		return on_error(line_number,std::format("Too many layers ({})! A tilemap may have up to 255 layers.", layer_ids.size()));
 
-	if(layer.m_data.empty())
-		return on_error(line_number,std::format("Layer {} is empty!", layer_id));
+	std::vector<const gap::tilemap::SourceTileMapLayer *> layers;
+	for(auto layer_id : layer_ids)
+	{
+		auto p_layer = m_p_current_tilemap->get_layer(layer_id);
+		if(p_layer == nullptr)
+			return on_error(line_number,std::format("Layer {} not found in tilemap!", layer_id));
+		if(p_layer->empty())
+			return on_error(line_number,std::format("Layer {} is empty!", layer_id));
+		if(!layers.empty() && ((p_layer->m_width != layers.front()->m_width) || (p_layer->m_height != layers.front()->m_height)))
+			return on_error(line_number,std::format("Layer {} is not the same size as layer {}!", layer_id, layer_ids.front()));
+		layers.push_back(p_layer);
+	}
+	const auto & layer = *layers.front();
 
-	if((x>=layer.m_width) || (y>layer.m_height))
+	auto tilemap_layout = gap::tilemap::LAYOUT_ROW_MAJOR;
+	switch(ade::hash::hash_ascii_string_as_lower(layout.c_str(),layout.size()))
+	{
+		case ade::hash::hash_ascii_string_as_lower("") 						:	[[fallthrough]];
+		case ade::hash::hash_ascii_string_as_lower("rowmajor") 		:	tilemap_layout = gap::tilemap::LAYOUT_ROW_MAJOR;	break;
+		case ade::hash::hash_ascii_string_as_lower("zorder") 			:	[[fallthrough]];
+		case ade::hash::hash_ascii_string_as_lower("morton") 			:	tilemap_layout = gap::tilemap::LAYOUT_MORTON;			break;
+		case ade::hash::hash_ascii_string_as_lower("hilbert") 		:	tilemap_layout = gap::tilemap::LAYOUT_HILBERT;		break;
+		default :
+			return on_error(line_number,std::format("Unknown tilemap layout '{}'! Expected ROWMAJOR, MORTON or HILBERT.", layout));
+	}
+
+	if((blocksize == 0) || (blocksize > 255))
+		return on_error(line_number,std::format("Invalid Block Size ({})! The block size must be from 1 to 255.", blocksize));
+
+	if((x>=layer.m_width) || (y>=layer.m_height))
 		return on_error(line_number,std::format("Specified coordinates ({},{}) are outside of the tilemap area!", x,y));
 
 	if(width == 0)		width 		= layer.m_width - x;
 	if(height == 0)		height 		= layer.m_height - y;
 	if(name.empty())	name			= layer.m_name;
 
-	if((width == 0) || (height == 0))
-		return on_error(line_number,std::format("Specified dimensions ({},{}) are too small", width, height));
+	if((width > (layer.m_width - x)) || (height > (layer.m_height - y)))
+		return on_error(line_number,std::format("Specified area ({},{} {}x{}) extends outside of the {}x{} tilemap area!", x, y, width, height, layer.m_width, layer.m_height));
+
+	if((width > 0xFFFF) || (height > 0xFFFF))
+		return on_error(line_number,std::format("Specified dimensions ({},{}) are too large! Tilemaps may be up to 65535x65535.", width, height));
+
+	if(flag_names.size() > 32)
+		return on_error(line_number,std::format("Too many flags ({})! A tilemap may have up to 32 flags.", flag_names.size()));
+
+	uint64_t largest_tile = 0;
+	for(auto p_layer : layers)
+		largest_tile = std::max(largest_tile, p_layer->largest_tile());
+
+	if(!flag_names.empty() && (largest_tile > 0xFFFF))
+		return on_error(line_number,std::format("Tile {} is too large to have flags! FLAGS may only be used with tiles up to 65535.", largest_tile));
 
 	if(tilesize == 0)
 	{
-		auto largest = *std::max_element(begin(layer.m_data), end(layer.m_data));
+		auto largest = largest_tile;
 		uint32_t bits=0;
 		for(int i=0;(i<32) && (largest!=0);++i, ++bits, largest >>= 1)
 			;
 		tilesize = (bits+7)/8;
 	}
 
-	std::println("TILEMAP: id:{} name:'{}' pos:{},{} size:{}x{} blksize:{} tilesize:{}", id, name, x, y, width, height, blocksize, tilesize);
+	gap::logger::verbose("TILEMAP: id:{} name:'{}' pos:{},{} size:{}x{} blksize:{} tilesize:{} layers:{}", id, name, x, y, width, height, blocksize, tilesize, layers.size());
 
 	uint32_t blocks_wide = std::max<uint32_t>(1,(width+(blocksize-1))/blocksize);
 	uint32_t blocks_high = std::max<uint32_t>(1,(height+(blocksize-1))/blocksize);
 
-	std::println("TILEMAP: Blocks Wide: {} Blocks High: {}",blocks_wide, blocks_high);
+	gap::logger::verbose("TILEMAP: Blocks Wide: {} Blocks High: {}",blocks_wide, blocks_high);
 
 	//---------------------------------------------------------------------------
 	//	Create TileMap
 	//---------------------------------------------------------------------------
-	auto p_tilemap = std::make_unique<gap::tilemap::TileMap>(id, name, width, height, blocksize, tilesize);
+	auto p_tilemap = std::make_unique<gap::tilemap::TileMap>(id, name, width, height, blocksize, tilesize, uint32_t(layers.size()));
+	p_tilemap->set_layout(tilemap_layout);
 
-	for(uint32_t iy=y, h=0; h<height; ++h, ++iy)
+	// ----- Flags for every tile value that is used, from the tile properties. -----
+	if(!flag_names.empty())
 	{
-		for(uint32_t ix=x, w=0; w<width; ++w, ++ix)
+		const auto & tileset = m_p_current_tilemap->get_tileset();
+		if(tileset.tile_properties.empty() && tileset.tile_classes.empty())
+			gap::logger::info("TILEMAP: Line {}: The tileset has no tile properties, no tiles will have flags", line_number);
+		auto tile_flags = tileset.tile_flags(flag_names, largest_tile);
+
+		gap::logger::verbose("TILEMAP: {} tile flags for {} tiles", flag_names.size(), tile_flags.size());
+		p_tilemap->set_tile_flags(std::move(flag_names), std::move(tile_flags));
+	}
+
+	// The map is read a row of blocks at a time, from every layer, so that the
+	// source rows of all of the layers of a block are read together. Blocks
+	// whose tiles are all zero, including the blocks of an infinite map that
+	// are not covered by any chunk, stay empty and take no space.
+	bool b_full = false;
+	for(uint32_t by=0; !b_full && (by<height); by+=blocksize)
+	{
+		for(uint32_t ilayer=0; !b_full && (ilayer<layers.size()); ++ilayer)
 		{
-			uint64_t 	tile = layer.get_tile(ix,iy);
-			p_tilemap->set(ix,iy,tile);
+			layers[ilayer]->enumerate_rects(x, y + by, width, std::min(blocksize, height - by),
+				[&](uint32_t rx, uint32_t ry, uint32_t rwidth, uint32_t rheight, std::span<const uint64_t> tiles, std::size_t stride)
+				{
+					b_full = b_full || !p_tilemap->assign_rect(tiles, stride, rx, by + ry, rwidth, rheight, ilayer);
+				});
 		}
 	}
 
-	p_tilemap->print();
+	if(b_full)
+		return on_error(line_number,std::format("Tilemap '{}' has run out of blocks! A tilemap may have up to {} non-empty blocks.", name, gap::tilemap::MAX_BLOCKS));
+
+	// Identical blocks, in any layer, are only stored once and the blocks are
+	// numbered in layout order.
+	if(auto removed = p_tilemap->deduplicate_blocks(); removed > 0)
+		gap::logger::verbose("TILEMAP: {} duplicate blocks removed, {} blocks remain", removed, p_tilemap->active_block_count());
+
+	if(gap::logger::enabled(gap::logger::TRACE))
+		p_tilemap->print();
 
 	m_p_assets->add_tilemap(std::move(p_tilemap));
 
@@ -1087,15 +1312,36 @@ decode_sample_format(std::string fmt)
 	return gap::sound::FORMAT_S8;
 }
 
+int
+ParserGAP::command_samplerate(int line_number,const CommandLine & command)
+{
+	for(const auto & [key,value] : command.args)
+	{
+		auto hash = ade::hash::hash_ascii_string_as_lower(key.c_str(),key.size());
+		switch(hash)
+		{
+			case ade::hash::hash_ascii_string_as_lower("rate") 				:	m_sample_rate	= std::strtoul(value.c_str(),nullptr,10); 	break;
+			default :
+				break;
+		}
+	}
+
+	if(m_sample_rate > 0xFFFF)
+		return on_error(line_number,std::format("Invalid sample rate ({})! The rate must be from 1 to 65535.", m_sample_rate));
+
+	return 0;
+}
+
 int
 ParserGAP::command_soundsample(int line_number,const CommandLine & command)
 {
 	std::string 	name;
 	std::string		source;
+	std::string		srctype;
 	uint8_t				format			= 0;	// Required format.
 	uint8_t				srcformat		= 0;	// Source format hint, for RAW files.
-	uint16_t			srcrate			= 0;	// Source rate hint, for RAW files.
-	uint16_t			rate				= 0; 	// Desired rate
+	uint32_t			srcrate			= 0;	// Source rate hint, for RAW files.
+	uint32_t			rate				= 0; 	// Desired rate
 
 	//---------------------------------------------------------------------------
 	//	Parse Arguments
@@ -1107,18 +1353,44 @@ ParserGAP::command_soundsample(int line_number,const CommandLine & command)
 		{
 			case ade::hash::hash_ascii_string_as_lower("name") 				:	name 			= value; break;
 			case ade::hash::hash_ascii_string_as_lower("src") 				:	source		= value; break;
+			case ade::hash::hash_ascii_string_as_lower("srctype") 		:	srctype		= value; break;
 			case ade::hash::hash_ascii_string_as_lower("srcformat") 	:	srcformat	= decode_sample_format(value); break;
 			case ade::hash::hash_ascii_string_as_lower("format") 			:	format		= decode_sample_format(value); break;
 
-			case ade::hash::hash_ascii_string_as_lower("srcrate") 		:	srcrate		= std::strtol(value.c_str(),nullptr,10); 	break;
-			case ade::hash::hash_ascii_string_as_lower("rate") 				:	rate			= std::strtol(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("srcrate") 		:	srcrate		= std::strtoul(value.c_str(),nullptr,10); 	break;
+			case ade::hash::hash_ascii_string_as_lower("rate") 				:	rate			= std::strtoul(value.c_str(),nullptr,10); 	break;
 			default :
 				// TODO: Warning - unknown arg
 				break;
 		}
 	}
 
-	std::print("SOUNDSAMPLE: name: {}, source: {}, srcfmt: {}, format: {}, srcrate: {}, rate: {}\n", name, source, format, srcformat, srcrate, rate);
+	gap::logger::verbose("SOUNDSAMPLE: name: {}, source: {}, srcfmt: {}, format: {}, srcrate: {}, rate: {}", name, source, srcformat, format, srcrate, rate);
+
+	if(source.empty())
+		return on_error(line_number,"Missing sound sample path!");
+
+	auto p_source = gap::sound::load(source, srctype, srcformat, srcrate, m_filesystem);
+	if(p_source == nullptr)
+		return on_error(line_number,std::string("Failed to load sound sample! - ") + source);
+
+	//---------------------------------------------------------------------------
+	//	The rate is the RATE parameter, then the SAMPLERATE command and then
+	//	the rate of the source.
+	//---------------------------------------------------------------------------
+	if(rate == 0)
+		rate = m_sample_rate != 0 ? m_sample_rate : p_source->sample_rate;
+
+	if((rate == 0) || (rate > 0xFFFF))
+		return on_error(line_number,std::format("Invalid sample rate ({})! The rate must be from 1 to 65535.", rate));
+
+	if(rate != p_source->sample_rate)
+	{
+		gap::logger::verbose("SOUNDSAMPLE: Resampling {} samples from {} to {} samples per second", p_source->samples.size(), p_source->sample_rate, rate);
+		p_source->samples = gap::sound::resample(p_source->samples, p_source->sample_rate, rate);
+	}
+
+	m_p_assets->add_sound_sample(std::make_unique<gap::sound::SoundSample>(name, rate, format, gap::sound::COMPRESSION_NONE, gap::sound::encode_samples(p_source->samples, format)));
 
 	return 0;
 }
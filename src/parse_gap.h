@@ -19,6 +19,7 @@
 #include "assets.h"
 #include "filesystem.h"
 #include "export.h"
+#include "logger.h"
 #include "source_tilemap.h"
 
 namespace gap
@@ -43,6 +44,9 @@ private:
 //	int 																							m_current_image_group					= 0;
 	int																								m_current_tileset							= -1;
 	int																								m_current_colourmap						= -1;
+	int																								m_source_colourmap						= -1;			// COLOURMAP of the most recent LOADIMAGE.
+	bool																							m_b_trim											= false;			// Default 'trim' for images.
+	uint32_t																					m_sample_rate									= 0;				// Rate of sound samples, 0 to keep the rate of the source.
 	std::unique_ptr<gap::tilemap::SourceTileMap>			m_p_current_tilemap;
 
 public:
@@ -57,8 +61,9 @@ public:
 
 private:
 	int									parse_line(std::string_view line,int line_number);
-	int									on_error(int line_number,const std::string & error_message) {std::cerr << "Line " << line_number << ": " << error_message << '\n';return -1;}
+	int									on_error(int line_number,const std::string & error_message) {gap::logger::error("Line {}: {}", line_number, error_message);return -1;}
 
+	int									command_atlas(int line_number,const CommandLine & args);
 	int									command_colourmap(int line_number,const CommandLine & args);
 	int 								command_loadimage(int line_number,const CommandLine & args);
 	int 								command_imagegroup(int line_number,const CommandLine & args);
@@ -74,6 +79,8 @@ private:
 	int 								command_tilemap(int line_number,const CommandLine & args);
 	int									command_loadtilemap(int line_number,const CommandLine & args);
 	int									command_soundsample(int line_number,const CommandLine & args);
+	int									command_samplerate(int line_number,const CommandLine & args);
+	int									command_trim(int line_number,const CommandLine & args);
 };
 
 
@@ -8,13 +8,24 @@
 //	MAINTAINER:			AJP - Adrian Purser <ade@arcadestuff.com>
 //	CREATED:				10-OCT-2025 Adrian Purser <ade@arcadestuff.com>
 //=============================================================================
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <iostream>
+#include <numbers>
+#include <numeric>
 #include "sound_sample.h"
-#include "miniaudio.h"
+#include "logger.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace gap::sound
 {
 
+#define TAG "LOAD_SOUNDSAMPLE: "
+
 SoundSample::SoundSample( std::string_view 				name,
 													uint16_t								sample_rate,
 													uint8_t									format,
@@ -24,25 +35,436 @@ SoundSample::SoundSample( std::string_view 				name,
 	, m_sample_rate(sample_rate)
 	, m_format(format)
 	, m_compression(compression)
-	, m_data(data)
+	, m_data(std::move(data))
+{
+
+}
+
+//=============================================================================
+//
+//	SAMPLE FORMAT CONVERSION
+//
+//	The unsigned formats are the signed formats with the top bit flipped, so
+//	they are converted with the same code. The SSE2 paths convert 16 or 8
+//	samples at a time and the scalar code finishes off the rest.
+//
+//=============================================================================
+
+void
+decode_samples(std::span<const uint8_t> data, uint8_t format, std::span<float> samples)
+{
+	const std::size_t		count	= std::min(samples.size(), data.size() / format_size(format));
+	std::size_t					i			= 0;
+
+	if(format_size(format) == 1)
+	{
+		const uint8_t flip = format == FORMAT_U8 ? 0x80 : 0x00;
+
+#if defined(__SSE2__)
+		const __m128i	flip_bits	= _mm_set1_epi8(char(flip));
+		const __m128	scale			= _mm_set1_ps(1.0f / 128.0f);
+
+		for(; (i + 16) <= count; i += 16)
+		{
+			const __m128i bytes	= _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i)), flip_bits);
+			const __m128i lo		= _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+			const __m128i hi		= _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+
+			_mm_storeu_ps(samples.data() + i,				_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(samples.data() + i + 4,		_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(samples.data() + i + 8,		_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), scale));
+			_mm_storeu_ps(samples.data() + i + 12,	_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), scale));
+		}
+#endif
+		for(; i<count; ++i)
+			samples[i] = float(int8_t(data[i] ^ flip)) * (1.0f / 128.0f);
+	}
+	else
+	{
+		const uint16_t flip = format == FORMAT_U16 ? 0x8000 : 0x0000;
+
+#if defined(__SSE2__)
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			const __m128i	flip_bits	= _mm_set1_epi16(int16_t(flip));
+			const __m128	scale			= _mm_set1_ps(1.0f / 32768.0f);
+
+			for(; (i + 8) <= count; i += 8)
+			{
+				const __m128i words = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + (i * 2))), flip_bits);
+
+				_mm_storeu_ps(samples.data() + i,			_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16)), scale));
+				_mm_storeu_ps(samples.data() + i + 4,	_mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16)), scale));
+			}
+		}
+#endif
+		for(; i<count; ++i)
+			samples[i] = float(int16_t((data[i*2] | (data[i*2+1] << 8)) ^ flip)) * (1.0f / 32768.0f);
+	}
+}
+
+std::vector<uint8_t>
+encode_samples(std::span<const float> samples, uint8_t format)
+{
+	const std::size_t			count	= samples.size();
+	std::vector<uint8_t>	data(count * format_size(format));
+	std::size_t						i			= 0;
+
+	if(format_size(format) == 1)
+	{
+		const uint8_t flip = format == FORMAT_U8 ? 0x80 : 0x00;
+
+#if defined(__SSE2__)
+		const __m128i	flip_bits	= _mm_set1_epi8(char(flip));
+		const __m128	scale			= _mm_set1_ps(128.0f);
+		const __m128	lower			= _mm_set1_ps(-1.0f);
+		const __m128	upper			= _mm_set1_ps(1.0f);
+
+		// The packs saturate +1.0 (128) to 127. Clamping first also turns NaN into -1.0.
+		auto convert = [&](std::size_t index)
+		{
+			return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples.data() + index), lower), upper), scale));
+		};
+
+		for(; (i + 16) <= count; i += 16)
+		{
+			const __m128i lo = _mm_packs_epi32(convert(i), convert(i + 4));
+			const __m128i hi = _mm_packs_epi32(convert(i + 8), convert(i + 12));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(data.data() + i), _mm_xor_si128(_mm_packs_epi16(lo, hi), flip_bits));
+		}
+#endif
+		for(; i<count; ++i)
+		{
+			const float value = std::isnan(samples[i]) ? -1.0f : std::clamp(samples[i], -1.0f, 1.0f);
+			data[i] = uint8_t(std::clamp<long>(std::lrint(value * 128.0f), -128, 127)) ^ flip;
+		}
+	}
+	else
+	{
+		const uint16_t flip = format == FORMAT_U16 ? 0x8000 : 0x0000;
+
+#if defined(__SSE2__)
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			const __m128i	flip_bits	= _mm_set1_epi16(int16_t(flip));
+			const __m128	scale			= _mm_set1_ps(32768.0f);
+			const __m128	lower			= _mm_set1_ps(-1.0f);
+			const __m128	upper			= _mm_set1_ps(1.0f);
+
+			auto convert = [&](std::size_t index)
+			{
+				return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples.data() + index), lower), upper), scale));
+			};
+
+			for(; (i + 8) <= count; i += 8)
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(data.data() + (i * 2)), _mm_xor_si128(_mm_packs_epi32(convert(i), convert(i + 4)), flip_bits));
+		}
+#endif
+		for(; i<count; ++i)
+		{
+			const float			value	= std::isnan(samples[i]) ? -1.0f : std::clamp(samples[i], -1.0f, 1.0f);
+			const uint16_t	word	= uint16_t(std::clamp<long>(std::lrint(value * 32768.0f), -32768, 32767)) ^ flip;
+			data[i*2]		= uint8_t(word);
+			data[i*2+1]	= uint8_t(word >> 8);
+		}
+	}
+
+	return data;
+}
+
+//=============================================================================
+//
+//	RESAMPLING
+//
+//	The ratio of the rates is reduced to UP/DOWN. Each output sample falls at
+//	a fraction of UP between two source samples and there is a set of filter
+//	taps (a phase) for each fraction, so every output sample is one dot
+//	product. Ratios with more than MAX_PHASES fractions use the nearest one.
+//
+//	The taps are a sinc low pass filter, cut off below the lower of the two
+//	Nyquist frequencies, shaped by a Blackman window.
+//
+//=============================================================================
+
+static constexpr uint32_t		MAX_PHASES				= 1024;
+static constexpr double			ZERO_CROSSINGS		= 16.0;			// Each side of the centre of the filter.
+static constexpr double			CUTOFF						= 0.9;			// Of the lower Nyquist frequency.
+static constexpr std::size_t	TAP_ALIGNMENT		= 8;
+
+// 'count' must be a multiple of TAP_ALIGNMENT.
+static inline
+float
+dot_product(const float * p_a, const float * p_b, std::size_t count)
+{
+#if defined(__SSE2__)
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+
+	for(std::size_t i=0; i<count; i+=8)
+	{
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(p_a + i), _mm_loadu_ps(p_b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(p_a + i + 4), _mm_loadu_ps(p_b + i + 4)));
+	}
+
+	sum0 = _mm_add_ps(sum0, sum1);
+	sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+	sum0 = _mm_add_ss(sum0, _mm_shuffle_ps(sum0, sum0, 1));
+	return _mm_cvtss_f32(sum0);
+#else
+	float sum[8] = {};
+	for(std::size_t i=0; i<count; i+=8)
+		for(std::size_t j=0; j<8; ++j)
+			sum[j] += p_a[i+j] * p_b[i+j];
+	return ((sum[0] + sum[1]) + (sum[2] + sum[3])) + ((sum[4] + sum[5]) + (sum[6] + sum[7]));
+#endif
+}
+
+std::vector<float>
+resample(std::span<const float> samples, uint32_t source_rate, uint32_t target_rate)
+{
+	if((source_rate == target_rate) || (source_rate == 0) || (target_rate == 0) || samples.empty())
+		return std::vector<float>(samples.begin(), samples.end());
+
+	const uint32_t	divisor		= std::gcd(source_rate, target_rate);
+	const uint64_t	up				= target_rate / divisor;
+	const uint64_t	down			= source_rate / divisor;
+	const uint32_t	phases		= uint32_t(std::min<uint64_t>(up, MAX_PHASES));
+
+	// ----- The filter is widened when downsampling, to keep its shape at the lower cut off. -----
+	const double				cutoff	= CUTOFF * std::min(1.0, double(target_rate) / double(source_rate));
+	const int64_t				half		= int64_t(std::ceil(ZERO_CROSSINGS / cutoff));
+	const std::size_t		taps		= ((std::size_t(half * 2) + TAP_ALIGNMENT - 1) / TAP_ALIGNMENT) * TAP_ALIGNMENT;
+
+	std::vector<float> filters(phases * taps, 0.0f);
+	for(uint32_t phase=0; phase<phases; ++phase)
+	{
+		float * const p_taps	= filters.data() + (phase * taps);
+		const double fraction	= double(phase) / double(phases);
+		double total					= 0.0;
+
+		for(int64_t k=0; k<(half * 2); ++k)
+		{
+			const double t			= double(k - half + 1) - fraction;
+			const double x			= std::numbers::pi * cutoff * t;
+			const double sinc		= t == 0.0 ? 1.0 : std::sin(x) / x;
+			const double w			= std::numbers::pi * t / double(half);
+			const double window	= std::abs(t) >= double(half) ? 0.0 : 0.42 + (0.5 * std::cos(w)) + (0.08 * std::cos(2.0 * w));
+			const double tap		= sinc * window;
+
+			p_taps[k]	= float(tap);
+			total			+= tap;
+		}
+
+		// ----- Unity gain for every phase, so a constant signal stays constant. -----
+		for(int64_t k=0; k<(half * 2); ++k)
+			p_taps[k] = float(p_taps[k] / total);
+	}
+
+	const std::size_t		size	= samples.size();
+	const std::size_t		count	= std::size_t((uint64_t(size) * up + down - 1) / down);
+	std::vector<float>	output(count);
+
+	for(std::size_t n=0; n<count; ++n)
+	{
+		const uint64_t	position	= uint64_t(n) * down;
+		uint64_t				index			= position / up;
+		uint64_t				phase			= (((position % up) * phases) + (up / 2)) / up;
+
+		if(phase == phases)
+		{
+			phase = 0;
+			++index;
+		}
+
+		const float * const		p_taps	= filters.data() + (phase * taps);
+		const int64_t					first		= int64_t(index) - half + 1;
+
+		if((first >= 0) && ((first + int64_t(taps)) <= int64_t(size)))
+			output[n] = dot_product(samples.data() + first, p_taps, taps);
+		else
+		{
+			// ----- Near the ends, the samples outside of the source are silent. -----
+			float sum = 0.0f;
+			for(std::size_t k=0; k<taps; ++k)
+				if(((first + int64_t(k)) >= 0) && ((first + int64_t(k)) < int64_t(size)))
+					sum += samples[first + k] * p_taps[k];
+			output[n] = sum;
+		}
+	}
+
+	return output;
+}
+
+//=============================================================================
+//
+//	SOUND SAMPLE LOADING
+//
+//=============================================================================
+
+static inline uint16_t	read_u16(std::span<const uint8_t> data, std::size_t offset)	{return data[offset] | (data[offset+1] << 8);}
+static inline uint32_t	read_u32(std::span<const uint8_t> data, std::size_t offset)	{return read_u16(data, offset) | (uint32_t(read_u16(data, offset+2)) << 16);}
+
+static
+bool
+is_wav(std::span<const uint8_t> file)
 {
+	return (file.size() >= 12) && (std::memcmp(file.data(), "RIFF", 4) == 0) && (std::memcmp(file.data() + 8, "WAVE", 4) == 0);
+}
+
+static
+std::unique_ptr<SourceSample>
+load_raw(std::span<const uint8_t> file, const std::string & filename, uint8_t format, uint32_t rate)
+{
+	if(rate == 0)
+	{
+		gap::logger::error(TAG "RAW sample '{}' needs a source sample rate (SRCRATE)", filename);
+		return nullptr;
+	}
+
+	auto p_sample = std::make_unique<SourceSample>();
+	p_sample->sample_rate = rate;
+	p_sample->samples.resize(file.size() / format_size(format));
+	decode_samples(file, format, p_sample->samples);
 
+	return p_sample;
 }
 
-std::unique_ptr<SoundSample>
-load(const std::filesystem::path & path, gap::FileSystem & filesystem)
+//-----------------------------------------------------------------------------
+//	A RIFF WAVE file is a list of chunks, each padded to an even size. Only the
+//	'fmt ' and 'data' chunks are used. The channels of each frame are averaged
+//	to make a mono sample.
+//-----------------------------------------------------------------------------
+static
+std::unique_ptr<SourceSample>
+load_wav(std::span<const uint8_t> file, const std::string & filename)
 {
-	auto file = filesystem.load(path);
+	static constexpr uint16_t WAVE_FORMAT_PCM					= 0x0001;
+	static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT	= 0x0003;
+	static constexpr uint16_t WAVE_FORMAT_EXTENSIBLE	= 0xFFFE;
+
+	uint16_t								tag				= 0;
+	uint16_t								channels	= 0;
+	uint32_t								rate			= 0;
+	uint16_t								bits			= 0;
+	std::span<const uint8_t>	samples;
+	bool										b_data		= false;
+
+	if(!is_wav(file))
+	{
+		gap::logger::error(TAG "'{}' is not a RIFF WAVE file", filename);
+		return nullptr;
+	}
+
+	for(std::size_t offset=12; (offset + 8) <= file.size(); )
+	{
+		const auto				id		= file.subspan(offset, 4);
+		const std::size_t	body	= offset + 8;
+		std::size_t				size	= read_u32(file, offset + 4);
+
+		// A file that was cut short may still have most of its samples.
+		if(size > (file.size() - body))
+		{
+			gap::logger::verbose(TAG "Chunk '{}' of '{}' is cut short", std::string_view(reinterpret_cast<const char *>(id.data()), 4), filename);
+			size = file.size() - body;
+		}
+
+		if((std::memcmp(id.data(), "fmt ", 4) == 0) && (size >= 16))
+		{
+			tag				= read_u16(file, body);
+			channels	= read_u16(file, body + 2);
+			rate			= read_u32(file, body + 4);
+			bits			= read_u16(file, body + 14);
+
+			// The format of an extensible file is in the first two bytes of its sub format GUID.
+			if((tag == WAVE_FORMAT_EXTENSIBLE) && (size >= 26))
+				tag = read_u16(file, body + 24);
+		}
+		else if(std::memcmp(id.data(), "data", 4) == 0)
+		{
+			samples	= file.subspan(body, size);
+			b_data	= true;
+		}
+
+		offset = body + size + (size & 1);
+	}
+
+	const bool b_pcm		= (tag == WAVE_FORMAT_PCM) && ((bits == 8) || (bits == 16) || (bits == 24) || (bits == 32));
+	const bool b_float	= (tag == WAVE_FORMAT_IEEE_FLOAT) && ((bits == 32) || (bits == 64));
+
+	if(!b_data || (channels == 0) || (rate == 0) || !(b_pcm || b_float))
+	{
+		gap::logger::error(TAG "'{}' is not a supported WAV file (format {}, {} bits, {} channels)", filename, tag, bits, channels);
+		return nullptr;
+	}
+
+	const std::size_t bytes		= bits / 8;
+	const std::size_t frames	= samples.size() / (bytes * channels);
+
+	auto p_sample = std::make_unique<SourceSample>();
+	p_sample->sample_rate = rate;
+	p_sample->samples.resize(frames);
+
+	// ----- 8 bit WAV samples are unsigned. 16 bit mono is the common case. -----
+	if((channels == 1) && b_pcm && (bits <= 16))
+	{
+		decode_samples(samples, bits == 8 ? FORMAT_U8 : FORMAT_S16, p_sample->samples);
+		return p_sample;
+	}
+
+	auto read_sample = [&](std::size_t offset)->double
+		{
+			if(b_float)
+			{
+				if(bits == 32)
+					return std::bit_cast<float>(read_u32(samples, offset));
+				return std::bit_cast<double>(uint64_t(read_u32(samples, offset)) | (uint64_t(read_u32(samples, offset + 4)) << 32));
+			}
+
+			switch(bits)
+			{
+				case 8 :	return (int(samples[offset]) - 128) / 128.0;
+				case 16 :	return int16_t(read_u16(samples, offset)) / 32768.0;
+				case 24 :	return int32_t((uint32_t(read_u16(samples, offset)) << 8) | (uint32_t(samples[offset+2]) << 24)) / 2147483648.0;
+				default :	return int32_t(read_u32(samples, offset)) / 2147483648.0;
+			}
+		};
+
+	for(std::size_t frame=0; frame<frames; ++frame)
+	{
+		double sum = 0.0;
+		for(std::size_t channel=0; channel<channels; ++channel)
+			sum += read_sample(((frame * channels) + channel) * bytes);
+		p_sample->samples[frame] = float(sum / channels);
+	}
+
+	return p_sample;
+}
+
+std::unique_ptr<SourceSample>
+load(	const std::filesystem::path &		path,
+			std::string_view								type,
+			uint8_t													raw_format,
+			uint32_t												raw_rate,
+			gap::FileSystem &								filesystem )
+{
+	auto file = filesystem.load(path.string());
 	if(file.empty())
 	{
-		std::cerr << "LOAD_SOUNDSAMPLE: Failed to load file '" << path << "'\n";
+		gap::logger::error(TAG "Failed to load file '{}'", path.string());
 		return nullptr;
 	}
 
+	std::string ltype(type);
+	std::transform(begin(ltype), end(ltype), begin(ltype), ::tolower);
+
+	if(ltype.empty() || (ltype == "auto"))
+		ltype = is_wav(file) ? "wav" : "raw";
 
+	if(ltype == "raw")		return load_raw(file, path.string(), raw_format, raw_rate);
+	if(ltype == "wav")		return load_wav(file, path.string());
 
+	gap::logger::error(TAG "Sound sample type '{}' is not supported", type);
 	return nullptr;
 }
 
-} // namespace gap::image
-
+} // namespace gap::sound
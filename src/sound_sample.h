@@ -12,8 +12,11 @@
 #define GUARD_ADE_GAME_ASSET_PACKER_SOUND_SAMPLE_H
 
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cmath>
 #include <utility>
 #include <filesystem>
@@ -30,6 +33,23 @@ static constexpr uint8_t		FORMAT_U16	= 3;
 
 static constexpr uint8_t		COMPRESSION_NONE	= 0;
 
+// Bytes in one sample of a format.
+constexpr
+std::size_t
+format_size(uint8_t format) noexcept
+{
+	return (format == FORMAT_S16) || (format == FORMAT_U16) ? 2 : 1;
+}
+
+//-----------------------------------------------------------------------------
+//	Sound sample data as loaded from its source file, mixed down to mono and
+//	scaled to -1.0 to +1.0.
+//-----------------------------------------------------------------------------
+struct SourceSample
+{
+	uint32_t								sample_rate		= 0;
+	std::vector<float>			samples;
+};
 
 class SoundSample
 {
@@ -49,9 +69,35 @@ public:
 								uint8_t									compression,
 								std::vector<uint8_t>		data );
 
+	const std::string &						name() const noexcept					{return m_name;}
+	uint16_t											sample_rate() const noexcept	{return m_sample_rate;}
+	uint8_t												format() const noexcept				{return m_format;}
+	uint8_t												compression() const noexcept	{return m_compression;}
+	std::size_t										sample_count() const noexcept	{return m_data.size() / format_size(m_format);}
+	const std::vector<uint8_t> &	data() const noexcept					{return m_data;}
 };
 
-std::unique_ptr<SoundSample>			load_sound_sample(const std::filesystem::path & filename, gap::FileSystem & filesystem);
+//-----------------------------------------------------------------------------
+//	Load a sound sample file. 'type' is RAW, WAV or AUTO, which loads a RIFF
+//	WAVE file as WAV and anything else as RAW. RAW files are mono in
+//	'raw_format' at 'raw_rate' samples per second, 16 bit samples are little
+//	endian. WAV files may be 8, 16, 24 or 32 bit PCM or 32/64 bit float with
+//	any number of channels.
+//-----------------------------------------------------------------------------
+std::unique_ptr<SourceSample>			load(	const std::filesystem::path &		filename,
+																				std::string_view								type,
+																				uint8_t													raw_format,
+																				uint32_t												raw_rate,
+																				gap::FileSystem &								filesystem );
+
+// Convert 'samples' from 'source_rate' to 'target_rate' with a polyphase
+// windowed sinc filter.
+std::vector<float>								resample(std::span<const float> samples, uint32_t source_rate, uint32_t target_rate);
+
+// Convert samples in 'format' (16 bit samples are little endian) to -1.0 to
+// +1.0, and back again. Values outside of that range are clipped.
+void															decode_samples(std::span<const uint8_t> data, uint8_t format, std::span<float> samples);
+std::vector<uint8_t>							encode_samples(std::span<const float> samples, uint8_t format);
 
 } // namespace gap::sound
 
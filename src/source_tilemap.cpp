@@ -8,6 +8,13 @@
 //	MAINTAINER:			AJP - Adrian Purser <ade@arcadestuff.com>
 //	CREATED:				12-MAR-2025 Adrian Purser <ade@arcadestuff.com>
 //=============================================================================
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <span>
@@ -15,16 +22,21 @@
 #include <print>
 #include <format>
 #include "source_tilemap.h"
+#include "decompress.h"
 #include "adexml/xml_parser.h"
+#include "utility/base64.h"
 #include "utility/unicode.h"
-#include "utility/tokenize.h"
 #include "utility/ansi.h"
+#include "logger.h"
 
 namespace gap::tilemap
 {
 
 #define TAG "TILEMAP: "
 
+// TMX and TSX files are read in pieces of this size.
+static constexpr std::size_t TMX_READ_SIZE = 64 * 1024;
+
 //=============================================================================
 //
 //	TILEMAP LAYER
@@ -65,12 +77,54 @@ SourceTileMapLayer::set_tile(uint32_t x, uint32_t y, uint64_t value)
 uint64_t
 SourceTileMapLayer::get_tile(uint32_t x, uint32_t y) const
 {
+	if(!m_chunks.empty())
+	{
+		for(const auto & chunk : m_chunks)
+			if(	(int64_t(x) >= chunk.x) && (int64_t(x) < (int64_t(chunk.x) + chunk.width)) &&
+					(int64_t(y) >= chunk.y) && (int64_t(y) < (int64_t(chunk.y) + chunk.height)) )
+				return chunk.data[(std::size_t(y - chunk.y) * chunk.width) + (x - chunk.x)];
+		return 0U;
+	}
+
 	uint32_t index = (y*m_width) + x;
 	if(index < m_data.size())
 		return m_data[index];
 	return 0U;
 }
 
+uint64_t
+SourceTileMapLayer::largest_tile() const
+{
+	uint64_t largest = m_data.empty() ? 0 : *std::max_element(begin(m_data), end(m_data));
+	for(const auto & chunk : m_chunks)
+		largest = std::max(largest, *std::max_element(begin(chunk.data), end(chunk.data)));
+	return largest;
+}
+
+void
+SourceTileMapLayer::enumerate_rects(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+																		std::function<void(uint32_t x, uint32_t y, uint32_t width, uint32_t height, std::span<const uint64_t> tiles, std::size_t stride)> callback) const
+{
+	// ----- Clip the region [left,right) x [top,bottom) to a rectangle of tiles. -----
+	auto clip = [&](int64_t left, int64_t top, int64_t right, int64_t bottom, std::span<const uint64_t> data, std::size_t stride)
+	{
+		const int64_t x0 = std::max<int64_t>(left, x);
+		const int64_t y0 = std::max<int64_t>(top, y);
+		const int64_t x1 = std::min<int64_t>(right, int64_t(x) + width);
+		const int64_t y1 = std::min<int64_t>(bottom, int64_t(y) + height);
+
+		if((x0 < x1) && (y0 < y1))
+			callback(	uint32_t(x0 - x), uint32_t(y0 - y), uint32_t(x1 - x0), uint32_t(y1 - y0),
+								data.subspan((std::size_t(y0 - top) * stride) + (x0 - left), (std::size_t(y1 - y0 - 1) * stride) + (x1 - x0)), stride);
+	};
+
+	if(m_data.size() == (std::size_t(m_width) * m_height))
+		clip(0, 0, m_width, m_height, m_data, m_width);
+
+	for(const auto & chunk : m_chunks)
+		clip(chunk.x, chunk.y, int64_t(chunk.x) + chunk.width, int64_t(chunk.y) + chunk.height, chunk.data, chunk.width);
+}
+
 //=============================================================================
 //
 //	TILEMAP
@@ -86,6 +140,15 @@ SourceTileMap::enumerate_layers(std::function<bool(const SourceTileMapLayer &)>
 				break;
 }
 
+void
+SourceTileMap::enumerate_layers(std::function<bool(SourceTileMapLayer &)> callback)
+{
+	for(const auto & p_layer : m_layers)
+		if(p_layer != nullptr)
+			if(!callback(*p_layer.get()))
+				break;
+}
+
 const SourceTileMapLayer *
 SourceTileMap::get_layer(uint32_t id)
 {
@@ -96,6 +159,61 @@ SourceTileMap::get_layer(uint32_t id)
 	return nullptr;
 }
 
+//=============================================================================
+//
+//	TILESET
+//
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+//	A tile has a flag if its class is the flag name or if it has a property
+//	with the flag name that is true, a number other than 0 or a string other
+//	than "", "0" or "false". Names are not case sensitive.
+//-----------------------------------------------------------------------------
+bool
+SourceTileSet::tile_flag(uint32_t tile_id, std::string_view name) const
+{
+	auto equal = [](std::string_view a, std::string_view b)
+	{
+		return std::ranges::equal(a, b, [](char ca, char cb) {return std::tolower((unsigned char)ca) == std::tolower((unsigned char)cb);});
+	};
+
+	if(auto it = tile_classes.find(tile_id); (it != tile_classes.end()) && equal(it->second, name))
+		return true;
+
+	auto it = tile_properties.find(tile_id);
+	if(it == tile_properties.end())
+		return false;
+
+	for(const auto & property : it->second)
+	{
+		if(!equal(property.name, name))
+			continue;
+
+		if((property.type == "int") || (property.type == "float"))
+			return std::strtod(property.value.c_str(), nullptr) != 0.0;
+		return !property.value.empty() && (property.value != "0") && !equal(property.value, "false");
+	}
+
+	return false;
+}
+
+std::vector<uint32_t>
+SourceTileSet::tile_flags(std::span<const std::string> flag_names, uint64_t largest_tile) const
+{
+	std::vector<uint32_t> flags(largest_tile + 1, 0);
+	for(std::size_t tile=0; tile<flags.size(); ++tile)
+		for(std::size_t flag=0; flag<flag_names.size(); ++flag)
+			if(tile_flag(uint32_t(tile), flag_names[flag]))
+				flags[tile] |= 1U << flag;
+
+	if(flags[0] != 0)
+		gap::logger::info(TAG "Tile 0 of the tileset has flags but is stored as an empty cell, its flags are ignored");
+	flags[0] = 0;
+
+	return flags;
+}
+
 //=============================================================================
 //
 //	HELPER FUNCTIONS
@@ -121,27 +239,440 @@ to_string(const std::u8string & u8str)
 }
 */
 
+//=============================================================================
+//
+//	TSX TILESET LOADING
+//
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+//	The tiles of a tileset, in a TSX file or embedded in a TMX file. 'path'
+//	starts at the <tileset> element.
+//-----------------------------------------------------------------------------
+static
+std::error_code
+tsx_on_end_tag( SourceTileSet & 												tileset,
+								std::u8string_view 											path,
+								const std::vector<adexml::Element> & 		stack )
+{
+	auto attribute = [](const adexml::Element & element, const char8_t * p_name) -> std::string
+	{
+		auto opt_value = element.attribute(p_name);
+		return opt_value ? ade::unicode::to_string(opt_value.value()) : std::string();
+	};
+
+	if(path == u8"tileset/tile")
+	{
+		const auto & tile = stack.back();
+
+		// Tiled 1.9 renamed the 'type' of a tile to 'class'.
+		auto tile_class = attribute(tile, u8"class");
+		if(tile_class.empty())
+			tile_class = attribute(tile, u8"type");
+		if(!tile_class.empty())
+			tileset.tile_classes[std::strtoul(attribute(tile, u8"id").c_str(), nullptr, 10)] = tile_class;
+	}
+	else if((path == u8"tileset/tile/properties/property") && (stack.size() >= 3))
+	{
+		const auto & element	= stack.back();
+		const auto & tile			= stack[stack.size() - 3];
+
+		// Multi-line string values are held in the content of the element.
+		SourceTileProperty property;
+		property.name		= attribute(element, u8"name");
+		property.type		= attribute(element, u8"type");
+		property.value	= element.attribute(u8"value") ? attribute(element, u8"value") : ade::unicode::to_string(element.content);
+
+		if(property.type.empty())
+			property.type = "string";
+
+		tileset.tile_properties[std::strtoul(attribute(tile, u8"id").c_str(), nullptr, 10)].push_back(std::move(property));
+	}
+
+	return {};
+}
+
+static
+bool
+load_tiled_tsx(const std::string & filename, gap::FileSystem & filesystem, SourceTileSet & tileset)
+{
+	adexml::Parser parser([&](	adexml::Parser::Action 								action,
+															const std::u8string &									path,
+															const std::vector<adexml::Element> & 	stack ) -> std::error_code
+															{
+																if((action == adexml::Parser::ACTION_END_ELEMENT) && (stack.back().type == adexml::ElementType::ELEMENT))
+																	return tsx_on_end_tag(tileset, path, stack);
+																return {};
+															});
+
+	std::error_code	ec;
+	std::size_t			file_size = 0;
+
+	const bool b_read = filesystem.stream(filename, TMX_READ_SIZE, [&](std::span<uint8_t> bytes) -> bool
+		{
+			file_size += bytes.size();
+			ec = parser.write(std::span<char8_t>(reinterpret_cast<char8_t *>(bytes.data()), bytes.size()));
+			return !ec;
+		});
+
+	if(ec)
+	{
+		gap::logger::error(TAG "(xmlparser): {} in '{}'", ec.message(), filename);
+		return false;
+	}
+
+	return b_read && (file_size > 0);
+}
+
 //=============================================================================
 //
 //	TMX TILEMAP LOADING
 //
 //=============================================================================
 
+//-----------------------------------------------------------------------------
+//	The content of a <data> or <chunk> element is decoded as it arrives,
+//	straight into the tile array, so the text of a large layer is never held
+//	in memory. Only a CSV value or a group of base64 characters that is split
+//	between two writes is kept back. There must be exactly one value for each
+//	tile.
+//
+//	CSV values may have line breaks and spaces around them and a trailing
+//	comma is ignored.
+//
+//	Base64 data is an array of 32 bit little endian tile ids, which may be
+//	compressed. Compressed data is inflated in one go by end(), so the packed
+//	bytes are kept until then. They are inflated into the upper half of the
+//	64 bit tile array and then widened in place, from the front, so no other
+//	buffer of the layer's size is needed. The widened tile i is written over
+//	bytes that have already been read.
+//-----------------------------------------------------------------------------
+class TmxDataStream
+{
+private:
+	enum
+	{
+		CSV,
+		BASE64
+	};
+
+	static constexpr std::size_t	BASE64_GROUP	= 16;		// Characters that decode to a whole number of tile ids.
+	static constexpr std::size_t	BASE64_BATCH	= 4096;
+	static constexpr std::size_t	MAX_CSV_VALUE	= 32;
+
+	std::span<uint64_t>			m_tiles;
+	std::size_t							m_index					= 0;
+	uint32_t								m_first_tile_id	= 0;
+	int											m_encoding			= CSV;
+	int											m_compression		= gap::compression::NONE;
+	bool										m_b_value				= false;		// CSV: A value has been read since the last comma.
+	bool										m_b_padded			= false;		// Base64: The '=' padding has been read.
+	std::string							m_layer_name;
+	std::string							m_pending;
+	std::vector<uint8_t>		m_bytes;
+	std::vector<uint8_t>		m_packed;
+
+public:
+	std::error_code		begin(std::span<uint64_t> tiles, const adexml::Element & data_element, std::string_view layer_name, uint32_t first_tile_id);
+	std::error_code		write(std::string_view text);
+	std::error_code		end();
+
+private:
+	std::error_code		write_csv(std::string_view text);
+	std::error_code		write_csv_value(std::string_view digits);
+	std::error_code		decode_base64(bool b_final);
+	std::error_code		write_ids(std::span<const uint8_t> bytes);
+	std::error_code		csv_error(std::error_code ec);
+};
+
+std::error_code
+TmxDataStream::begin(	std::span<uint64_t>						tiles,
+											const adexml::Element &				data_element,
+											std::string_view							layer_name,
+											uint32_t											first_tile_id )
+{
+	auto opt_encoding 		= data_element.attribute(u8"encoding");
+	auto opt_compression	= data_element.attribute(u8"compression");
+
+	std::string encoding("csv");
+	std::string compression;
+
+	if(opt_encoding)			encoding 		= ade::unicode::to_string(opt_encoding.value());
+	if(opt_compression)		compression = ade::unicode::to_string(opt_compression.value());
+
+	std::transform(encoding.begin(), encoding.end(), encoding.begin(), ::tolower);
+	std::transform(compression.begin(), compression.end(), compression.begin(), ::tolower);
+
+	m_tiles					= tiles;
+	m_index					= 0;
+	m_first_tile_id	= first_tile_id;
+	m_compression		= gap::compression::NONE;
+	m_b_value				= false;
+	m_b_padded			= false;
+	m_layer_name		= layer_name;
+	m_pending.clear();
+	m_packed.clear();
+
+	if(encoding == "csv")
+		m_encoding = CSV;
+	else if(encoding == "base64")
+	{
+		m_encoding		= BASE64;
+		m_compression	= gap::compression::method_from_name(compression);
+
+		if(!gap::compression::is_supported(m_compression))
+		{
+			gap::logger::error(TAG "Layer '{}' uses '{}' compression which is not supported by this build", layer_name, compression);
+			return std::make_error_code(std::errc::protocol_not_supported);
+		}
+	}
+	else
+		return std::make_error_code(std::errc::protocol_not_supported);
+
+	return {};
+}
+
+std::error_code
+TmxDataStream::write(std::string_view text)
+{
+	if(m_encoding == CSV)
+		return csv_error(write_csv(text));
+
+	m_pending.reserve(BASE64_BATCH + BASE64_GROUP);
+	for(const char ch : text)
+	{
+		if((ch == ' ') || (ch == '\n') || (ch == '\r') || (ch == '\t'))
+			continue;
+
+		m_pending.push_back(ch);
+		if(m_pending.size() >= BASE64_BATCH)
+			if(auto ec = decode_base64(false))
+				return ec;
+	}
+
+	return {};
+}
+
+std::error_code
+TmxDataStream::end()
+{
+	if(m_encoding == CSV)
+	{
+		if(!m_pending.empty())
+		{
+			if(auto ec = write_csv_value(m_pending))
+				return csv_error(ec);
+			m_pending.clear();
+		}
+
+		return csv_error(m_index == m_tiles.size() ? std::error_code() : std::make_error_code(std::errc::invalid_argument));
+	}
+
+	if(auto ec = decode_base64(true))
+		return ec;
+
+	if(m_compression != gap::compression::NONE)
+	{
+		const std::size_t		count		= m_tiles.size();
+		std::span<uint8_t>	ids(reinterpret_cast<uint8_t *>(m_tiles.data()) + (count * 4), count * 4);
+
+		if(auto ec = gap::compression::decompress(m_packed, ids, m_compression))
+			return ec;
+
+		m_packed = {};
+		if(auto ec = write_ids(ids))
+			return ec;
+	}
+
+	return m_index == m_tiles.size() ? std::error_code() : std::make_error_code(std::errc::invalid_argument);
+}
+
+std::error_code
+TmxDataStream::write_csv(std::string_view text)
+{
+	// ----- Complete a value that was split by the previous write. -----
+	if(!m_pending.empty())
+	{
+		const auto length = std::min(text.find_first_not_of("0123456789"), text.size());
+		m_pending.append(text.substr(0, length));
+		text.remove_prefix(length);
+
+		if(m_pending.size() > MAX_CSV_VALUE)
+			return std::make_error_code(std::errc::invalid_argument);
+		if(text.empty())
+			return {};
+		if(auto ec = write_csv_value(m_pending))
+			return ec;
+		m_pending.clear();
+	}
+
+	const char *				p				= text.data();
+	const char * const	p_end		= p + text.size();
+
+	while(p != p_end)
+	{
+		const char ch = *p;
+		if((ch == ' ') || (ch == '\n') || (ch == '\r') || (ch == '\t'))
+		{
+			++p;
+			continue;
+		}
+
+		if(ch == ',')
+		{
+			if(!m_b_value)
+				return std::make_error_code(std::errc::invalid_argument);
+			m_b_value = false;
+			++p;
+			continue;
+		}
+
+		const char * p_digits = p;
+		while((p != p_end) && (*p >= '0') && (*p <= '9'))
+			++p;
+
+		if(p == p_digits)
+			return std::make_error_code(std::errc::invalid_argument);
+
+		// The value may carry on in the next write.
+		if(p == p_end)
+		{
+			m_pending.assign(p_digits, p);
+			break;
+		}
+
+		if(auto ec = write_csv_value(std::string_view(p_digits, p)))
+			return ec;
+	}
+
+	return {};
+}
+
+std::error_code
+TmxDataStream::write_csv_value(std::string_view digits)
+{
+	if(m_b_value || (m_index >= m_tiles.size()))
+		return std::make_error_code(std::errc::invalid_argument);
+
+	uint64_t tile = 0;
+	const auto [p_next, error] = std::from_chars(digits.data(), digits.data() + digits.size(), tile);
+	if((error != std::errc()) || (p_next != (digits.data() + digits.size())))
+		return std::make_error_code(std::errc::invalid_argument);
+
+	// Tile values are offset by the 'firstgid' attribute of the tileset
+	// so we need to correct for that.
+	m_tiles[m_index++]	= tile == 0 ? 0 : tile - m_first_tile_id;
+	m_b_value						= true;
+
+	return {};
+}
+
+//-----------------------------------------------------------------------------
+//	Decode the pending base64 characters. Until the final call only whole
+//	groups of 16 characters are decoded, which is 12 bytes or 3 tile ids, and
+//	the rest are kept for the next call.
+//-----------------------------------------------------------------------------
+std::error_code
+TmxDataStream::decode_base64(bool b_final)
+{
+	const std::size_t length = b_final ? m_pending.size() : (m_pending.size() / BASE64_GROUP) * BASE64_GROUP;
+	if(length == 0)
+		return {};
+
+	// ----- Nothing may follow the padding at the end of the data. -----
+	if(m_b_padded)
+		return std::make_error_code(std::errc::invalid_argument);
+
+	const std::string_view text(m_pending.data(), length);
+	m_b_padded = text.find('=') != std::string_view::npos;
+
+	m_bytes.resize(ade::base64::decoded_size_limit(text));
+	const auto size = ade::base64::decode(text, m_bytes);
+	if(!size)
+		return std::make_error_code(std::errc::invalid_argument);
+
+	m_pending.erase(0, length);
+
+	const std::span<const uint8_t> bytes(m_bytes.data(), *size);
+	if(m_compression != gap::compression::NONE)
+	{
+		m_packed.insert(m_packed.end(), bytes.begin(), bytes.end());
+		return {};
+	}
+
+	if((bytes.size() % 4) != 0)
+		return std::make_error_code(std::errc::invalid_argument);
+
+	return write_ids(bytes);
+}
+
+std::error_code
+TmxDataStream::write_ids(std::span<const uint8_t> bytes)
+{
+	const std::size_t count = bytes.size() / 4;
+	if(count > (m_tiles.size() - m_index))
+		return std::make_error_code(std::errc::invalid_argument);
+
+	for(std::size_t i=0; i<count; ++i)
+	{
+		uint32_t id;
+		std::memcpy(&id, bytes.data() + (i * 4), sizeof(id));
+		if constexpr (std::endian::native == std::endian::big)
+			id = std::byteswap(id);
+
+		// Tile values are offset by the 'firstgid' attribute of the tileset.
+		m_tiles[m_index++] = id == 0 ? 0 : uint64_t(id) - m_first_tile_id;
+	}
+
+	return {};
+}
+
+std::error_code
+TmxDataStream::csv_error(std::error_code ec)
+{
+	if(ec)
+		gap::logger::error(TAG "Layer '{}' does not have {} valid CSV values", m_layer_name, m_tiles.size());
+	return ec;
+}
+
+//-----------------------------------------------------------------------------
+//	Decode the whole content of a <data> or <chunk> element using the
+//	encoding and compression given by the <data> element.
+//-----------------------------------------------------------------------------
 static
 std::error_code
-tmx_on_end_tag_map_layer_data( 	SourceTileMap & 												tilemap,
-														const std::u8string &										path,
-														const std::vector<adexml::Element> & 		stack )
+tmx_decode_data(	std::span<uint64_t>						tiles,
+									const adexml::Element &				data_element,
+									const std::u8string &					content,
+									std::string_view							layer_name,
+									uint32_t											first_tile_id )
 {
-	(void)path;
+	TmxDataStream stream;
 
-	auto tileset = tilemap.get_tileset();
+	if(auto ec = stream.begin(tiles, data_element, layer_name, first_tile_id))
+		return ec;
+	if(auto ec = stream.write(std::string_view(reinterpret_cast<const char *>(content.data()), content.size())))
+		return ec;
 
-	//---------------------------------------------------------------------------
-	//	PARSE LAYER ELEMENT
-	//---------------------------------------------------------------------------
-	const auto & layer_element = stack[1];
+	return stream.end();
+}
+
+//-----------------------------------------------------------------------------
+//	The layer of a finite map whose <data> element is being read. Once the
+//	start tag has been parsed the content of the element bypasses the XML
+//	parser and is decoded as it is read from the file.
+//-----------------------------------------------------------------------------
+struct TmxStreamedLayer
+{
+	std::shared_ptr<SourceTileMapLayer>		p_layer;
+	TmxDataStream													data;
+	bool																	b_content = false;		// The element content is going to 'data'.
+};
 
+static
+std::shared_ptr<SourceTileMapLayer>
+tmx_create_layer(const adexml::Element & layer_element, bool b_dense)
+{
 	auto opt_id 			= layer_element.attribute(u8"id");
 	auto opt_name 		= layer_element.attribute(u8"name");
 	auto opt_width 		= layer_element.attribute(u8"width");
@@ -150,7 +681,7 @@ tmx_on_end_tag_map_layer_data( 	SourceTileMap & 												tilemap,
 	auto opt_y 				= layer_element.attribute(u8"y");
 
 	if(!opt_width || !opt_height)
-		return std::make_error_code(std::errc::invalid_argument);
+		return nullptr;
 
 	uint32_t 			id 			= opt_id ? std::strtoul(ade::unicode::to_string(opt_id.value()).c_str(), nullptr, 10) : 0UL;
 	std::string		name 		= opt_name ? ade::unicode::to_string(opt_name.value()) : "";
@@ -159,51 +690,133 @@ tmx_on_end_tag_map_layer_data( 	SourceTileMap & 												tilemap,
 	uint32_t 			x				= opt_x ? std::strtoul(ade::unicode::to_string(opt_x.value()).c_str(), nullptr, 10) : 0UL;
 	uint32_t 			y				= opt_y ? std::strtoul(ade::unicode::to_string(opt_y.value()).c_str(), nullptr, 10) : 0UL;
 
+	// A chunked layer's size is only known once all of its chunks are loaded.
+	auto p_layer = b_dense ? std::make_shared<SourceTileMapLayer>(id, name, width, height) : std::make_shared<SourceTileMapLayer>(id, name, 0, 0);
+	p_layer->set_position(x,y);
+	return p_layer;
+}
 
-	auto p_layer = std::make_shared<SourceTileMapLayer>(id, name, width, height);
-	auto & layer = *p_layer.get();
+static
+std::error_code
+tmx_on_end_tag_map_layer_data( 	SourceTileMap & 												tilemap,
+																TmxStreamedLayer &											streamed )
+{
+	// The layer of an infinite map was added when its <data> element started
+	// and its tiles are in chunks.
+	if(tilemap.infinite())
+		return {};
 
-	layer.set_position(x,y);
+	if(streamed.p_layer == nullptr)
+		return std::make_error_code(std::errc::invalid_argument);
 
-	//---------------------------------------------------------------------------
-	//	PARSE DATA ELEMENT
-	//---------------------------------------------------------------------------
-	const auto & data_element = stack[2];
+	streamed.b_content = false;
+	if(auto ec = streamed.data.end())
+		return ec;
 
-	auto opt_encoding 		= data_element.attribute(u8"encoding");
-	auto opt_compression	= data_element.attribute(u8"compression");
+	tilemap.add_layer(std::move(streamed.p_layer));
+	streamed.p_layer = nullptr;
 
-	std::string encoding("csv");
-	std::string compression;
+	return {};
+}
 
-	if(opt_encoding)			encoding 		= ade::unicode::to_string(opt_encoding.value());
-	if(opt_compression)		compression = ade::unicode::to_string(opt_compression.value());
+//-----------------------------------------------------------------------------
+//	Infinite maps split each layer into chunks, typically 16x16 tiles, and
+//	only store the chunks that have been painted. Each chunk is decoded on
+//	its own and chunks without any tiles are dropped, so the memory used
+//	depends on the painted area and not the extent of the map.
+//-----------------------------------------------------------------------------
+static
+std::error_code
+tmx_on_end_tag_map_layer_data_chunk(	SourceTileMap & 												tilemap,
+																			const std::vector<adexml::Element> & 		stack )
+{
+	auto p_layer = tilemap.last_layer();
+	if(!tilemap.infinite() || (p_layer == nullptr))
+		return std::make_error_code(std::errc::protocol_not_supported);
 
-	std::transform(begin(encoding), end(encoding), begin(encoding), ::tolower);
-	std::transform(begin(compression), end(compression), begin(compression), ::tolower);
+	const auto & element = stack[3];
 
-	if(encoding == "csv")
-	{
-		auto csv = ade::unicode::to_string(data_element.content);
-		std::replace(begin(csv), end(csv), '\n', ' ');
-		std::replace(begin(csv), end(csv), '\r', ' ');
-		auto values = ade::tokenize(csv);
-		if(values.size() != (width * height))
-			return std::make_error_code(std::errc::invalid_argument);
+	auto opt_x 				= element.attribute(u8"x");
+	auto opt_y 				= element.attribute(u8"y");
+	auto opt_width 		= element.attribute(u8"width");
+	auto opt_height 	= element.attribute(u8"height");
+
+	if(!opt_x || !opt_y || !opt_width || !opt_height)
+		return std::make_error_code(std::errc::invalid_argument);
+
+	SourceTileMapChunk chunk;
+	chunk.x				= std::strtol(ade::unicode::to_string(opt_x.value()).c_str(), nullptr, 10);
+	chunk.y				= std::strtol(ade::unicode::to_string(opt_y.value()).c_str(), nullptr, 10);
+	chunk.width		= std::strtoul(ade::unicode::to_string(opt_width.value()).c_str(), nullptr, 10);
+	chunk.height	= std::strtoul(ade::unicode::to_string(opt_height.value()).c_str(), nullptr, 10);
+
+	if((chunk.width == 0) || (chunk.height == 0) || (chunk.width > 0x10000) || (chunk.height > 0x10000))
+		return std::make_error_code(std::errc::invalid_argument);
+
+	chunk.data.resize(std::size_t(chunk.width) * chunk.height);
+	if(auto ec = tmx_decode_data(chunk.data, stack[2], element.content, p_layer->m_name, tilemap.get_tileset().first_tile_id))
+		return ec;
+
+	if(std::any_of(begin(chunk.data), end(chunk.data), [](uint64_t tile) {return tile != 0;}))
+		p_layer->m_chunks.push_back(std::move(chunk));
+
+	return {};
+}
 
-		int i=0;
-		for(auto val : values)
+//-----------------------------------------------------------------------------
+//	Chunk coordinates of an infinite map may be negative. Once the map has
+//	been loaded it is moved so that the top left of the area covered by the
+//	chunks of all of the layers is at 0,0, and every layer is given the size
+//	of that area.
+//-----------------------------------------------------------------------------
+static
+std::error_code
+tmx_on_end_tag_map(SourceTileMap & tilemap)
+{
+	if(!tilemap.infinite())
+		return {};
+
+	int64_t left		= INT64_MAX;
+	int64_t top			= INT64_MAX;
+	int64_t right		= INT64_MIN;
+	int64_t bottom	= INT64_MIN;
+
+	tilemap.enumerate_layers([&](const SourceTileMapLayer & layer)->bool
 		{
-			// Tile values are offset by the 'firstgid' attribute of the tileset
-			// so we need to correct for that.
-			auto tile = strtoul(std::string(val).c_str(), nullptr, 10);
-			layer.set_tile(i++,tile == 0 ? 0 : tile-tileset.first_tile_id);
-		}
-	}
-	else
-		return std::make_error_code(std::errc::protocol_not_supported);
+			for(const auto & chunk : layer.m_chunks)
+			{
+				left		= std::min<int64_t>(left, chunk.x);
+				top			= std::min<int64_t>(top, chunk.y);
+				right		= std::max<int64_t>(right, int64_t(chunk.x) + chunk.width);
+				bottom	= std::max<int64_t>(bottom, int64_t(chunk.y) + chunk.height);
+			}
+			return true;
+		});
+
+	if(left > right)
+		left = top = right = bottom = 0;
 
-	tilemap.add_layer(p_layer);
+	if(((right - left) > UINT32_MAX) || ((bottom - top) > UINT32_MAX))
+		return std::make_error_code(std::errc::value_too_large);
+
+	const uint32_t width	= uint32_t(right - left);
+	const uint32_t height	= uint32_t(bottom - top);
+
+	tilemap.set_dimensions(width, height);
+	tilemap.set_origin(int32_t(left), int32_t(top));
+	tilemap.enumerate_layers([&](SourceTileMapLayer & layer)->bool
+		{
+			layer.m_width		= width;
+			layer.m_height	= height;
+			for(auto & chunk : layer.m_chunks)
+			{
+				chunk.x -= int32_t(left);
+				chunk.y -= int32_t(top);
+			}
+			return true;
+		});
+
+	gap::logger::verbose(TAG "Infinite map: {}x{} tiles from {},{}", width, height, left, top);
 
 	return {};
 }
@@ -236,9 +849,7 @@ tmx_on_start_tag_map( SourceTileMap & 											tilemap,
 	uint32_t 	tile_height 	= opt_tileheight ? std::strtoul(ade::unicode::to_string(opt_tileheight.value()).c_str(), nullptr, 10) : 0UL;
 	uint32_t 	infinite			= opt_infinite ? std::strtoul(ade::unicode::to_string(opt_infinite.value()).c_str(), nullptr, 10) : 0UL;
 
-	if(infinite > 0)
-		return std::make_error_code(std::errc::protocol_not_supported);
-
+	tilemap.set_infinite(infinite > 0);
 	tilemap.set_dimensions(width, height);
 	tilemap.set_tilesize(tile_width, tile_height);
 
@@ -248,6 +859,7 @@ tmx_on_start_tag_map( SourceTileMap & 											tilemap,
 static
 std::error_code
 tmx_on_start_tag( SourceTileMap & 											tilemap,
+									TmxStreamedLayer &										streamed,
 									const std::u8string &									path,
 									const std::vector<adexml::Element> & 	stack )
 {
@@ -271,6 +883,24 @@ tmx_on_start_tag( SourceTileMap & 											tilemap,
 		tileset.first_tile_id	= opt_firstgid ? std::strtoul(ade::unicode::to_string(opt_firstgid.value()).c_str(), nullptr, 10) : 0UL;
 		tilemap.set_tileset(tileset);
 	}
+	if((path == u8"map/layer/data") && (stack.size() >= 3))
+	{
+		auto p_layer = tmx_create_layer(stack[1], !tilemap.infinite());
+		if(p_layer == nullptr)
+			return std::make_error_code(std::errc::invalid_argument);
+
+		if(tilemap.infinite())
+		{
+			tilemap.add_layer(p_layer);
+			return {};
+		}
+
+		if(auto ec = streamed.data.begin(p_layer->m_data, stack[2], p_layer->m_name, tilemap.get_tileset().first_tile_id))
+			return ec;
+
+		streamed.p_layer		= p_layer;
+		streamed.b_content	= true;
+	}
 
 	return {};
 }
@@ -278,6 +908,7 @@ tmx_on_start_tag( SourceTileMap & 											tilemap,
 static
 std::error_code
 tmx_on_end_tag( SourceTileMap & 												tilemap,
+								TmxStreamedLayer &											streamed,
 								const std::u8string &										path,
 								const std::vector<adexml::Element> & 		stack )
 {
@@ -290,7 +921,13 @@ tmx_on_end_tag( SourceTileMap & 												tilemap,
 //	std::cout << "END:   " << ade::unicode::to_string(path) << std::endl;
 
 	if((path == u8"map/layer/data") && (stack.size() >= 3))
-		return tmx_on_end_tag_map_layer_data(tilemap, path, stack);
+		return tmx_on_end_tag_map_layer_data(tilemap, streamed);
+	if((path == u8"map/layer/data/chunk") && (stack.size() >= 4))
+		return tmx_on_end_tag_map_layer_data_chunk(tilemap, stack);
+	if(path == u8"map")
+		return tmx_on_end_tag_map(tilemap);
+	if(path.starts_with(u8"map/tileset/"))
+		return tsx_on_end_tag(tilemap.get_tileset(), std::u8string_view(path).substr(4), stack);
 
 	return {};
 }
@@ -298,42 +935,89 @@ tmx_on_end_tag( SourceTileMap & 												tilemap,
 std::unique_ptr<SourceTileMap>
 load_tiled_tmx(const std::string & filename, gap::FileSystem & filesystem)
 {
-	auto file = filesystem.load(filename);
-	if(file.empty())
-	{
-		std::cerr << "LOADTILEMAP: Failed to load tilemap '" << filename << "'\n";
-		return nullptr;
-	}
-
 	//---------------------------------------------------------------------------
 	// XML Parser
 	//---------------------------------------------------------------------------
 	auto p_tilemap = std::make_unique<SourceTileMap>();
 	auto & tilemap = *(p_tilemap.get());
 
+	TmxStreamedLayer streamed;
+
 	adexml::Parser parser([&](	adexml::Parser::Action 								action,
 															const std::u8string &									path,
 															const std::vector<adexml::Element> & 	stack ) -> std::error_code
 															{
 																switch(action)
 																{
-																	case adexml::Parser::ACTION_START_ELEMENT :	return tmx_on_start_tag(tilemap, path, stack); break;
-																	case adexml::Parser::ACTION_END_ELEMENT :		return tmx_on_end_tag(tilemap, path, stack); break;
+																	case adexml::Parser::ACTION_START_ELEMENT :	return tmx_on_start_tag(tilemap, streamed, path, stack); break;
+																	case adexml::Parser::ACTION_END_ELEMENT :		return tmx_on_end_tag(tilemap, streamed, path, stack); break;
 																	case adexml::Parser::ACTION_PI :						break; //std::cout << "PI:    "; print_element_path(std::cout, stack); std::cout.put('\n'); break;
-																	default : 																	std::cout << "UNKNOWN ACTION!\n"; return std::make_error_code(std::errc::invalid_argument);
+																	default : 																	gap::logger::error(TAG "UNKNOWN ACTION!"); return std::make_error_code(std::errc::invalid_argument);
 																};
 																return {};
 															});
 
-	std::span<char8_t> filedata(reinterpret_cast<char8_t *>(file.data()), file.size());
+	//---------------------------------------------------------------------------
+	// The file is read a piece at a time. The parser is given the text up to
+	// the end of each tag so that the content of a layer's <data> element can
+	// be sent to the layer as soon as the start tag has been parsed. The
+	// content ends at the next tag, which goes back to the parser.
+	//---------------------------------------------------------------------------
+	std::error_code	ec;
+	std::size_t			file_size = 0;
+
+	const bool b_read = filesystem.stream(filename, TMX_READ_SIZE, [&](std::span<uint8_t> bytes) -> bool
+		{
+			file_size += bytes.size();
+			while(!bytes.empty())
+			{
+				const char * p_text = reinterpret_cast<const char *>(bytes.data());
+
+				if(streamed.b_content)
+				{
+					const auto * p_tag	= static_cast<const char *>(std::memchr(p_text, '<', bytes.size()));
+					const auto length		= p_tag == nullptr ? bytes.size() : std::size_t(p_tag - p_text);
+
+					if((ec = streamed.data.write(std::string_view(p_text, length))))
+						return false;
+					if(p_tag != nullptr)
+						streamed.b_content = false;
+					bytes = bytes.subspan(length);
+				}
+				else
+				{
+					const auto * p_close	= static_cast<const char *>(std::memchr(p_text, '>', bytes.size()));
+					const auto length			= p_close == nullptr ? bytes.size() : std::size_t(p_close - p_text) + 1;
+
+					if((ec = parser.write(std::span<char8_t>(reinterpret_cast<char8_t *>(bytes.data()), length))))
+						return false;
+					bytes = bytes.subspan(length);
+				}
+			}
+			return true;
+		});
 
-	auto ec = parser.write(filedata);
 	if(ec)
 	{
-		std::cerr << TAG "(xmlparser): " << ec.message() << '\n';
+		gap::logger::error(TAG "(xmlparser): {}", ec.message());
+		return nullptr;
+	}
+
+	if(!b_read || (file_size == 0))
+	{
+		gap::logger::error("LOADTILEMAP: Failed to load tilemap '{}'", filename);
 		return nullptr;
 	}
 
+	// ----- The tile properties of an external tileset are in its TSX file. -----
+	auto & tileset = tilemap.get_tileset();
+	if(!tileset.sourcefile.empty())
+	{
+		const auto tsx_filename = (std::filesystem::path(filename).parent_path() / tileset.sourcefile).lexically_normal().generic_string();
+		if(!load_tiled_tsx(tsx_filename, filesystem, tileset))
+			gap::logger::verbose(TAG "Tileset '{}' could not be loaded, its tiles have no properties", tsx_filename);
+	}
+
 	return p_tilemap;
 }
 
@@ -357,10 +1041,8 @@ load(const std::string & filename, const std::string & type, gap::FileSystem & f
 
 	if(type == "tiled:tmx")			p_tilemap = load_tiled_tmx(filename, filesystem);
 
-	if(p_tilemap)
-	{
+	if(p_tilemap && gap::logger::enabled(gap::logger::TRACE))
 		print_tilemap(*p_tilemap);
-	}
 	return p_tilemap;
 }
 
@@ -374,44 +1056,50 @@ load(const std::string & filename, const std::string & type, gap::FileSystem & f
 void
 print_tilemap(const SourceTileMap & tilemap)
 {
-	printf("Tilemap\n------------------------------\n\n");
+	if(!gap::logger::enabled(gap::logger::TRACE))
+		return;
 
-	printf(FOREGROUND_LIGHT_BLUE "Dimensions: " FOREGROUND_GREY "%d x %d\n", tilemap.width(), tilemap.height());
-	printf(FOREGROUND_CYAN "\nLayers\n\n");
+	std::string out;
+	auto append = [&]<typename... Args>(std::format_string<Args...> fmt, Args &&... args) {std::format_to(std::back_inserter(out), fmt, std::forward<Args>(args)...);};
+
+	append("Tilemap\n------------------------------\n\n");
+	append(FOREGROUND_LIGHT_BLUE "Dimensions: " FOREGROUND_GREY "{} x {}\n", tilemap.width(), tilemap.height());
+	append(FOREGROUND_CYAN "\nLayers\n\n");
 
 	tilemap.enumerate_layers([&](const SourceTileMapLayer & layer)->bool
 		{
-			std::print(FOREGROUND_LIGHT_BLUE "ID       : " FOREGROUND_GREY "{}\n", layer.m_id);
-			std::print(FOREGROUND_LIGHT_BLUE "Name     : " FOREGROUND_GREY "{}\n", layer.m_name);
-			std::print(FOREGROUND_LIGHT_BLUE "position : " FOREGROUND_GREY "x:{}, y:{}\n", layer.m_x, layer.m_y);
-			std::print(FOREGROUND_LIGHT_BLUE "size     : " FOREGROUND_GREY "{} x {}\n", layer.m_width, layer.m_height);
+			append(FOREGROUND_LIGHT_BLUE "ID       : " FOREGROUND_GREY "{}\n", layer.m_id);
+			append(FOREGROUND_LIGHT_BLUE "Name     : " FOREGROUND_GREY "{}\n", layer.m_name);
+			append(FOREGROUND_LIGHT_BLUE "position : " FOREGROUND_GREY "x:{}, y:{}\n", layer.m_x, layer.m_y);
+			append(FOREGROUND_LIGHT_BLUE "size     : " FOREGROUND_GREY "{} x {}\n", layer.m_width, layer.m_height);
+
+			if(!layer.m_chunks.empty())
+				append(FOREGROUND_LIGHT_BLUE "chunks   : " FOREGROUND_GREY "{}\n", layer.m_chunks.size());
 
-			if((layer.m_x * layer.m_y) <= layer.m_data.size())
+			if((std::size_t(layer.m_width) * layer.m_height) == layer.m_data.size())
 			{
+				out.reserve(out.size() + (std::size_t(layer.m_width) * 6 + 16) * layer.m_height);
+
 				int i = 0;
 				for(uint32_t y = 0; y < layer.m_height; ++y)
 				{
 					for(uint32_t x = 0; x < layer.m_width; ++x)
 					{
 						auto tile = layer.m_data[i++];
-						ansi::stdio::background_colour(ansi::sgr::FG_BLACK + std::min<int>(tile,9));
-						//printf("\033[%dm",ansi::sgr::BG_BLACK + std::min<int>(tile,9));
-						printf("%c", tile == 0 ? '.' : (tile > 9 ? '#' : '0' + (char)(tile&0x7F)));
+						append("\033[{}m", ansi::sgr::BG_BLACK + std::min<int>(tile,9));
+						out.push_back(tile == 0 ? '.' : (tile > 9 ? '#' : '0' + (char)(tile&0x7F)));
 					}
-					ansi::stdio::background_colour(ansi::sgr::FG_BLACK);
-					ansi::stdio::reset_colour();
-					printf("\n");
+					append("\033[{}m" RESET_COLOUR "\n", ansi::sgr::BG_BLACK);
 				}
 			}
-			printf("\n\n");
+			out += "\n\n";
 			return true;
 		});
 
-	printf("\n------------------------------\n\n");
+	out += "\n------------------------------\n\n";
 
+	gap::logger::write(gap::logger::TRACE, out);
 }
 
-
-
 } // namespace gap::tilemap
 
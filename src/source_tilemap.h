@@ -12,8 +12,13 @@
 #define GUARD_ADE_GAME_ASSET_PACKER_SOURCE_TILEMAP_H
 
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cmath>
 #include <utility>
 #include "filesystem.h"
@@ -22,15 +27,32 @@
 namespace gap::tilemap
 {
 
+// A rectangle of tiles from an infinite map. Once the map has been loaded
+// the coordinates are relative to the top left of the map.
+struct SourceTileMapChunk
+{
+	int32_t									x				= 0;
+	int32_t									y				= 0;
+	uint32_t								width		= 0;
+	uint32_t								height	= 0;
+	std::vector<uint64_t>		data;
+};
+
+//-----------------------------------------------------------------------------
+//	The tiles of a layer are either held in m_data, one for every tile of the
+//	layer, or for an infinite map in m_chunks, which only cover the areas
+//	that have tiles. Tiles outside of the chunks are 0.
+//-----------------------------------------------------------------------------
 struct SourceTileMapLayer
 {
-	uint32_t								m_id 			= 0;
-	uint32_t 								m_x 			= 0;
-	uint32_t 								m_y 			= 0;
-	uint32_t								m_width 	= 0;
-	uint32_t								m_height 	= 0;
-	std::string							m_name;
-	std::vector<uint64_t>		m_data;
+	uint32_t												m_id 			= 0;
+	uint32_t 												m_x 			= 0;
+	uint32_t 												m_y 			= 0;
+	uint32_t												m_width 	= 0;
+	uint32_t												m_height 	= 0;
+	std::string											m_name;
+	std::vector<uint64_t>						m_data;
+	std::vector<SourceTileMapChunk>	m_chunks;
 
 	SourceTileMapLayer() = default;
 	SourceTileMapLayer(uint32_t id, std::string_view name, uint32_t width, uint32_t height);
@@ -39,6 +61,20 @@ struct SourceTileMapLayer
 	void				set_tile(std::size_t index, uint64_t value);
 	void				set_tile(uint32_t x, uint32_t y, uint64_t value);
 	uint64_t		get_tile(uint32_t x, uint32_t y) const;
+	bool				empty() const noexcept											{return m_data.empty() && m_chunks.empty();}
+	uint64_t		largest_tile() const;
+
+	// Call 'callback' with each rectangle of stored tiles inside the region,
+	// the dense layer or a chunk, whose rows are 'stride' tiles apart.
+	void				enumerate_rects(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+															std::function<void(uint32_t x, uint32_t y, uint32_t width, uint32_t height, std::span<const uint64_t> tiles, std::size_t stride)> callback) const;
+};
+
+struct SourceTileProperty
+{
+	std::string		name;
+	std::string		type;
+	std::string		value;
 };
 
 struct SourceTileSet
@@ -46,6 +82,18 @@ struct SourceTileSet
 	std::string 	sourcefile;
 	std::string		sourcetype;
 	uint32_t			first_tile_id = 0;
+
+	// The class and the custom properties of the tiles that have them, by
+	// the id of the tile within the tileset.
+	std::map<uint32_t, std::string>											tile_classes;
+	std::map<uint32_t, std::vector<SourceTileProperty>>	tile_properties;
+
+	bool					tile_flag(uint32_t tile_id, std::string_view name) const;
+
+	// The flags of each tile value from 0 to 'largest_tile', with bit n set
+	// for flag_names[n]. Tile values are stored as the tile id, so value 0 is
+	// both an empty cell and tile 0 of the tileset. It never has flags.
+	std::vector<uint32_t>	tile_flags(std::span<const std::string> flag_names, uint64_t largest_tile) const;
 };
 
 class SourceTileMap
@@ -55,6 +103,9 @@ private:
 	uint32_t 					m_height 				= 0;
 	uint32_t 					m_tile_width 		= 0;
 	uint32_t 					m_tile_height 	= 0;
+	int32_t						m_origin_x			= 0;
+	int32_t						m_origin_y			= 0;
+	bool							m_b_infinite		= false;
 	SourceTileSet			m_tileset;
 
 	std::vector<std::shared_ptr<SourceTileMapLayer>>	m_layers;
@@ -65,10 +116,19 @@ public:
 
 	void												set_dimensions(uint32_t width, uint32_t height)						{	m_width = width; m_height = height; }
 	void												set_tilesize(uint32_t tilewidth, uint32_t tileheight)			{	m_tile_width = tilewidth; m_tile_height = tileheight; }
+	void												set_infinite(bool b_infinite)															{m_b_infinite = b_infinite;}
+	bool												infinite() const																					{return m_b_infinite;}
+	// Position in the Tiled map of tile 0,0 (non-zero for infinite maps).
+	void												set_origin(int32_t x, int32_t y)													{m_origin_x = x; m_origin_y = y;}
+	int32_t											origin_x() const																					{return m_origin_x;}
+	int32_t											origin_y() const																					{return m_origin_y;}
 	void												add_layer(std::shared_ptr<SourceTileMapLayer> p_layer)		{m_layers.push_back(p_layer);}
+	SourceTileMapLayer *				last_layer()																							{return m_layers.empty() ? nullptr : m_layers.back().get();}
 	void												enumerate_layers(std::function<bool(const SourceTileMapLayer &)> callback) const;
+	void												enumerate_layers(std::function<bool(SourceTileMapLayer &)> callback);
 	void												set_tileset(const SourceTileSet & tileset)								{m_tileset = tileset;}
 	const SourceTileSet &				get_tileset() const 																			{return m_tileset;}
+	SourceTileSet &							get_tileset() 																						{return m_tileset;}
 	const SourceTileMapLayer * 	get_layer(uint32_t id);
 };
 
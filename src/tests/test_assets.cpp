@@ -0,0 +1,227 @@
+//=============================================================================
+//	FILE:					test_assets.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Checks the sharing of source images between LOADIMAGE
+//								commands that load the same file and their release
+//								once they have been encoded.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "test_assets.h"
+#include "tests.h"
+#include "assets.h"
+#include "encode_gbin.h"
+
+static
+std::unique_ptr<gap::image::SourceImage>
+make_image(int width, int height, uint32_t colour)
+{
+	std::vector<uint32_t> pixels(width * height, colour);
+	auto p_image = std::make_unique<gap::image::SourceImage>(width, height, pixels.data());
+	p_image->set_source_pixelformat(gap::image::pixelformat::ARGB8888);
+	p_image->set_target_pixelformat(gap::image::pixelformat::ARGB8888);
+	return p_image;
+}
+
+//-----------------------------------------------------------------------------
+//	A file is found again by its path, normalised, while its content hash is
+//	unchanged. Asking for another target pixel format adds a view of the same
+//	pixels.
+//-----------------------------------------------------------------------------
+static
+int
+test_source_cache(int & count)
+{
+	int failures = 0;
+	gap::assets::Assets assets;
+
+	++count;
+	check(assets.find_source_image("art/sheet.png", 1) < 0, "cache: found an image that was never loaded", failures);
+
+	auto p_sheet = make_image(16, 8, 0xFF204060U);
+	p_sheet->set_target_pixelformat(gap::image::pixelformat::RGB565);
+	const int sheet = assets.add_source_image(std::move(p_sheet), "art/sheet.png", 1);
+	const int other = assets.add_source_image(make_image(4, 4, 0xFF000000U), "art/other.png", 2);
+
+	count += 4;
+	check(assets.find_source_image("art/sheet.png", 1, gap::image::pixelformat::RGB565) == sheet, "cache: same format", failures);
+	check(assets.find_source_image("art/../art/sheet.png", 1, gap::image::pixelformat::RGB565) == sheet, "cache: path is not normalised", failures);
+	check(assets.find_source_image("art/sheet.png", 3) < 0, "cache: changed file was found", failures);
+	check(assets.find_source_image("art/other.png", 2) == other, "cache: second image", failures);
+
+	// ----- Views -----
+	const int native		= assets.find_source_image("art/sheet.png", 1);
+	const int argb4444	= assets.find_source_image("art/sheet.png", 1, gap::image::pixelformat::ARGB4444);
+
+	count += 6;
+	check((native >= 0) && (native != sheet) && (native != other), "view: no view for the source pixel format", failures);
+	check((argb4444 >= 0) && (argb4444 != native) && (argb4444 != sheet), "view: no view for ARGB4444", failures);
+	check(assets.get_target_pixelformat(native) == gap::image::pixelformat::ARGB8888, "view: native format", failures);
+	check(assets.get_target_pixelformat(argb4444) == gap::image::pixelformat::ARGB4444, "view: ARGB4444 format", failures);
+	check(assets.find_source_image("art/sheet.png", 1, gap::image::pixelformat::ARGB4444) == argb4444, "view: view was not reused", failures);
+	check(	(assets.source_image_width(argb4444) == 16) && (assets.source_image_height(argb4444) == 8) &&
+					(assets.get_target_subimage(argb4444, 0, 0, 16, 8, gap::image::pixelformat::ARGB8888, false) ==
+					 assets.get_target_subimage(sheet, 0, 0, 16, 8, gap::image::pixelformat::ARGB8888, false)),
+					"view: pixels differ from the loaded image", failures);
+
+	++count;
+	check(assets.source_image_count() == 4, "cache: source image count", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Images and tiles are cut from two source images, interleaved so that the
+//	encoder has to run them out of order to release the sources early. The
+//	output must not change and every source must be released afterwards.
+//-----------------------------------------------------------------------------
+static
+void
+add_release_assets(gap::assets::Assets & assets)
+{
+	const int red		= assets.add_source_image(make_image(16, 16, 0xFFFF0000U));
+	const int green	= assets.add_source_image(make_image(16, 16, 0xFF00FF00U));
+
+	assets.add_image_group("sprites");
+	for(int i=0; i<4; ++i)
+	{
+		gap::image::Image image;
+		image.name					= "image" + std::to_string(i);
+		image.source_image	= (i & 1) ? green : red;
+		image.x							= 4 * i;
+		image.width					= 4;
+		image.height				= 8;
+		image.pixel_format	= gap::image::pixelformat::RGB565;
+		assets.add_image(image);
+	}
+
+	gap::tileset::TileSet tileset;
+	tileset.name					= "tiles";
+	tileset.id						= assets.generate_tileset_id();
+	tileset.tile_width		= 8;
+	tileset.tile_height		= 8;
+	tileset.pixel_format	= gap::image::pixelformat::ARGB8888;
+	assets.add_tileset(tileset);
+	assets.add_tile(tileset.id, {0, 8, uint16_t(green), 0});
+	assets.add_tile(tileset.id, {8, 8, uint16_t(red), gap::tileset::ROTATE_90});
+}
+
+static
+int
+test_release(int & count)
+{
+	int failures = 0;
+	gap::Configuration config;
+
+	gap::assets::Assets retained;
+	add_release_assets(retained);
+	std::vector<uint8_t> expected;
+	gap::encode_packed_image_chunks(expected, retained, config);
+
+	gap::assets::Assets released;
+	add_release_assets(released);
+	released.set_release_source_images(true);
+
+	count += 2;
+	check(released.source_image_consumers() == std::vector<int>{3, 3}, "release: consumer count", failures);
+	check(retained.source_image_width(0) == 16, "release: retained image was released", failures);
+
+	std::vector<uint8_t> data;
+	gap::encode_packed_image_chunks(data, released, config);
+
+	count += 2;
+	check(!data.empty() && (data == expected), "release: output differs from the retained build", failures);
+	check((released.source_image_width(0) == 0) && (released.source_image_width(1) == 0), "release: source image was not released", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Images that take the same region of a source image at different angles
+//	are rotated together as one batch. Giving each image its own copy of the
+//	source stops the batching, and the output must be byte for byte the same.
+//-----------------------------------------------------------------------------
+static
+void
+add_rotation_assets(gap::assets::Assets & assets, bool b_batched)
+{
+	constexpr int W = 24;
+	constexpr int H = 16;
+
+	std::vector<uint32_t> pixels(W * H);
+	for(int y=0; y<H; ++y)
+		for(int x=0; x<W; ++x)
+			pixels[(y * W) + x] = ((x + y) < 6) ? 0U : (0xFF000000U | (uint32_t(x * 10) << 16) | (uint32_t(y * 15) << 8) | 0x40U);
+
+	static constexpr float angles[] = {0.0f, 30.0f, 90.0f, 135.0f, 180.0f, 250.0f, 270.0f, 330.0f};
+
+	assets.add_image_group("ship");
+
+	int source = -1;
+	for(std::size_t i=0; i<std::size(angles); ++i)
+	{
+		if(!b_batched || (source < 0))
+		{
+			auto p_source = std::make_unique<gap::image::SourceImage>(W, H, pixels.data());
+			p_source->set_source_pixelformat(gap::image::pixelformat::ARGB8888);
+			p_source->set_target_pixelformat(gap::image::pixelformat::ARGB8888);
+			source = assets.add_source_image(std::move(p_source));
+		}
+
+		gap::image::Image image;
+		image.name					= "ship" + std::to_string(i);
+		image.source_image	= uint16_t(source);
+		image.x							= 2;
+		image.y							= 1;
+		image.width					= 20;
+		image.height				= 14;
+		image.x_origin			= 10;
+		image.y_origin			= 7;
+		image.pixel_format	= gap::image::pixelformat::ARGB8888;
+		image.angle					= angles[i];
+		image.b_trim				= true;
+		assets.add_image(image);
+	}
+}
+
+static
+int
+test_batched_rotation(int & count)
+{
+	int failures = 0;
+	gap::Configuration config;
+
+	gap::assets::Assets batched;
+	add_rotation_assets(batched, true);
+	std::vector<uint8_t> batched_data;
+	gap::encode_packed_image_chunks(batched_data, batched, config);
+
+	gap::assets::Assets single;
+	add_rotation_assets(single, false);
+	std::vector<uint8_t> single_data;
+	gap::encode_packed_image_chunks(single_data, single, config);
+
+	count += 2;
+	check((batched.source_image_count() == 1) && (single.source_image_count() == 8), "batch: source image count", failures);
+	check(!batched_data.empty() && (batched_data == single_data), "batch: output differs from rotating each image on its own", failures);
+
+	return failures;
+}
+
+int
+test_assets(const gap::Configuration & /*config*/, gap::FileSystem & /*filesystem*/)
+{
+	int count			= 0;
+	int failures	= test_source_cache(count);
+	failures += test_release(count);
+	failures += test_batched_rotation(count);
+
+	return report_checks("assets", count, failures);
+}
@@ -0,0 +1,235 @@
+//=============================================================================
+//	FILE:					test_atlas.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Checks the atlas packer and that images encoded in atlas
+//								mode can be read back through their IMAG entries.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <cstring>
+#include <format>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "test_atlas.h"
+#include "tests.h"
+#include "assets.h"
+#include "atlas.h"
+#include "encode_gbin.h"
+
+struct Random
+{
+	uint32_t	state;
+
+	uint32_t	next()								{state = (state * 1664525U) + 1013904223U; return state >> 8;}
+	int				next(int lo, int hi)	{return lo + int(next() % uint32_t(hi - lo + 1));}
+};
+
+//-----------------------------------------------------------------------------
+//	Every rectangle must be placed within its page and must not overlap any
+//	other rectangle on the same page.
+//-----------------------------------------------------------------------------
+static
+int
+test_packer(int & count)
+{
+	static constexpr int PAGE_SIZE = 128;
+
+	int failures = 0;
+	Random rng{1};
+
+	std::vector<gap::image::Rect> sizes;
+	for(int i=0; i<400; ++i)
+		sizes.push_back(gap::image::Rect{0, 0, rng.next(1,40), rng.next(1,40)});
+	sizes.push_back(gap::image::Rect{0, 0, PAGE_SIZE + 1, 8});			// Too large
+	sizes.push_back(gap::image::Rect{0, 0, 0, 0});										// Empty
+
+	const auto layout = gap::atlas::pack(sizes, PAGE_SIZE, PAGE_SIZE);
+
+	++count;
+	check(layout.placements.size() == sizes.size(), "pack: placement count", failures);
+
+	for(std::size_t i=0; i<400; ++i)
+	{
+		const auto & a = layout.placements[i];
+		++count;
+		if(!check((a.page >= 0) && std::cmp_less(a.page, layout.pages.size()), std::format("pack: rectangle {} was not placed", i), failures))
+			continue;
+
+		const auto & page = layout.pages[a.page];
+		bool b_pass = (a.x >= 0) && (a.y >= 0) && ((a.x + sizes[i].width) <= page.width) && ((a.y + sizes[i].height) <= page.height);
+
+		for(std::size_t j=i+1; b_pass && (j<400); ++j)
+		{
+			const auto & b = layout.placements[j];
+			b_pass = 	(a.page != b.page) ||
+								(a.x >= (b.x + sizes[j].width)) || (b.x >= (a.x + sizes[i].width)) ||
+								(a.y >= (b.y + sizes[j].height)) || (b.y >= (a.y + sizes[i].height));
+		}
+
+		check(b_pass, std::format("pack: rectangle {} is outside its page or overlaps another", i), failures);
+	}
+
+	count += 2;
+	check(layout.placements[400].page < 0, "pack: oversized rectangle was placed", failures);
+	check(layout.placements[401].page < 0, "pack: empty rectangle was placed", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Encode a sheet of sprites with transparent margins in atlas mode, then read
+//	each image back from IMGD using its IMAG entry and compare it, origin
+//	aligned, with the source sprite.
+//-----------------------------------------------------------------------------
+static
+uint32_t
+read_u32(const std::vector<uint8_t> & data, std::size_t offset)
+{
+	return data[offset] | (data[offset+1] << 8) | (data[offset+2] << 16) | (uint32_t(data[offset+3]) << 24);
+}
+
+static
+uint16_t
+read_u16(const std::vector<uint8_t> & data, std::size_t offset)
+{
+	return data[offset] | (data[offset+1] << 8);
+}
+
+static
+int
+test_encode(int & count)
+{
+	static constexpr int SPRITE		= 32;
+	static constexpr int ACROSS		= 8;
+	static constexpr int DOWN			= 4;
+
+	int failures = 0;
+	Random rng{7};
+
+	// ----- Each sprite is a randomly sized block, some are empty or repeated. -----
+	std::vector<uint32_t> pixels(SPRITE * ACROSS * SPRITE * DOWN, 0);
+	const int stride = SPRITE * ACROSS;
+	for(int i=0; i<ACROSS*DOWN; ++i)
+	{
+		if((i % 7) == 3)
+			continue;
+
+		const int sx	= (i % ACROSS) * SPRITE;
+		const int sy	= (i / ACROSS) * SPRITE;
+		Random shape{(i % 5) == 4 ? 99U : uint32_t(i + 1)};
+		const int x0	= shape.next(0, SPRITE-2);
+		const int y0	= shape.next(0, SPRITE-2);
+		const int x1	= shape.next(x0+1, SPRITE);
+		const int y1	= shape.next(y0+1, SPRITE);
+		for(int y=y0; y<y1; ++y)
+			for(int x=x0; x<x1; ++x)
+				pixels[((sy + y) * stride) + sx + x] = 0xFF000000U | (shape.next() & 0x0FFFFFFU);
+	}
+
+	gap::assets::Assets assets;
+	gap::assets::AtlasSettings settings;
+	settings.b_enabled		= true;
+	settings.page_width		= 64;
+	settings.page_height	= 64;
+	assets.set_atlas_settings(settings);
+
+	const int source = assets.add_source_image(std::make_unique<gap::image::SourceImage>(stride, SPRITE * DOWN, pixels.data()));
+	assets.add_image_group("sprites");
+
+	std::vector<gap::image::Image> sprites;
+	for(int i=0; i<ACROSS*DOWN; ++i)
+	{
+		gap::image::Image image;
+		image.source_image	= source;
+		image.x							= (i % ACROSS) * SPRITE;
+		image.y							= (i / ACROSS) * SPRITE;
+		image.width					= SPRITE;
+		image.height				= SPRITE;
+		image.x_origin			= rng.next(0, SPRITE-1);
+		image.y_origin			= rng.next(0, SPRITE-1);
+		image.pixel_format	= gap::image::pixelformat::ARGB8888;
+		sprites.push_back(image);
+	}
+
+	// The whole sheet, which is larger than a page.
+	gap::image::Image sheet;
+	sheet.source_image	= source;
+	sheet.width					= stride;
+	sheet.height				= SPRITE * DOWN;
+	sheet.pixel_format	= gap::image::pixelformat::ARGB8888;
+	sprites.push_back(sheet);
+
+	for(auto & image : sprites)
+		assets.add_image(image);
+
+	gap::Configuration config;
+	std::vector<uint8_t> data;
+	gap::encode_packed_image_chunks(data, assets, config);
+
+	// ----- Locate the IMGD and IMAG chunks. -----
+	std::size_t imgd = 0;
+	std::size_t imag = 0;
+	for(std::size_t offset = 0; (offset + 8) <= data.size(); offset += 8 + read_u32(data, offset + 4))
+	{
+		if(std::memcmp(&data[offset], "IMGD", 4) == 0)	imgd = offset + 8;
+		if(std::memcmp(&data[offset], "IMAG", 4) == 0)	imag = offset + 8;
+	}
+
+	++count;
+	if(!check((imgd != 0) && (imag != 0), "encode: missing IMGD or IMAG chunk", failures))
+		return failures;
+
+	std::size_t packed_pixels = 0;
+
+	for(std::size_t i=0; i<sprites.size(); ++i)
+	{
+		const auto & sprite	= sprites[i];
+		const std::size_t entry	= imag + (i * 16);
+		const int width				= read_u16(data, entry);
+		const int height			= read_u16(data, entry + 2);
+		const int x_origin		= int16_t(read_u16(data, entry + 4));
+		const int y_origin		= int16_t(read_u16(data, entry + 6));
+		const int line_offset	= read_u16(data, entry + 8);
+		const uint32_t offset	= read_u32(data, entry + 12);
+
+		packed_pixels += width * height;
+
+		bool b_pass = true;
+		for(int y=0; b_pass && (y<sprite.height); ++y)
+		{
+			for(int x=0; b_pass && (x<sprite.width); ++x)
+			{
+				const uint32_t expected = pixels[((sprite.y + y) * stride) + sprite.x + x];
+				const int tx = x - sprite.x_origin + x_origin;
+				const int ty = y - sprite.y_origin + y_origin;
+
+				if((tx >= 0) && (ty >= 0) && (tx < width) && (ty < height))
+					b_pass = read_u32(data, imgd + offset + (((ty * (width + line_offset)) + tx) * 4)) == expected;
+				else
+					b_pass = (expected >> 24) == 0;
+			}
+		}
+
+		++count;
+		check(b_pass, std::format("encode: image {} does not match its source", i), failures);
+	}
+
+	++count;
+	check(packed_pixels < pixels.size() * 2, "encode: images were not trimmed", failures);
+
+	return failures;
+}
+
+int
+test_atlas(const gap::Configuration & /*config*/, gap::FileSystem & /*filesystem*/)
+{
+	int count			= 0;
+	int failures	= test_packer(count);
+	failures += test_encode(count);
+
+	return report_checks("atlas", count, failures);
+}
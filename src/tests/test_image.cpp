@@ -0,0 +1,586 @@
+//=============================================================================
+//	FILE:					test_image.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Checks the SourceImage transforms against simple reference
+//								implementations.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <functional>
+#include <print>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "test_image.h"
+#include "tests.h"
+#include "image.h"
+#include "image_rle.h"
+#include "image_compress.h"
+#include "image_transform.h"
+
+struct ReferenceImage
+{
+	int										width		= 0;
+	int										height	= 0;
+	std::vector<uint32_t>	pixels;
+
+	uint32_t	at(int x, int y) const	{return pixels[(y * width) + x];}
+};
+
+static
+ReferenceImage
+make_reference(int width, int height)
+{
+	ReferenceImage image{width, height, std::vector<uint32_t>(width * height)};
+	for(int y=0; y<height; ++y)
+		for(int x=0; x<width; ++x)
+			image.pixels[(y * width) + x] = 0xFF000000U | (y << 12) | x;
+	return image;
+}
+
+// Build a new reference image of the given size where each pixel is taken
+// from the source coordinate returned by 'map'.
+static
+ReferenceImage
+remap(const ReferenceImage & src, int width, int height, const std::function<std::pair<int,int>(int,int)> & map)
+{
+	ReferenceImage dest{width, height, std::vector<uint32_t>(width * height)};
+	for(int y=0; y<height; ++y)
+		for(int x=0; x<width; ++x)
+		{
+			const auto [sx, sy] = map(x, y);
+			dest.pixels[(y * width) + x] = src.at(sx, sy);
+		}
+	return dest;
+}
+
+static
+bool
+compare(std::string_view name, gap::image::SourceImage & image, const ReferenceImage & expected)
+{
+	bool b_pass = (image.width() == expected.width) && (image.height() == expected.height);
+
+	for(int y=0; b_pass && (y<expected.height); ++y)
+		for(int x=0; b_pass && (x<expected.width); ++x)
+			b_pass = (image.get_pixel(x,y) == expected.at(x,y));
+
+	if(!b_pass)
+		std::println("FAIL: {} {}x{}", name, expected.width, expected.height);
+
+	return b_pass;
+}
+
+//-----------------------------------------------------------------------------
+//	Compare opaque_bounds() against a brute force search for images with a few
+//	opaque pixels scattered at random, including on the edges.
+//-----------------------------------------------------------------------------
+static
+int
+test_opaque_bounds(int & count)
+{
+	int failures = 0;
+	uint32_t seed = 1;
+	auto random = [&](int range) {seed = (seed * 1664525U) + 1013904223U; return int((seed >> 8) % uint32_t(range));};
+
+	for(int iteration = 0; iteration < 500; ++iteration)
+	{
+		const int w = 1 + random(70);
+		const int h = 1 + random(20);
+		const int opaque = random(4);
+
+		std::vector<uint32_t> pixels(w * h, 0x00FFFFFFU);			// Transparent but not zero.
+		for(int i=0; i<opaque; ++i)
+			pixels[random(w * h)] = uint32_t(1 + random(255)) << 24;
+
+		int left = w, top = h, right = 0, bottom = 0;
+		for(int y=0; y<h; ++y)
+			for(int x=0; x<w; ++x)
+				if(pixels[(y * w) + x] >> 24)
+				{
+					left		= std::min(left, x);
+					top			= std::min(top, y);
+					right		= std::max(right, x+1);
+					bottom	= std::max(bottom, y+1);
+				}
+
+		const gap::image::Rect expected = (right > 0) ? gap::image::Rect{left, top, right-left, bottom-top} : gap::image::Rect{};
+		const auto bounds = gap::image::SourceImage(w, h, pixels.data()).opaque_bounds();
+
+		++count;
+		if(	(bounds.x != expected.x) || (bounds.y != expected.y) ||
+				(bounds.width != expected.width) || (bounds.height != expected.height) )
+		{
+			std::println("FAIL: opaque_bounds {}x{} got {},{} {}x{} expected {},{} {}x{}", w, h,
+										bounds.x, bounds.y, bounds.width, bounds.height, expected.x, expected.y, expected.width, expected.height);
+			++failures;
+		}
+	}
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Encoding options. Premultiplying must round correctly, 4-bit formats must
+//	pack two pixels per byte, and dithering a smooth gradient must keep its
+//	average brightness where plain truncation loses up to a whole level.
+//-----------------------------------------------------------------------------
+static
+int
+test_encode_options(int & count)
+{
+	namespace pf = gap::image::pixelformat;
+	int failures = 0;
+
+	{
+		const uint32_t pixels[] = {0x80FF8040U, 0x00FFFFFFU, 0xFF123456U, 0x01FFFFFFU};
+		gap::image::SourceImage image(4, 1, pixels);
+		const auto data = image.create_sub_target_data(0, 0, 4, 1, pf::ARGB8888, false, gap::image::EncodeOptions{true, gap::image::DITHER_NONE});
+		const std::vector<uint8_t> expected = {0x20,0x40,0x80,0x80, 0,0,0,0, 0x56,0x34,0x12,0xFF, 1,1,1,1};
+		++count;
+		check(data == expected, "premultiply", failures);
+	}
+
+	{
+		const uint32_t pixels[] = {0xFF000000U, 0xFFFFFFFFU, 0xFF888888U, 0x10000000U, 0xF0000000U, 0x20000000U};
+		gap::image::SourceImage image(3, 2, pixels);
+		++count;
+		check(image.create_sub_target_data(0, 0, 3, 2, pf::L4, false) == std::vector<uint8_t>{0xF0, 0x08, 0x00, 0x00}, "L4 packing", failures);
+		++count;
+		check(image.create_sub_target_data(0, 0, 3, 2, pf::A4, false) == std::vector<uint8_t>{0xFF, 0x0F, 0xF1, 0x02}, "A4 packing", failures);
+	}
+
+	// ----- Horizontal gradient, 0 to 255 in red, green and blue. -----
+	static constexpr int W = 256;
+	static constexpr int H = 64;
+	std::vector<uint32_t> gradient(W * H);
+	for(int y=0; y<H; ++y)
+		for(int x=0; x<W; ++x)
+			gradient[(y * W) + x] = 0xFF000000U | (uint32_t(x) * 0x010101U);
+	gap::image::SourceImage image(W, H, gradient.data());
+
+	for(const auto & [format, bits, format_name] : {std::tuple{uint8_t(pf::RGB565), 5, "RGB565"}, std::tuple{uint8_t(pf::L4), 4, "L4"}})
+	{
+		for(const auto & [mode, mode_name] : {std::pair{gap::image::DITHER_ORDERED, "ordered"}, std::pair{gap::image::DITHER_DIFFUSION, "diffusion"}})
+		{
+			const auto data = image.create_sub_target_data(0, 0, W, H, format, false, gap::image::EncodeOptions{false, uint8_t(mode)});
+			const int max = (1 << bits) - 1;
+
+			// The top 'bits' of the first (red or luminance) channel of pixel x,y
+			auto level = [&](int x, int y) -> int
+			{
+				if(format == pf::L4)
+					return (data[(y * (W/2)) + (x/2)] >> ((x & 1) * 4)) & 0x0F;
+				return (data[((y * W) + x) * 2 + 1] >> 3) & 0x1F;
+			};
+
+			// Compare the mean of each 16 column band with the source.
+			double worst = 0.0;
+			for(int band=0; band<W; band+=16)
+			{
+				double sum = 0.0;
+				for(int y=0; y<H; ++y)
+					for(int x=band; x<band+16; ++x)
+						sum += (level(x,y) * 255.0) / max;
+				worst = std::max(worst, std::abs((sum / (16 * H)) - (band + 7.5)));
+			}
+
+			const double step = 255.0 / max;
+			++count;
+			check(worst < (step / 4), std::format("dither {} {}: mean error {:.2f}", format_name, mode_name, worst), failures);
+		}
+	}
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	RLE round trip. Decoding the RLE data must give the same bytes as the raw
+//	base format. Transparent source pixels are zero so that both encode them
+//	as zero.
+//-----------------------------------------------------------------------------
+static
+int
+test_rle(int & count)
+{
+	namespace pf = gap::image::pixelformat;
+	int failures = 0;
+	uint32_t seed = 5;
+	auto random = [&](int range) {seed = (seed * 1664525U) + 1013904223U; return int((seed >> 8) % uint32_t(range));};
+
+	static constexpr std::pair<int,int> sizes[] = {{1,1}, {7,3}, {64,64}, {300,5}, {600,2}};
+
+	for(const auto & [w, h] : sizes)
+	{
+		// Runs of random length, mostly transparent, so that spans of more than
+		// 255 pixels appear in the wider images.
+		std::vector<uint32_t> pixels(w * h, 0);
+		for(std::size_t i=0; i<pixels.size();)
+		{
+			const int run = 1 + random(w < 300 ? 8 : 400);
+			const bool b_opaque = random(3) == 0;
+			for(int n=0; (n < run) && (i < pixels.size()); ++n, ++i)
+				pixels[i] = b_opaque ? (uint32_t(1 + random(255)) << 24) | uint32_t(random(0x1000000)) : 0;
+		}
+
+		gap::image::SourceImage image(w, h, pixels.data());
+
+		for(const uint8_t format : {uint8_t(pf::ARGB8888), uint8_t(pf::RGB565), uint8_t(pf::ARGB4444), uint8_t(pf::A8)})
+		{
+			for(const bool b_big_endian : {false, true})
+			{
+				const auto raw			= image.create_sub_target_data(0, 0, w, h, format, b_big_endian);
+				const auto rle			= image.create_sub_target_data(0, 0, w, h, pf::RLE | format, b_big_endian);
+				const auto decoded	= gap::image::rle_decode(rle, w, h, format, b_big_endian);
+
+				++count;
+				check(	!decoded.empty() && (decoded == raw),
+								std::format("rle round trip {} {}x{}{}", gap::image::get_pixelformat_name(pf::RLE | format), w, h, b_big_endian ? " big endian" : ""), failures);
+			}
+		}
+	}
+
+	// ----- Malformed data must be rejected rather than overrun. -----
+	const std::vector<uint8_t> truncated = {4,0,0,0, 2,3,0xFF};
+	++count;
+	check(gap::image::rle_decode(truncated, 4, 1, pf::A8, false).empty(), "rle truncated data", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Block compression. The encoded data is decoded with the reference decoder
+//	and compared with the source by PSNR. The source is a smooth colour field
+//	with a little noise, which is what the formats are designed for. The high
+//	quality mode must be at least as good as the fast mode.
+//-----------------------------------------------------------------------------
+static
+double
+psnr(const std::vector<uint32_t> & source, const std::vector<uint32_t> & decoded, const std::vector<int> & channels, bool b_opaque_only)
+{
+	double	sum			= 0.0;
+	int			samples	= 0;
+	for(std::size_t i=0; i<source.size(); ++i)
+	{
+		if(b_opaque_only && ((source[i] >> 24) < 128))
+			continue;
+		for(int shift : channels)
+		{
+			const int d = int((source[i] >> shift) & 0x0FF) - int((decoded[i] >> shift) & 0x0FF);
+			sum += d * d;
+			++samples;
+		}
+	}
+	if(sum == 0.0)
+		return 99.0;
+	return 10.0 * std::log10((255.0 * 255.0) / (sum / samples));
+}
+
+static
+int
+test_block_compression(int & count)
+{
+	namespace pf = gap::image::pixelformat;
+	int failures = 0;
+
+	uint32_t seed = 12345;
+	auto random = [&](int range) {seed = (seed * 1664525U) + 1013904223U; return int((seed >> 8) % uint32_t(range));};
+
+	static constexpr std::pair<int,int> sizes[] = {{4,4}, {1,1}, {13,7}, {64,64}, {130,67}};
+
+	for(const auto & [w, h] : sizes)
+	{
+		// Smooth gradients with noise. Alpha is a gradient for the alpha formats
+		// and a hard edge for BC1, which only keeps one bit.
+		std::vector<uint32_t> smooth(w * h);
+		std::vector<uint32_t> cutout(w * h);
+		for(int y=0; y<h; ++y)
+			for(int x=0; x<w; ++x)
+			{
+				const int r = std::clamp(std::abs(((x * 3) % 510) - 255) + random(9) - 4, 0, 255);
+				const int g = std::clamp(std::abs(((y * 5) % 510) - 255) + random(9) - 4, 0, 255);
+				const int b = std::clamp(128 + int(100.0 * std::sin((x + y) * 0.1)) + random(9) - 4, 0, 255);
+				const int a = std::abs((((x + y) * 4) % 510) - 255);
+				const uint32_t rgb = (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+				smooth[(y * w) + x] = (uint32_t(a) << 24) | rgb;
+				cutout[(y * w) + x] = ((((x / 3) + y) % 5) == 0 ? 0U : 0xFF000000U) | rgb;
+			}
+
+		struct Case {uint8_t format; const std::vector<uint32_t> * p_source; std::vector<int> colour; std::vector<int> alpha; double min_colour; double min_alpha;};
+		const Case cases[] =
+		{
+			{pf::BC1,				&cutout, {16,8,0}, {},		30.0, 0.0},
+			{pf::BC3,				&smooth, {16,8,0}, {24},	30.0, 40.0},
+			{pf::ETC1,			&smooth, {16,8,0}, {},		30.0, 0.0},
+			{pf::ETC2,			&smooth, {16,8,0}, {},		30.0, 0.0},
+			{pf::ETC2_RGBA,	&smooth, {16,8,0}, {24},	30.0, 40.0}
+		};
+
+		for(const auto & test : cases)
+		{
+			gap::image::SourceImage image(w, h, test.p_source->data());
+			const auto name = std::format("{} {}x{}", gap::image::get_pixelformat_name(test.format), w, h);
+
+			double colour_psnr[2] = {};
+			for(const bool b_high_quality : {false, true})
+			{
+				const auto data			= image.create_sub_target_data(0, 0, w, h, test.format, false, gap::image::EncodeOptions{false, gap::image::DITHER_NONE, b_high_quality});
+				const auto decoded	= gap::image::decompress_blocks(data, w, h, test.format);
+				const auto mode			= b_high_quality ? "hq" : "fast";
+
+				++count;
+				if(!check((int(data.size()) == pf::image_data_size(test.format, w, h)) && (decoded.size() == test.p_source->size()), std::format("{} {} size", name, mode), failures))
+					continue;
+
+				colour_psnr[b_high_quality] = psnr(*test.p_source, decoded, test.colour, test.format == pf::BC1);
+				++count;
+				check(colour_psnr[b_high_quality] >= test.min_colour, std::format("{} {} colour psnr {:.1f}dB", name, mode, colour_psnr[b_high_quality]), failures);
+
+				if(!test.alpha.empty())
+				{
+					const double alpha_psnr = psnr(*test.p_source, decoded, test.alpha, false);
+					++count;
+					check(alpha_psnr >= test.min_alpha, std::format("{} {} alpha psnr {:.1f}dB", name, mode, alpha_psnr), failures);
+				}
+
+				if(test.format == pf::BC1)
+				{
+					bool b_match = true;
+					for(std::size_t i=0; i<decoded.size(); ++i)
+						b_match &= ((decoded[i] >> 24) == 0) == (((*test.p_source)[i] >> 24) < 128);
+					++count;
+					check(b_match, std::format("{} {} transparency", name, mode), failures);
+				}
+			}
+
+			++count;
+			check(colour_psnr[1] >= (colour_psnr[0] - 0.05), std::format("{} hq {:.2f}dB >= fast {:.2f}dB", name, colour_psnr[1], colour_psnr[0]), failures);
+		}
+	}
+
+	// ----- Solid blocks should be reproduced almost exactly. -----
+	for(const uint8_t format : {uint8_t(pf::BC1), uint8_t(pf::BC3), uint8_t(pf::ETC2), uint8_t(pf::ETC2_RGBA)})
+	{
+		const std::vector<uint32_t> solid(16, 0xFF336699U);
+		gap::image::SourceImage image(4, 4, solid.data());
+		const auto decoded = gap::image::decompress_blocks(image.create_sub_target_data(0, 0, 4, 4, format, false), 4, 4, format);
+		++count;
+		check((decoded.size() == 16) && (psnr(solid, decoded, {24,16,8,0}, false) >= 36.0), std::format("{} solid", gap::image::get_pixelformat_name(format)), failures);
+	}
+
+	++count;
+	check(gap::image::decompress_blocks(std::vector<uint8_t>(8), 8, 4, pf::BC1).empty(), "block decode too small", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Arbitrary angle rotation. The source is an opaque linear gradient, so the
+//	bilinear sample at any point inside it is known exactly. Each output pixel
+//	centre is mapped back into the source through the returned origin. Inside
+//	the source it must hold the gradient value and well outside it must be
+//	transparent. The cropped size and origin must match the rotated bounds of
+//	the source, grown by the half pixel that the filter reaches past its edge.
+//-----------------------------------------------------------------------------
+static
+int
+test_rotate_arbitrary(int & count)
+{
+	int failures = 0;
+
+	constexpr int W = 48;
+	constexpr int H = 40;
+
+	std::vector<uint32_t> gradient(W * H);
+	for(int y=0; y<H; ++y)
+		for(int x=0; x<W; ++x)
+			gradient[(y * W) + x] = 0xFF000080U | (uint32_t(10 + (2 * x)) << 16) | (uint32_t(5 + (3 * y)) << 8);
+
+	static constexpr struct {float angle; int x_origin; int y_origin;} rotations[] = { {45.0f, W/2, H/2}, {30.0f, 0, 0}, {-30.0f, 10, 7}, {400.0f, W, H} };
+
+	for(const auto & rotation : rotations)
+	{
+		const std::string name = std::format("rotate({}) about {},{}", rotation.angle, rotation.x_origin, rotation.y_origin);
+
+		gap::image::SourceImage image(W, H, gradient.data());
+		int x_origin = rotation.x_origin;
+		int y_origin = rotation.y_origin;
+		image.rotate(rotation.angle, x_origin, y_origin);
+
+		const double a = rotation.angle * (M_PI / 180.0);
+		const double c = std::cos(a);
+		const double s = std::sin(a);
+
+		double min_x = 1e9, max_x = -1e9, min_y = 1e9, max_y = -1e9;
+		for(const auto & [cx, cy] : {std::pair{-0.5, -0.5}, std::pair{W + 0.5, -0.5}, std::pair{-0.5, H + 0.5}, std::pair{W + 0.5, H + 0.5}})
+		{
+			const double dx = cx - rotation.x_origin;
+			const double dy = cy - rotation.y_origin;
+			min_x = std::min(min_x, (dx * c) - (dy * s));		max_x = std::max(max_x, (dx * c) - (dy * s));
+			min_y = std::min(min_y, (dx * s) + (dy * c));		max_y = std::max(max_y, (dx * s) + (dy * c));
+		}
+
+		++count;
+		check(	(std::abs(image.width() - (max_x - min_x)) <= 2.0) && (std::abs(image.height() - (max_y - min_y)) <= 2.0),
+						std::format("{}: size {}x{} expected {:.1f}x{:.1f}", name, image.width(), image.height(), max_x - min_x, max_y - min_y), failures);
+		++count;
+		check(	(std::abs(x_origin + min_x) <= 2.0) && (std::abs(y_origin + min_y) <= 2.0),
+						std::format("{}: origin {},{} expected {:.1f},{:.1f}", name, x_origin, y_origin, -min_x, -min_y), failures);
+
+		int inside = 0, wrong = 0, outside = 0, visible = 0;
+		for(int y=0; y<image.height(); ++y)
+			for(int x=0; x<image.width(); ++x)
+			{
+				// Source position in pixel centre space, where pixel 'i' is centred on 'i'.
+				const double dx = (x - x_origin) + 0.5;
+				const double dy = (y - y_origin) + 0.5;
+				const double u	= (rotation.x_origin - 0.5) + (dx * c) + (dy * s);
+				const double v	= (rotation.y_origin - 0.5) - (dx * s) + (dy * c);
+				const uint32_t colour = image.get_pixel(x, y);
+
+				if((u >= 0.05) && (u <= (W - 1.05)) && (v >= 0.05) && (v <= (H - 1.05)))
+				{
+					++inside;
+					const double red		= 10.0 + (2.0 * u);
+					const double green	= 5.0 + (3.0 * v);
+					if(	((colour >> 24) != 0xFF) || ((colour & 0x0FF) != 0x80) ||
+							(std::abs(double((colour >> 16) & 0x0FF) - red) > 2.0) ||
+							(std::abs(double((colour >> 8) & 0x0FF) - green) > 2.0) )
+						++wrong;
+				}
+				else if((u < -1.05) || (u > (W + 0.05)) || (v < -1.05) || (v > (H + 0.05)))
+				{
+					++outside;
+					visible += (colour >> 24) != 0;
+				}
+			}
+
+		++count;
+		check((inside > (W * H / 2)) && (wrong == 0), std::format("{}: {} of {} sampled pixels wrong", name, wrong, inside), failures);
+		++count;
+		check(visible == 0, std::format("{}: {} of {} pixels outside the source visible", name, visible, outside), failures);
+	}
+
+	// ----- 0 and 360 degrees leave the image and origin unchanged. -----
+	const auto ref = make_reference(33, 21);
+	for(float angle : {0.0f, 360.0f, -360.0f})
+	{
+		gap::image::SourceImage image(ref.width, ref.height, ref.pixels.data());
+		int x_origin = 5, y_origin = 3;
+		image.rotate(angle, x_origin, y_origin);
+
+		++count;
+		if(!compare(std::format("rotate({})", angle), image, ref))
+			++failures;
+		++count;
+		check((x_origin == 5) && (y_origin == 3), std::format("rotate({}) origin {},{}", angle, x_origin, y_origin), failures);
+	}
+
+	// The rotation engine itself must also be exact at a whole turn.
+	const auto turned = gap::image::rotate(gap::image::RotationSource(ref.pixels.data(), ref.width, ref.height), 360.0, 5, 3);
+	gap::image::SourceImage image(turned.width, turned.height, turned.pixels.data());
+	++count;
+	if(!compare("engine rotate(360)", image, ref))
+		++failures;
+	++count;
+	check((turned.x_origin == 5) && (turned.y_origin == 3), std::format("engine rotate(360) origin {},{}", turned.x_origin, turned.y_origin), failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	rotated_copies() must give the same pixels and origins as rotating a copy
+//	of the image by each angle in turn, for right and arbitrary angles alike.
+//-----------------------------------------------------------------------------
+static
+int
+test_rotated_copies(int & count)
+{
+	int failures = 0;
+
+	constexpr int W = 37;
+	constexpr int H = 23;
+
+	std::vector<uint32_t> pixels(W * H);
+	for(int y=0; y<H; ++y)
+		for(int x=0; x<W; ++x)
+			pixels[(y * W) + x] = (uint32_t(((x * 7) + (y * 11)) & 0x0FF) << 24) | (y << 12) | (x << 2);
+
+	static constexpr float angles[] = {0.0f, 30.0f, 90.0f, -45.0f, 180.0f, 200.5f, 270.0f, 360.0f, 725.0f};
+
+	const gap::image::SourceImage source(W, H, pixels.data());
+	const auto copies = source.rotated_copies(angles, 9, 4);
+
+	++count;
+	if(!check(copies.size() == std::size(angles), "rotated_copies: count", failures))
+		return failures;
+
+	for(std::size_t i=0; i<copies.size(); ++i)
+	{
+		gap::image::SourceImage single(W, H, pixels.data());
+		int x_origin = 9, y_origin = 4;
+		single.rotate(angles[i], x_origin, y_origin);
+
+		const auto & copy = *copies[i].p_image;
+		bool b_same = (copy.width() == single.width()) && (copy.height() == single.height());
+		for(int y=0; b_same && (y<single.height()); ++y)
+			for(int x=0; b_same && (x<single.width()); ++x)
+				b_same = copy.get_pixel(x, y) == single.get_pixel(x, y);
+
+		++count;
+		check(b_same, std::format("rotated_copies({}): pixels differ from rotate()", angles[i]), failures);
+		++count;
+		check(	(copies[i].x_origin == x_origin) && (copies[i].y_origin == y_origin),
+						std::format("rotated_copies({}): origin {},{} expected {},{}", angles[i], copies[i].x_origin, copies[i].y_origin, x_origin, y_origin), failures);
+	}
+
+	return failures;
+}
+
+int
+test_image(const gap::Configuration & /*config*/, gap::FileSystem & /*filesystem*/)
+{
+	static constexpr std::pair<int,int> sizes[] = {	{1,1}, {1,7}, {7,1}, {2,2}, {3,5}, {8,8}, {31,33},
+																									{32,32}, {33,31}, {64,17}, {100,101}, {257,64} };
+	int failures = 0;
+	int count		 = 0;
+
+	for(const auto & [w, h] : sizes)
+	{
+		const auto ref = make_reference(w, h);
+
+		auto check = [&](std::string_view name, const std::function<void(gap::image::SourceImage &)> & transform, const ReferenceImage & expected)
+		{
+			gap::image::SourceImage image(w, h, ref.pixels.data());
+			transform(image);
+			++count;
+			if(!compare(name, image, expected))
+				++failures;
+		};
+
+		check("rotate_90", 	[](auto & image) {image.rotate_90();},				remap(ref, h, w, [&](int x, int y) {return std::pair{y, (h-1)-x};}));
+		check("rotate_180", [](auto & image) {image.rotate_180();},				remap(ref, w, h, [&](int x, int y) {return std::pair{(w-1)-x, (h-1)-y};}));
+		check("rotate_270", [](auto & image) {image.rotate_270();},				remap(ref, h, w, [&](int x, int y) {return std::pair{(w-1)-y, x};}));
+		check("hflip", 			[](auto & image) {image.horizontal_flip();},	remap(ref, w, h, [&](int x, int y) {return std::pair{(w-1)-x, y};}));
+		check("vflip", 			[](auto & image) {image.vertical_flip();},		remap(ref, w, h, [&](int x, int y) {return std::pair{x, (h-1)-y};}));
+		check("rotate_90 x4", [](auto & image) {for(int i=0;i<4;++i) image.rotate_90();}, ref);
+
+		// The right angle paths of rotate() must agree with the dedicated functions.
+		check("rotate(90)", [](auto & image) {int ox=0, oy=0; image.rotate(90.0f,ox,oy);},	remap(ref, h, w, [&](int x, int y) {return std::pair{y, (h-1)-x};}));
+		check("rotate(-90)",[](auto & image) {int ox=0, oy=0; image.rotate(-90.0f,ox,oy);},	remap(ref, h, w, [&](int x, int y) {return std::pair{(w-1)-y, x};}));
+	}
+
+	failures += test_opaque_bounds(count);
+	failures += test_encode_options(count);
+	failures += test_rle(count);
+	failures += test_block_compression(count);
+	failures += test_rotate_arbitrary(count);
+	failures += test_rotated_copies(count);
+
+	return report_checks("image", count, failures);
+}
@@ -0,0 +1,20 @@
+//=============================================================================
+//	FILE:					test_image.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_TEST_IMAGE_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_TEST_IMAGE_H
+
+#include "configuration.h"
+#include "filesystem.h"
+
+int	test_image(const gap::Configuration & config, gap::FileSystem & filesystem);
+
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_TEST_IMAGE_H
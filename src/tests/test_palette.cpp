@@ -0,0 +1,387 @@
+//=============================================================================
+//	FILE:					test_palette.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Checks palette generation, indexed encoding, the sharing
+//								of generated colour maps between image groups and the
+//								export of colour maps.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <format>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "test_palette.h"
+#include "tests.h"
+#include "assets.h"
+#include "image.h"
+#include "image_palette.h"
+#include "encode_gbin.h"
+#include "parse_colour_map.h"
+
+static
+int
+channel_error(uint32_t a, uint32_t b)
+{
+	int error = 0;
+	for(int shift=0; shift<32; shift+=8)
+		error = std::max(error, std::abs(int((a >> shift) & 0x0FF) - int((b >> shift) & 0x0FF)));
+	return error;
+}
+
+//-----------------------------------------------------------------------------
+//	A histogram with few colours gives them back exactly, with transparent
+//	first. One with many colours is reduced to the limit.
+//-----------------------------------------------------------------------------
+static
+int
+test_build(int & count)
+{
+	int failures = 0;
+
+	const std::vector<uint32_t> pixels = {	0xFFFF0000U, 0xFFFF0000U, 0xFFFF0000U, 0x00123456U, 0x00000000U,
+																					0xFF00FF00U, 0xFF00FF00U, 0xFF0000FFU, 0x80FFFFFFU };
+	gap::image::ColourHistogram exact;
+	exact.add(pixels);
+
+	count += 4;
+	check(exact.size() == 5, "build: transparent pixels were not counted as one colour", failures);
+	const auto palette = gap::image::build_palette(exact, 256);
+	check(palette.size() == 5, "build: exact palette size", failures);
+	check(!palette.empty() && (palette[0] == 0), "build: transparent is not colour 0", failures);
+	check((palette.size() > 1) && (palette[1] == 0xFFFF0000U), "build: colours are not ordered by use", failures);
+
+	// ----- A smooth gradient of 4096 colours reduced to 16. -----
+	std::vector<uint32_t> gradient;
+	for(int r=0; r<16; ++r)
+		for(int g=0; g<16; ++g)
+			for(int b=0; b<16; ++b)
+				gradient.push_back(0xFF000000U | (r << 20) | (g << 12) | (b << 4));
+
+	gap::image::ColourHistogram histogram;
+	histogram.add(gradient);
+	const gap::image::Palette reduced(gap::image::build_palette(histogram, 16));
+
+	int worst = 0;
+	for(auto colour : gradient)
+		worst = std::max(worst, channel_error(colour, reduced.colours()[reduced.nearest_colour(colour)]));
+
+	count += 2;
+	check(reduced.size() == 16, std::format("build: reduced palette has {} colours", reduced.size()), failures);
+	check(worst <= 64, std::format("build: reduced palette error {} is too large", worst), failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Indexed image data must hold the index of each pixels colour.
+//-----------------------------------------------------------------------------
+static
+int
+test_encode(int & count)
+{
+	static constexpr int WIDTH	= 13;
+	static constexpr int HEIGHT	= 5;
+
+	int failures = 0;
+
+	std::vector<uint32_t> pixels(WIDTH * HEIGHT);
+	for(int i=0; i<WIDTH*HEIGHT; ++i)
+		pixels[i] = (i % 11) == 0 ? 0x00FFFFFFU : 0xFF000000U | ((i % 9) * 0x00102030U);
+
+	gap::image::SourceImage image(WIDTH, HEIGHT, pixels.data());
+	gap::image::ColourHistogram histogram;
+	histogram.add(pixels);
+	const gap::image::Palette palette(gap::image::build_palette(histogram, 16));
+
+	gap::image::EncodeOptions options;
+	options.p_palette = &palette;
+
+	for(const uint8_t pixel_format : {uint8_t(gap::image::pixelformat::I8), uint8_t(gap::image::pixelformat::I4)})
+	{
+		const auto name = gap::image::get_pixelformat_name(pixel_format);
+		const auto data = image.create_sub_target_data(0, 0, WIDTH, HEIGHT, pixel_format, false, options);
+
+		++count;
+		if(!check(std::cmp_equal(data.size(), gap::image::pixelformat::image_data_size(pixel_format, WIDTH, HEIGHT)), std::format("encode: {} data size", name), failures))
+			continue;
+
+		bool b_pass = true;
+		for(int y=0; y<HEIGHT; ++y)
+			for(int x=0; x<WIDTH; ++x)
+			{
+				const int index = pixel_format == gap::image::pixelformat::I8	? data[(y * WIDTH) + x]
+																																			: (data[(y * ((WIDTH + 1) / 2)) + (x / 2)] >> ((x & 1) * 4)) & 0x0F;
+				const uint32_t expected = (pixels[(y * WIDTH) + x] >> 24) == 0 ? 0 : pixels[(y * WIDTH) + x];
+				b_pass = b_pass && (index < palette.size()) && (palette.colours()[index] == expected);
+			}
+
+		++count;
+		check(b_pass, std::format("encode: {} indices do not match the source colours", name), failures);
+	}
+
+	// ----- Without a colour map there is nothing to encode. -----
+	++count;
+	check(image.create_sub_target_data(0, 0, WIDTH, HEIGHT, gap::image::pixelformat::I8, false).empty(), "encode: I8 without a colour map", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Groups cut from the same artwork share a colour map, as long as it still
+//	fits the smallest format using it. A group whose colours had to be
+//	reduced gets its own.
+//-----------------------------------------------------------------------------
+static
+int
+test_share(int & count)
+{
+	static constexpr int SIZE = 8;
+
+	int failures = 0;
+
+	std::vector<uint32_t> pixels(SIZE * SIZE * 3);
+	for(int y=0; y<SIZE; ++y)
+		for(int x=0; x<SIZE*3; ++x)
+		{
+			uint32_t & pixel = pixels[(y * SIZE * 3) + x];
+			if(x < SIZE)					pixel = 0xFF000000U | (x * 0x00100000U);					// 8 colours
+			else if(x < SIZE*2)		pixel = 0xFF000000U | ((x - SIZE) * 0x00200000U);	// 4 of the same colours, 4 new
+			else									pixel = 0xFF000000U | ((x * 16 + y) * 0x0101U);		// 64 colours
+		}
+
+	gap::assets::Assets assets;
+	const int source = assets.add_source_image(std::make_unique<gap::image::SourceImage>(SIZE * 3, SIZE, pixels.data()));
+
+	auto add = [&](int x, uint8_t pixel_format)
+	{
+		gap::image::Image image;
+		image.source_image	= source;
+		image.x							= x * SIZE;
+		image.width					= SIZE;
+		image.height				= SIZE;
+		image.pixel_format	= pixel_format;
+		assets.add_image(image);
+	};
+
+	assets.add_image_group("first");
+	add(0, gap::image::pixelformat::I8);
+	assets.add_image_group("second");
+	add(1, gap::image::pixelformat::I8);
+	assets.add_image_group("third", 0, 32);
+	add(2, gap::image::pixelformat::I8);
+	add(0, gap::image::pixelformat::I4);
+
+	++count;
+	if(!check(assets.build_palettes() == 0, "share: build_palettes failed", failures))
+		return failures;
+
+	std::vector<int> maps;
+	assets.enumerate_images([&](int, int, const gap::image::Image & image) {maps.push_back(image.colour_map); return true;});
+
+	count += 5;
+	if(!check(maps.size() == 4, "share: image count", failures))
+		return failures;
+	check(std::ranges::none_of(maps, [](int map) {return map < 0;}), "share: an image has no colour map", failures);
+	check(maps[0] == maps[1], "share: exact palettes were not shared", failures);
+	check(maps[2] != maps[0], "share: a reduced palette was shared", failures);
+	check(maps[3] == maps[0], "share: an I4 image does not share a palette that fits", failures);
+
+	const auto * p_first	= assets.get_colour_map(maps[0]);
+	const auto * p_third	= assets.get_colour_map(maps[2]);
+	++count;
+	check(	(p_first != nullptr) && (p_first->colourmap.size() == 12) && (p_third != nullptr) && (p_third->colourmap.size() == 32),
+					"share: colour map sizes", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Colour maps loaded from the Zenith sample palette files. Each file format
+//	must give the same colours. Every colour must be found at its own index,
+//	and COLR must store a map only once when other maps are copies of it or
+//	of its first colours. Loading a file again under another spelling of its
+//	path must come from the cache, which keeps the path of the first load.
+//-----------------------------------------------------------------------------
+static constexpr std::size_t	ZENITH_COLOURS	= 47;
+
+static
+uint32_t
+read_u32(const std::vector<uint8_t> & data, std::size_t offset)
+{
+	return data[offset] | (data[offset+1] << 8) | (data[offset+2] << 16) | (uint32_t(data[offset+3]) << 24);
+}
+
+static
+int
+test_zenith(const std::string & directory, gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	auto zenith = load_colour_map(directory + "/zenith.gpl", filesystem);
+
+	++count;
+	if(!check(zenith.colourmap.size() == ZENITH_COLOURS, std::format("zenith: loaded {} colours from {}/zenith.gpl", zenith.colourmap.size(), directory), failures))
+		return failures;
+
+	++count;
+	check((zenith.colourmap.front() == 0xFF18143BU) && (zenith.colourmap.back() == 0xFFFFF4E8U), "zenith: colour values", failures);
+
+	// ----- The same palette in the other supported file formats. -----
+	for(const char * p_name : {"zenith.pal", "zenith.txt", "zenith.hex", "zenith-1x.png"})
+	{
+		const auto cmap = load_colour_map(directory + "/" + p_name, filesystem);
+		++count;
+		check(cmap.colourmap == zenith.colourmap, std::format("zenith: {} does not match zenith.gpl ({} colours)", p_name, cmap.colourmap.size()), failures);
+	}
+
+	const auto reloaded = load_colour_map(directory + "/./zenith.gpl", filesystem);
+	++count;
+	check(	(reloaded.colourmap == zenith.colourmap) && (reloaded.source == zenith.source) && (reloaded.source != (directory + "/./zenith.gpl")),
+					std::format("zenith: reload was not a cache hit (source '{}')", reloaded.source), failures);
+
+	const gap::image::Palette palette(zenith.colourmap);
+	bool b_pass = true;
+	for(int i=0; i<palette.size(); ++i)
+		b_pass = b_pass && (palette.find_colour(palette.colours()[i]) == i) && (palette.nearest_colour(palette.colours()[i]) == i);
+	++count;
+	check(b_pass, "zenith: colours are not found at their own index", failures);
+
+	// ----- Every colour in a column, encoded as I8. -----
+	std::vector<uint32_t> pixels;
+	for(int y=0; y<4; ++y)
+		pixels.insert(pixels.end(), begin(zenith.colourmap), end(zenith.colourmap));
+	gap::image::SourceImage image(ZENITH_COLOURS, 4, pixels.data());
+	gap::image::EncodeOptions options;
+	options.p_palette = &palette;
+	const auto indices = image.create_sub_target_data(0, 0, ZENITH_COLOURS, 4, gap::image::pixelformat::I8, false, options);
+
+	++count;
+	b_pass = indices.size() == pixels.size();
+	for(std::size_t i=0; b_pass && (i<indices.size()); ++i)
+		b_pass = indices[i] == (i % ZENITH_COLOURS);
+	check(b_pass, "zenith: I8 indices", failures);
+
+	// ----- COLR sharing. -----
+	gap::assets::Assets assets;
+	auto add = [&](const std::string & name, std::vector<uint32_t> colours)
+	{
+		gap::assets::ColourMap cmap;
+		cmap.name				= name;
+		cmap.colourmap	= std::move(colours);
+		assets.add_colour_map(cmap);
+	};
+
+	add("prefix", std::vector<uint32_t>(begin(zenith.colourmap), begin(zenith.colourmap) + 16));
+	add("zenith", zenith.colourmap);
+	add("copy", zenith.colourmap);
+	add("reversed", std::vector<uint32_t>(zenith.colourmap.rbegin(), zenith.colourmap.rend()));
+
+	gap::Configuration config;
+	std::vector<uint8_t> data;
+	++count;
+	if(!check(encode_colourmap_chunks(data, assets, config) == 0, "zenith: encode_colourmap_chunks failed", failures))
+		return failures;
+
+	std::size_t colr = 0;
+	std::size_t cmap = 0;
+	for(std::size_t offset = 0; (offset + 8) <= data.size(); offset += 8 + read_u32(data, offset + 4))
+	{
+		if(std::memcmp(&data[offset], "COLR", 4) == 0)	colr = offset + 8;
+		if(std::memcmp(&data[offset], "CMAP", 4) == 0)	cmap = offset + 8;
+	}
+
+	++count;
+	if(!check((colr != 0) && (cmap != 0), "zenith: missing COLR or CMAP chunk", failures))
+		return failures;
+
+	count += 3;
+	check(read_u32(data, colr - 4) == ZENITH_COLOURS * 2 * 4, std::format("zenith: COLR is {} bytes", read_u32(data, colr - 4)), failures);
+	check(read_u32(data, cmap - 4) == 4 * 4, "zenith: CMAP size", failures);
+
+	b_pass = true;
+	int index = 0;
+	assets.enumerate_colourmaps([&](const gap::assets::ColourMap & map)->bool
+		{
+			const std::size_t entry		= cmap + (index++ * 4);
+			const std::size_t size		= data[entry] | (data[entry+1] << 8);
+			const std::size_t offset	= data[entry+2] | (data[entry+3] << 8);
+
+			b_pass = b_pass && (size == map.colourmap.size()) && ((offset + (size * 4)) <= read_u32(data, colr - 4));
+			for(std::size_t i=0; b_pass && (i<size); ++i)
+				b_pass = read_u32(data, colr + offset + (i * 4)) == map.colourmap[i];
+			return true;
+		});
+	check(b_pass, "zenith: CMAP entries do not point at their colours", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	IMAG and TSET entries keep the index of their colour map in a byte. An
+//	indexed image that uses colour map 256 must fail to encode rather than
+//	take the palette of colour map 0.
+//-----------------------------------------------------------------------------
+static
+int
+test_palette_index(int & count)
+{
+	int failures = 0;
+
+	auto encode = [](int colour_map)
+	{
+		gap::assets::Assets assets;
+		for(int i=0; i<=256; ++i)
+		{
+			gap::assets::ColourMap cmap;
+			cmap.name				= std::format("map{}", i);
+			cmap.colourmap	= {0xFF000000U | uint32_t(i)};
+			assets.add_colour_map(cmap);
+		}
+
+		const uint32_t pixels[4] = {0xFF000001U, 0xFF000001U, 0xFF000001U, 0xFF000001U};
+		const int source = assets.add_source_image(std::make_unique<gap::image::SourceImage>(2, 2, pixels));
+
+		assets.add_image_group("indexed");
+		gap::image::Image image;
+		image.source_image	= source;
+		image.width					= 2;
+		image.height				= 2;
+		image.pixel_format	= gap::image::pixelformat::I8;
+		image.colour_map		= colour_map;
+		assets.add_image(image);
+
+		gap::Configuration config;
+		std::vector<uint8_t> data;
+		return gap::encode_packed_image_chunks(data, assets, config);
+	};
+
+	count += 2;
+	check(encode(255) == 0, "palette index: colour map 255 failed to encode", failures);
+	check(encode(256) != 0, "palette index: colour map 256 was truncated to a byte", failures);
+
+	return failures;
+}
+
+int
+test_palette(const gap::Configuration & config, gap::FileSystem & filesystem)
+{
+	const std::string directory = config.args.empty() ? std::string("data/testfiles/palette") : config.args.front();
+
+	int count			= 0;
+	int failures	= test_build(count);
+	failures += test_encode(count);
+	failures += test_share(count);
+	failures += test_zenith(directory, filesystem, count);
+	failures += test_palette_index(count);
+
+	return report_checks("palette", count, failures);
+}
@@ -0,0 +1,303 @@
+//=============================================================================
+//	FILE:					test_sound.cpp
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:	Checks sound sample format conversion, resampling, RAW
+//								and WAV loading and the SWAV and WAVD chunks.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "test_sound.h"
+#include "tests.h"
+#include "assets.h"
+#include "encode_gbin.h"
+#include "sound_sample.h"
+
+static
+uint32_t
+read_u32(const std::vector<uint8_t> & data, std::size_t offset)
+{
+	return data[offset] | (data[offset+1] << 8) | (data[offset+2] << 16) | (uint32_t(data[offset+3]) << 24);
+}
+
+static
+std::vector<float>
+sine(std::size_t count, double frequency, double rate, double amplitude = 0.5)
+{
+	std::vector<float> samples(count);
+	for(std::size_t i=0; i<count; ++i)
+		samples[i] = float(amplitude * std::sin(2.0 * std::numbers::pi * frequency * double(i) / rate));
+	return samples;
+}
+
+//-----------------------------------------------------------------------------
+//	Every value of each format must survive a round trip through float. The
+//	counts are not a multiple of the vector width so both paths are used.
+//-----------------------------------------------------------------------------
+static
+int
+test_formats(int & count)
+{
+	int failures = 0;
+
+	for(uint8_t format : {gap::sound::FORMAT_S8, gap::sound::FORMAT_U8, gap::sound::FORMAT_S16, gap::sound::FORMAT_U16})
+	{
+		const std::size_t			values	= gap::sound::format_size(format) == 1 ? 256 : 65536;
+		std::vector<uint8_t>	data;
+		for(std::size_t i=0; i<values+3; ++i)
+			for(std::size_t b=0; b<gap::sound::format_size(format); ++b)
+				data.push_back(uint8_t((i % values) >> (b * 8)));
+
+		std::vector<float> samples(values + 3);
+		gap::sound::decode_samples(data, format, samples);
+
+		const auto [min, max] = std::minmax_element(begin(samples), end(samples));
+
+		count += 2;
+		check((*min == -1.0f) && (*max < 1.0f), std::format("formats: format {} decodes to {} to {}", format, *min, *max), failures);
+		check(gap::sound::encode_samples(samples, format) == data, std::format("formats: format {} round trip", format), failures);
+	}
+
+	// ----- Zero is the middle of the unsigned formats. -----
+	const std::vector<float> silence(19, 0.0f);
+	count += 2;
+	check(gap::sound::encode_samples(silence, gap::sound::FORMAT_U8) == std::vector<uint8_t>(19, 0x80), "formats: U8 silence", failures);
+	check(read_u32(gap::sound::encode_samples(silence, gap::sound::FORMAT_U16), 32) == 0x80008000U, "formats: U16 silence", failures);
+
+	// ----- Out of range values are clipped, in both paths. -----
+	std::vector<float> loud;
+	for(int i=0; i<5; ++i)
+		loud.insert(loud.end(), {2.0f, -2.0f, 1.0f, NAN});
+
+	const auto s16	= gap::sound::encode_samples(loud, gap::sound::FORMAT_S16);
+	const auto s8		= gap::sound::encode_samples(loud, gap::sound::FORMAT_S8);
+	bool b_pass = true;
+	for(std::size_t i=0; i<loud.size(); i+=4)
+		b_pass = b_pass &&	(read_u32(s16, i * 2) == 0x80007FFFU) && (read_u32(s16, (i * 2) + 4) == 0x80007FFFU) &&
+												(s8[i] == 0x7F) && (s8[i+1] == 0x80) && (s8[i+2] == 0x7F) && (s8[i+3] == 0x80);
+	++count;
+	check(b_pass, "formats: clipping", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Tones below both Nyquist frequencies must come through the resampler
+//	intact, a constant level must stay constant and a tone above the target
+//	Nyquist frequency must be removed. The ends of the output, where the
+//	filter runs off the source, are not checked.
+//-----------------------------------------------------------------------------
+static
+int
+test_resample(int & count)
+{
+	int failures = 0;
+
+	constexpr std::size_t SOURCE_COUNT = 8000;
+
+	for(const auto & [source_rate, target_rate] : {	std::pair{44100U, 22050U},
+																								std::pair{44100U, 48000U},
+																								std::pair{22050U, 44100U},
+																								std::pair{48000U, 8000U},
+																								std::pair{44100U, 8001U} })
+	{
+		const auto				output				= gap::sound::resample(sine(SOURCE_COUNT, 1000.0, source_rate), source_rate, target_rate);
+		const auto				expected			= sine(output.size(), 1000.0, target_rate);
+		const std::size_t	expected_size	= std::size_t((uint64_t(SOURCE_COUNT) * target_rate + source_rate - 1) / source_rate);
+		const std::size_t	margin				= output.size() / 8;
+
+		float error = 0.0f;
+		for(std::size_t i=margin; i<(output.size() - margin); ++i)
+			error = std::max(error, std::abs(output[i] - expected[i]));
+
+		count += 2;
+		check(output.size() == expected_size, std::format("resample: {} to {} gave {} samples, expected {}", source_rate, target_rate, output.size(), expected_size), failures);
+		check(error < 0.005f, std::format("resample: {} to {} has an error of {}", source_rate, target_rate, error), failures);
+
+		const auto	level				= gap::sound::resample(std::vector<float>(SOURCE_COUNT, 0.25f), source_rate, target_rate);
+		float				level_error	= 0.0f;
+		for(std::size_t i=margin; i<(level.size() - margin); ++i)
+			level_error = std::max(level_error, std::abs(level[i] - 0.25f));
+
+		++count;
+		check(level_error < 0.0001f, std::format("resample: {} to {} changes a constant level by {}", source_rate, target_rate, level_error), failures);
+	}
+
+	const auto	alias				= gap::sound::resample(sine(SOURCE_COUNT, 15000.0, 44100.0), 44100, 22050);
+	float				alias_level	= 0.0f;
+	for(std::size_t i=alias.size()/8; i<(alias.size() - (alias.size()/8)); ++i)
+		alias_level = std::max(alias_level, std::abs(alias[i]));
+
+	++count;
+	check(alias_level < 0.005f, std::format("resample: a 15kHz tone is {} after 44100 to 22050", alias_level), failures);
+
+	count += 2;
+	check(gap::sound::resample(std::vector<float>{0.5f, 0.25f}, 22050, 22050) == std::vector<float>{0.5f, 0.25f}, "resample: same rate", failures);
+	check(gap::sound::resample(std::vector<float>{}, 22050, 44100).empty(), "resample: no samples", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	RAW and WAV files written to the temporary directory.
+//-----------------------------------------------------------------------------
+static
+std::vector<uint8_t>
+make_wav(uint16_t tag, uint16_t channels, uint32_t rate, uint16_t bits, const std::vector<uint8_t> & samples)
+{
+	std::vector<uint8_t> file;
+	auto append_u16 = [&](uint32_t value) {file.push_back(uint8_t(value)); file.push_back(uint8_t(value >> 8));};
+	auto append_u32 = [&](uint32_t value) {append_u16(value); append_u16(value >> 16);};
+	auto append_id	= [&](const char * p_id) {file.insert(file.end(), p_id, p_id + 4);};
+
+	append_id("RIFF");
+	append_u32(0);
+	append_id("WAVE");
+
+	// ----- A chunk that is not used, with an odd size. -----
+	append_id("LIST");
+	append_u32(3);
+	file.insert(file.end(), {'a', 'b', 'c', 0});
+
+	append_id("fmt ");
+	append_u32(16);
+	append_u16(tag);
+	append_u16(channels);
+	append_u32(rate);
+	append_u32(rate * channels * (bits / 8));
+	append_u16(channels * (bits / 8));
+	append_u16(bits);
+
+	append_id("data");
+	append_u32(samples.size());
+	file.insert(file.end(), begin(samples), end(samples));
+
+	const uint32_t size = file.size() - 8;
+	std::memcpy(&file[4], &size, 4);
+	return file;
+}
+
+static
+int
+test_load(gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	const auto filename = (std::filesystem::temp_directory_path() / "gap_test_sound.wav").string();
+
+	auto load = [&](const std::vector<uint8_t> & file, std::string_view type, uint8_t raw_format = 0, uint32_t raw_rate = 0)
+	{
+		std::ofstream(filename, std::ios_base::binary | std::ios_base::trunc).write(reinterpret_cast<const char *>(file.data()), file.size());
+		return gap::sound::load(filename, type, raw_format, raw_rate, filesystem);
+	};
+
+	auto matches = [](const std::unique_ptr<gap::sound::SourceSample> & p_sample, uint32_t rate, const std::vector<float> & expected)
+	{
+		if((p_sample == nullptr) || (p_sample->sample_rate != rate) || (p_sample->samples.size() != expected.size()))
+			return false;
+		for(std::size_t i=0; i<expected.size(); ++i)
+			if(std::abs(p_sample->samples[i] - expected[i]) > 0.0001f)
+				return false;
+		return true;
+	};
+
+	// ----- RAW -----
+	const std::vector<uint8_t> raw = {0x00, 0x40, 0x00, 0xC0, 0xFF, 0x7F};
+	count += 3;
+	check(matches(load(raw, "RAW", gap::sound::FORMAT_S16, 11025), 11025, {0.5f, -0.5f, 32767.0f / 32768.0f}), "load: RAW S16", failures);
+	check(matches(load(raw, "raw", gap::sound::FORMAT_U8, 8000), 8000, {-1.0f, -0.5f, -1.0f, 0.5f, 127.0f / 128.0f, -1.0f / 128.0f}), "load: RAW U8", failures);
+	check(load(raw, "RAW", gap::sound::FORMAT_S16, 0) == nullptr, "load: RAW without a rate accepted", failures);
+
+	// ----- WAV -----
+	const std::vector<uint8_t> mono8 = {0x80, 0xC0, 0x40, 0x00};
+	const std::vector<uint8_t> stereo16 = {0x00, 0x40, 0x00, 0x20, 0x00, 0xC0, 0x00, 0xC0};
+	const std::vector<uint8_t> mono24 = {0x00, 0x00, 0x40, 0x00, 0x00, 0xE0};
+	std::vector<uint8_t> float32(8);
+	const float floats[] = {0.75f, -0.125f};
+	std::memcpy(float32.data(), floats, 8);
+
+	count += 7;
+	check(matches(load(make_wav(1, 1, 22050, 8, mono8), "WAV"), 22050, {0.0f, 0.5f, -0.5f, -1.0f}), "load: WAV 8 bit mono", failures);
+	check(matches(load(make_wav(1, 2, 44100, 16, stereo16), "WAV"), 44100, {0.375f, -0.5f}), "load: WAV 16 bit stereo", failures);
+	check(matches(load(make_wav(1, 1, 48000, 24, mono24), "AUTO"), 48000, {0.5f, -0.25f}), "load: WAV 24 bit mono by AUTO", failures);
+	check(matches(load(make_wav(3, 1, 32000, 32, float32), ""), 32000, {0.75f, -0.125f}), "load: WAV 32 bit float", failures);
+	check(load(make_wav(2, 1, 22050, 4, mono8), "WAV") == nullptr, "load: ADPCM WAV accepted", failures);
+	check(load(raw, "WAV") == nullptr, "load: RAW data accepted as WAV", failures);
+	check(load(raw, "MP3") == nullptr, "load: unsupported type accepted", failures);
+
+	std::filesystem::remove(filename);
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	SWAV has an entry for each sample, pointing at its samples in WAVD. Each
+//	sample starts on a 4 byte boundary.
+//-----------------------------------------------------------------------------
+static
+int
+test_chunks(int & count)
+{
+	int failures = 0;
+
+	gap::assets::Assets assets;
+	assets.add_sound_sample(std::make_unique<gap::sound::SoundSample>("beep", 22050, gap::sound::FORMAT_S8, gap::sound::COMPRESSION_NONE, std::vector<uint8_t>{1, 2, 3, 4, 5}));
+	assets.add_sound_sample(std::make_unique<gap::sound::SoundSample>("boop", 11025, gap::sound::FORMAT_S16, gap::sound::COMPRESSION_NONE, std::vector<uint8_t>{0x34, 0x12, 0x78, 0x56}));
+
+	gap::Configuration config;
+	std::vector<uint8_t> data;
+	++count;
+	if(!check(encode_sound_sample_chunks(data, assets, config) == 0, "chunks: encode_sound_sample_chunks failed", failures))
+		return failures;
+
+	std::size_t swav = 0;
+	std::size_t wavd = 0;
+	for(std::size_t offset = 0; (offset + 8) <= data.size(); offset += 8 + read_u32(data, offset + 4))
+	{
+		if(std::memcmp(&data[offset], "SWAV", 4) == 0)	swav = offset + 8;
+		if(std::memcmp(&data[offset], "WAVD", 4) == 0)	wavd = offset + 8;
+	}
+
+	++count;
+	if(!check((swav != 0) && (wavd != 0), "chunks: missing SWAV or WAVD chunk", failures))
+		return failures;
+
+	count += 4;
+	check((read_u32(data, swav - 4) == 24) && (read_u32(data, wavd - 4) == 12), "chunks: chunk sizes", failures);
+	check((read_u32(data, swav) == (22050 | (uint32_t(gap::sound::FORMAT_S8) << 16))) && (read_u32(data, swav + 4) == 5) && (read_u32(data, swav + 8) == 0), "chunks: first entry", failures);
+	check((read_u32(data, swav + 12) == (11025 | (uint32_t(gap::sound::FORMAT_S16) << 16))) && (read_u32(data, swav + 16) == 2) && (read_u32(data, swav + 20) == 8), "chunks: second entry", failures);
+	check((read_u32(data, wavd) == 0x04030201U) && (read_u32(data, wavd + 8) == 0x56781234U), "chunks: sample data", failures);
+
+	config.b_big_endian = true;
+	data.clear();
+	encode_sound_sample_chunks(data, assets, config);
+	++count;
+	check((data.size() == 52) && (data[48] == 0x12) && (data[49] == 0x34), "chunks: big endian 16 bit samples", failures);
+
+	return failures;
+}
+
+int
+test_sound(const gap::Configuration & config, gap::FileSystem & filesystem)
+{
+	(void)config;
+
+	int count			= 0;
+	int failures	= test_formats(count);
+	failures += test_resample(count);
+	failures += test_load(filesystem, count);
+	failures += test_chunks(count);
+
+	return report_checks("sound", count, failures);
+}
@@ -0,0 +1,20 @@
+//=============================================================================
+//	FILE:					test_sound.h
+//	SYSTEM:				Game Asset Packer
+//	DESCRIPTION:
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C)Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:
+//	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade&arcadestuff.com>
+//=============================================================================
+#ifndef GUARD_ADE_GAMES_ASSET_PACKER_TEST_SOUND_H
+#define GUARD_ADE_GAMES_ASSET_PACKER_TEST_SOUND_H
+
+#include "configuration.h"
+#include "filesystem.h"
+
+int	test_sound(const gap::Configuration & config, gap::FileSystem & filesystem);
+
+
+#endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_TEST_SOUND_H
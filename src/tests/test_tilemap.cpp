@@ -8,18 +8,636 @@
 //	MAINTAINER:		AJP - Adrian Purser <ade&arcadestuff.com>
 //	CREATED:			13-MAR-2025 Adrian Purser <ade&arcadestuff.com>
 //=============================================================================
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "test_tilemap.h"
+#include "tests.h"
 #include "source_tilemap.h"
+#include "tilemap.h"
+#include "decompress.h"
+#include "utility/base64.h"
 
-int	
-test_tilemap(const gap::Configuration & config, gap::FileSystem & filesystem)
+//-----------------------------------------------------------------------------
+//	Every length from 0 to 100 bytes is encoded and decoded again, with and
+//	without line breaks, so that both the block decoder and the tail are used.
+//-----------------------------------------------------------------------------
+static
+int
+test_base64(int & count)
+{
+	int failures = 0;
+
+	count += 2;
+	check(ade::base64::encode(std::vector<uint8_t>{'M','a','n','y'}) == "TWFueQ==", "base64: encode", failures);
+	{
+		std::vector<uint8_t> out(8);
+		const auto size = ade::base64::decode(" TW\r\nFu eQ", out);
+		check(size && (*size == 4) && (std::string_view(reinterpret_cast<const char *>(out.data()), 4) == "Many"), "base64: unpadded text with whitespace", failures);
+	}
+
+	for(std::size_t length = 0; length <= 100; ++length)
+	{
+		std::vector<uint8_t> data(length);
+		for(std::size_t i=0; i<length; ++i)
+			data[i] = uint8_t((i * 167) + length);
+
+		auto text = ade::base64::encode(data);
+
+		std::string wrapped("\n   ");
+		for(std::size_t i=0; i<text.size(); i+=20)
+			wrapped += text.substr(i, 20) + "\n   ";
+
+		for(const auto & input : {text, wrapped})
+		{
+			std::vector<uint8_t> out(ade::base64::decoded_size_limit(input) + 16, 0xAA);
+			const auto size = ade::base64::decode(input, out);
+
+			++count;
+			check(size && (*size == length) && std::equal(begin(data), end(data), begin(out)), std::format("base64: round trip of {} bytes", length), failures);
+		}
+
+		if(length > 0)
+		{
+			std::vector<uint8_t> small(length - 1);
+			++count;
+			check(!ade::base64::decode(text, small), std::format("base64: {} bytes decoded into a smaller buffer", length), failures);
+		}
+	}
+
+	count += 3;
+	std::vector<uint8_t> out(64);
+	check(!ade::base64::decode("QUJDREVGR0hJSktMTU5PUF!=", out), "base64: invalid character accepted", failures);
+	check(!ade::base64::decode("QUJD\xC3\xA9VGR0hJSktMTU5PUFFS", out), "base64: non ASCII character accepted", failures);
+	check(!ade::base64::decode("QQ==QQ==", out), "base64: data after padding accepted", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	The same map saved by Tiled with each layer data encoding must load to
+//	the same tiles as the CSV version.
+//-----------------------------------------------------------------------------
+static
+int
+test_encodings(const std::string & directory, gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	auto tiles = [](const gap::tilemap::SourceTileMap & tilemap)
+	{
+		std::vector<std::vector<uint64_t>> layers;
+		tilemap.enumerate_layers([&](const gap::tilemap::SourceTileMapLayer & layer) {layers.push_back(layer.m_data); return true;});
+		return layers;
+	};
+
+	auto p_csv = gap::tilemap::load(directory + "/tilemap.tmx", "tiled:tmx", filesystem);
+
+	++count;
+	if(!check((p_csv != nullptr) && (p_csv->width() == 20) && (tiles(*p_csv).size() == 1), std::format("tmx: failed to load {}/tilemap.tmx", directory), failures))
+		return failures;
+
+	const auto expected = tiles(*p_csv);
+
+	for(const auto & [p_name, method] : {	std::pair{"base64", gap::compression::NONE},
+																				std::pair{"zlib", gap::compression::ZLIB},
+																				std::pair{"gzip", gap::compression::GZIP},
+																				std::pair{"zstd", gap::compression::ZSTD} })
+	{
+		auto p_tilemap = gap::tilemap::load(std::format("{}/tilemap_{}.tmx", directory, p_name), "tiled:tmx", filesystem);
+
+		++count;
+		if(gap::compression::is_supported(method))
+			check((p_tilemap != nullptr) && (tiles(*p_tilemap) == expected), std::format("tmx: {} layer differs from csv", p_name), failures);
+		else
+			check(p_tilemap == nullptr, std::format("tmx: {} is not supported but loaded", p_name), failures);
+	}
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	CSV layer data with a 3x2 layer.
+//-----------------------------------------------------------------------------
+static
+int
+test_csv(gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	const auto filename = (std::filesystem::temp_directory_path() / "gap_test_csv.tmx").string();
+
+	auto load = [&](std::string_view csv)
+	{
+		std::ofstream(filename, std::ios_base::binary | std::ios_base::trunc)
+			<< "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			<< "<map orientation=\"orthogonal\" renderorder=\"right-down\" width=\"3\" height=\"2\" tilewidth=\"8\" tileheight=\"8\" infinite=\"0\">\n"
+			<< " <tileset firstgid=\"1\" source=\"tiles.tsx\"/>\n"
+			<< " <layer id=\"1\" name=\"csv\" width=\"3\" height=\"2\">\n"
+			<< "  <data encoding=\"csv\">" << csv << "</data>\n"
+			<< " </layer>\n</map>\n";
+
+		std::vector<uint64_t> tiles;
+		if(auto p_tilemap = gap::tilemap::load(filename, "tiled:tmx", filesystem))
+			p_tilemap->enumerate_layers([&](const gap::tilemap::SourceTileMapLayer & layer) {tiles = layer.m_data; return true;});
+		return tiles;
+	};
+
+	const std::vector<uint64_t> expected = {0, 1, 2, 3, 4, 9};
+
+	count += 8;
+	check(load("\n1,2,3,\n4,5,10\n") == expected, "csv: line breaks", failures);
+	check(load("\r\n1, 2 ,3,\r\n\t4,5,10,\r\n") == expected, "csv: CR LF, spaces and a trailing comma", failures);
+	check(load("1,2,3,4,5,10") == expected, "csv: single line", failures);
+	check(load("1,2,3,4,5").empty(), "csv: too few values accepted", failures);
+	check(load("1,2,3,4,5,10,11").empty(), "csv: too many values accepted", failures);
+	check(load("1,2,x,4,5,10").empty(), "csv: invalid value accepted", failures);
+	check(load("1,2,,4,5,10").empty(), "csv: empty value accepted", failures);
+	check(load("1,2 3,4,5,10").empty(), "csv: missing comma accepted", failures);
+
+	std::filesystem::remove(filename);
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	A layer that is much larger than a single read of the file, so that CSV
+//	values and base64 groups are split between reads. The size makes the
+//	base64 data end with padding.
+//-----------------------------------------------------------------------------
+static
+int
+test_streaming(gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	constexpr uint32_t WIDTH	= 509;
+	constexpr uint32_t HEIGHT	= 301;
+
+	std::vector<uint64_t>	expected(WIDTH * HEIGHT);
+	std::vector<uint8_t>	ids;
+	std::string						csv;
+
+	for(std::size_t i=0; i<expected.size(); ++i)
+	{
+		const uint32_t id = (i % 7) == 0 ? 0 : uint32_t((i * 37) % 70000) + 1;
+		expected[i] = id == 0 ? 0 : id - 1;
+		csv += std::format("{},{}", id, (i % WIDTH) == (WIDTH - 1) ? "\n" : "");
+		for(int shift=0; shift<32; shift+=8)
+			ids.push_back(uint8_t(id >> shift));
+	}
+
+	std::string base64 = ade::base64::encode(ids);
+	for(std::size_t i=76; i<base64.size(); i+=78)
+		base64.insert(i, "\r\n");
+
+	const auto filename = (std::filesystem::temp_directory_path() / "gap_test_streaming.tmx").string();
+
+	auto load = [&](std::string_view encoding, std::string_view data)
+	{
+		std::ofstream(filename, std::ios_base::binary | std::ios_base::trunc)
+			<< "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			<< std::format("<map orientation=\"orthogonal\" renderorder=\"right-down\" width=\"{0}\" height=\"{1}\" tilewidth=\"8\" tileheight=\"8\" infinite=\"0\">\n", WIDTH, HEIGHT)
+			<< " <tileset firstgid=\"1\" source=\"tiles.tsx\"/>\n"
+			<< std::format(" <layer id=\"1\" name=\"big\" width=\"{}\" height=\"{}\">\n", WIDTH, HEIGHT)
+			<< "  <data encoding=\"" << encoding << "\">\n" << data << "\n  </data>\n"
+			<< " </layer>\n</map>\n";
+
+		std::vector<uint64_t> tiles;
+		if(auto p_tilemap = gap::tilemap::load(filename, "tiled:tmx", filesystem))
+			p_tilemap->enumerate_layers([&](const gap::tilemap::SourceTileMapLayer & layer) {tiles = layer.m_data; return true;});
+		return tiles;
+	};
+
+	count += 4;
+	check(load("csv", csv) == expected, "streaming: csv layer differs", failures);
+	check(load("base64", base64) == expected, "streaming: base64 layer differs", failures);
+	check(load("csv", csv + "1").empty(), "streaming: csv with an extra value accepted", failures);
+	check(load("base64", base64 + "QQ==").empty(), "streaming: base64 data after the padding accepted", failures);
+
+	std::filesystem::remove(filename);
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	tilemap_infinite.tmx is the sample map drawn at -8,-4 in an infinite map,
+//	as 16x16 chunks, with one more tile far away at 1605,1610 and an empty
+//	chunk. The chunks cover -16,-16 to 1616,1616.
+//-----------------------------------------------------------------------------
+static
+int
+test_infinite(const std::string & directory, gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	auto p_csv			= gap::tilemap::load(directory + "/tilemap.tmx", "tiled:tmx", filesystem);
+	auto p_infinite	= gap::tilemap::load(directory + "/tilemap_infinite.tmx", "tiled:tmx", filesystem);
+
+	++count;
+	if(!check((p_csv != nullptr) && (p_infinite != nullptr), "infinite: failed to load", failures))
+		return failures;
+
+	const auto & csv			= *p_csv->get_layer(1);
+	const auto & layer		= *p_infinite->get_layer(1);
+
+	count += 4;
+	check(p_infinite->infinite() && (p_infinite->origin_x() == -16) && (p_infinite->origin_y() == -16), "infinite: origin", failures);
+	check((p_infinite->width() == 1632) && (layer.m_width == 1632) && (layer.m_height == 1632), "infinite: size", failures);
+	check(layer.m_data.empty() && (layer.m_chunks.size() == 5), "infinite: empty chunk kept or layer made dense", failures);
+	check(layer.largest_tile() == 3, "infinite: largest tile", failures);
+
+	bool b_same = (layer.get_tile(1605 + 16, 1610 + 16) == 2) && (layer.get_tile(1604 + 16, 1610 + 16) == 0);
+	for(uint32_t y=0; y<csv.m_height; ++y)
+		for(uint32_t x=0; x<csv.m_width; ++x)
+			b_same &= layer.get_tile(x + 8, y + 12) == csv.get_tile(x, y);
+
+	++count;
+	check(b_same, "infinite: tiles differ from the csv map", failures);
+
+	// ----- Only the blocks under the chunks are allocated. -----
+	gap::tilemap::TileMap tilemap(1, "infinite", layer.m_width, layer.m_height, 16, 1);
+	layer.enumerate_rects(0, 0, layer.m_width, layer.m_height, [&](uint32_t x, uint32_t y, uint32_t width, uint32_t height, std::span<const uint64_t> tiles, std::size_t stride)
+		{
+			tilemap.assign_rect(tiles, stride, x, y, width, height);
+		});
+
+	count += 3;
+	check((tilemap.active_block_count() == 5) && (tilemap.block_data().size() == (5 * 16 * 16)), std::format("infinite: {} blocks allocated", tilemap.active_block_count()), failures);
+	check((tilemap.get(1605 + 16, 1610 + 16) == 2) && (tilemap.get(8 + 2, 12 + 3) == csv.get_tile(2, 3)), "infinite: tilemap tiles", failures);
+
+	uint32_t rows = 0;
+	layer.enumerate_rects(20, 24, 10, 10, [&](uint32_t x, uint32_t y, uint32_t width, uint32_t height, std::span<const uint64_t> /*tiles*/, std::size_t /*stride*/)
+		{
+			if((x == 0) && ((y + height) <= 8) && (width == 10))
+				rows += height;
+		});
+	check(rows == 8, "infinite: rects clipped to a region", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	A 3 layer 16x8 map with 4x4 blocks. Layer 0 is the same as layer 2 and
+//	layer 1 only has tiles in its first block, which is also the same as a
+//	block of layer 0.
+//-----------------------------------------------------------------------------
+static
+int
+test_layers(int & count)
+{
+	int failures = 0;
+
+	gap::tilemap::TileMap tilemap(1, "layers", 16, 8, 4, 1, 3);
+
+	auto tile = [](uint32_t x, uint32_t y) -> uint64_t {return ((x / 4) % 2) + ((y / 4) * 2) + 1;};
+
+	for(uint32_t y=0; y<8; ++y)
+		for(uint32_t x=0; x<16; ++x)
+		{
+			tilemap.set(x, y, tile(x, y), 0);
+			tilemap.set(x, y, tile(x, y), 2);
+			if((x < 4) && (y < 4))
+				tilemap.set(x, y, tile(x, y), 1);
+		}
+
+	count += 4;
+	check((tilemap.layer_count() == 3) && (tilemap.indices().size() == (4 * 2 * 3)), "layers: index count", failures);
+	check(tilemap.active_block_count() == 17, std::format("layers: {} blocks allocated", tilemap.active_block_count()), failures);
+	check(tilemap.deduplicate_blocks() == 13, "layers: duplicate blocks removed", failures);
+	check(tilemap.active_block_count() == 4, std::format("layers: {} blocks after removing duplicates", tilemap.active_block_count()), failures);
+
+	// ----- The indices of a block are together and the blocks are numbered in index order. -----
+	const auto indices = tilemap.indices();
+	const std::vector<uint16_t> expected = {	0, 0, 0,		1, gap::tilemap::INDEX_EMPTY, 1,		0, gap::tilemap::INDEX_EMPTY, 0,		1, gap::tilemap::INDEX_EMPTY, 1,
+																						2, gap::tilemap::INDEX_EMPTY, 2,		3, gap::tilemap::INDEX_EMPTY, 3,		2, gap::tilemap::INDEX_EMPTY, 2,		3, gap::tilemap::INDEX_EMPTY, 3 };
+	++count;
+	check(std::equal(begin(indices), end(indices), begin(expected), end(expected)), "layers: indices", failures);
+
+	bool b_same = true;
+	for(uint32_t y=0; y<8; ++y)
+		for(uint32_t x=0; x<16; ++x)
+			b_same &= 	(tilemap.get(x, y, 0) == tile(x, y)) && (tilemap.get(x, y, 2) == tile(x, y)) &&
+									(tilemap.get(x, y, 1) == (((x < 4) && (y < 4)) ? tile(x, y) : 0));
+
+	++count;
+	check(b_same, "layers: tiles differ after removing duplicates", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Rectangles that start and end part way through blocks are copied with
+//	assign_rect() and with set(). The tiles must match and the blocks that
+//	only have zeros copied into them must stay empty.
+//-----------------------------------------------------------------------------
+static
+int
+test_assign_rect(int & count)
+{
+	int failures = 0;
+
+	const uint32_t width	= 37;
+	const uint32_t height	= 29;
+	std::vector<uint64_t> tiles(std::size_t(width) * height, 0);
+	for(uint32_t y=0; y<height; ++y)
+		for(uint32_t x=0; x<width; ++x)
+			if((x >= 16) || (y >= 8))
+				tiles[(y * width) + x] = ((x * 7) + (y * 3)) % 11;
+
+	for(const uint32_t blocksize : {8U, 12U})
+	for(const auto & [x, y, w, h] : {	std::array<uint32_t,4>{0, 0, width, height},
+																		std::array<uint32_t,4>{3, 5, 30, 20},
+																		std::array<uint32_t,4>{9, 1, 1, 27},
+																		std::array<uint32_t,4>{0, 0, 16, 8} })
+	{
+		gap::tilemap::TileMap rect(1, "rect", 40, 40, blocksize, 1);
+		gap::tilemap::TileMap cell(1, "cell", 40, 40, blocksize, 1);
+
+		rect.assign_rect(std::span<const uint64_t>(tiles).subspan((y * width) + x), width, x + 1, y + 2, w, h);
+
+		for(uint32_t iy=0; iy<h; ++iy)
+			for(uint32_t ix=0; ix<w; ++ix)
+				if(auto tile = tiles[((y + iy) * width) + x + ix]; tile != 0)
+					cell.set(x + 1 + ix, y + 2 + iy, tile);
+
+		bool b_same = true;
+		for(uint32_t iy=0; iy<40; ++iy)
+			for(uint32_t ix=0; ix<40; ++ix)
+				b_same &= rect.get(ix, iy) == cell.get(ix, iy);
+
+		count += 2;
+		check(b_same, std::format("assign_rect: {}x{} at {},{} with {}x{} blocks differs from set()", w, h, x, y, blocksize, blocksize), failures);
+		check(std::ranges::equal(rect.indices(), cell.indices(), [](uint16_t a, uint16_t b) {return (a == gap::tilemap::INDEX_EMPTY) == (b == gap::tilemap::INDEX_EMPTY);}), std::format("assign_rect: {}x{} at {},{} with {}x{} blocks allocated different blocks", w, h, x, y, blocksize, blocksize), failures);
+	}
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Every tile of a 50x30 map is different. Each tile must be read back and
+//	be stored at its place in its block, whether or not the block size is a
+//	power of 2.
+//-----------------------------------------------------------------------------
+static
+int
+test_block_sizes(int & count)
+{
+	int failures = 0;
+
+	const uint32_t width	= 50;
+	const uint32_t height	= 30;
+	auto tile = [&](uint32_t x, uint32_t y) -> uint64_t {return (y * width) + x + 1;};
+
+	for(const uint32_t blocksize : {1U, 3U, 12U, 16U, 24U, 64U})
+	{
+		gap::tilemap::TileMap tilemap(1, "blocks", width, height, blocksize, 2);
+		for(uint32_t y=0; y<height; ++y)
+			for(uint32_t x=0; x<width; ++x)
+				tilemap.set(x, y, tile(x, y));
+
+		bool b_get = true;
+		for(uint32_t y=0; y<height; ++y)
+			for(uint32_t x=0; x<width; ++x)
+				b_get &= tilemap.get(x, y) == tile(x, y);
+
+		const auto indices	= tilemap.indices();
+		const auto data			= tilemap.block_data();
+		bool b_stored = (indices.size() == (tilemap.blocks_wide() * tilemap.blocks_high())) && (data.size() == (indices.size() * blocksize * blocksize));
+		for(uint32_t by=0; b_stored && (by<tilemap.blocks_high()); ++by)
+			for(uint32_t bx=0; bx<tilemap.blocks_wide(); ++bx)
+				for(uint32_t ty=0; ty<blocksize; ++ty)
+					for(uint32_t tx=0; tx<blocksize; ++tx)
+					{
+						const uint32_t x = (bx * blocksize) + tx;
+						const uint32_t y = (by * blocksize) + ty;
+						b_stored &= data[(std::size_t(indices[(by * tilemap.blocks_wide()) + bx]) * blocksize * blocksize) + (ty * blocksize) + tx] == (((x < width) && (y < height)) ? tile(x, y) : 0);
+					}
+
+		count += 2;
+		check(b_get, std::format("blocks: tiles differ with {}x{} blocks", blocksize, blocksize), failures);
+		check(b_stored, std::format("blocks: tiles stored in the wrong place with {}x{} blocks", blocksize, blocksize), failures);
+	}
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	Each layout must visit every position of a grid once. Consecutive
+//	positions along a Hilbert curve are always next to each other.
+//-----------------------------------------------------------------------------
+static
+int
+test_layout(int & count)
+{
+	int failures = 0;
+
+	using gap::tilemap::layout_order;
+
+	count += 2;
+	check(layout_order(gap::tilemap::LAYOUT_MORTON, 4, 4) == std::vector<uint32_t>{0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15}, "layout: morton 4x4", failures);
+	check(layout_order(gap::tilemap::LAYOUT_HILBERT, 2, 2) == std::vector<uint32_t>{0, 2, 3, 1}, "layout: hilbert 2x2", failures);
+
+	for(const auto layout : {gap::tilemap::LAYOUT_ROW_MAJOR, gap::tilemap::LAYOUT_MORTON, gap::tilemap::LAYOUT_HILBERT})
+	{
+		for(const auto & [width, height] : {std::pair{16U, 16U}, std::pair{12U, 5U}, std::pair{1U, 7U}, std::pair{33U, 64U}})
+		{
+			auto order = layout_order(layout, width, height);
+			bool b_adjacent = true;
+			for(std::size_t i=1; i<order.size(); ++i)
+			{
+				const int dx = int(order[i] % width) - int(order[i-1] % width);
+				const int dy = int(order[i] / width) - int(order[i-1] / width);
+				b_adjacent &= (std::abs(dx) + std::abs(dy)) == 1;
+			}
+
+			std::ranges::sort(order);
+			std::vector<uint32_t> expected(std::size_t(width) * height);
+			std::iota(begin(expected), end(expected), 0U);
+
+			++count;
+			check(order == expected, std::format("layout: {} {}x{} is not a permutation", int(layout), width, height), failures);
+
+			if((layout == gap::tilemap::LAYOUT_HILBERT) && (width == height))
+			{
+				++count;
+				check(b_adjacent, std::format("layout: hilbert {}x{} jumps", width, height), failures);
+			}
+		}
+	}
+
+	// ----- Blocks are numbered along the curve. -----
+	gap::tilemap::TileMap tilemap(1, "layout", 16, 16, 4, 1);
+	tilemap.set_layout(gap::tilemap::LAYOUT_MORTON);
+	for(uint32_t y=0; y<16; ++y)
+		for(uint32_t x=0; x<16; ++x)
+			tilemap.set(x, y, ((y / 4) * 4) + (x / 4) + 1);
+	tilemap.deduplicate_blocks();
+
+	const auto indices = tilemap.indices();
+	const auto order = layout_order(gap::tilemap::LAYOUT_MORTON, 4, 4);
+	bool b_numbered = true;
+	for(std::size_t i=0; i<order.size(); ++i)
+		b_numbered &= indices[order[i]] == i;
+
+	++count;
+	check(b_numbered && (tilemap.get(13, 2) == 4), "layout: blocks are not numbered in morton order", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	tilemap_flags.tmx uses tileset_flags.tsx, where tile 1 is solid, tile 2 is
+//	a ladder by its class and tile 3 is a hazard that is not solid.
+//-----------------------------------------------------------------------------
+static
+int
+test_flags(const std::string & directory, gap::FileSystem & filesystem, int & count)
+{
+	int failures = 0;
+
+	auto p_source = gap::tilemap::load(directory + "/tilemap_flags.tmx", "tiled:tmx", filesystem);
+
+	++count;
+	if(!check((p_source != nullptr) && (p_source->get_layer(1) != nullptr), "flags: failed to load tilemap_flags.tmx", failures))
+		return failures;
+
+	const auto & tileset = p_source->get_tileset();
+	const std::vector<std::string> names = {"solid", "ladder", "hazard"};
+
+	const auto flags = tileset.tile_flags(names, 3);
+
+	++count;
+	check(flags == std::vector<uint32_t>{0, 1, 2, 4}, std::format("flags: tile flags {},{},{},{}", flags[0], flags[1], flags[2], flags[3]), failures);
+
+	// ----- Block summaries, with 2x2 blocks. -----
+	const auto & layer = *p_source->get_layer(1);
+	gap::tilemap::TileMap tilemap(1, "flags", layer.m_width, layer.m_height, 2, 1);
+	tilemap.assign_rect(layer.m_data, layer.m_width, 0, 0, layer.m_width, layer.m_height);
+	tilemap.set_tile_flags(names, flags);
+
+	const auto blocks		= tilemap.block_flags();
+	const auto indices	= tilemap.indices();
+	auto summary = [&](uint32_t bx, uint32_t by) {return blocks.at(indices[(by * tilemap.blocks_wide()) + bx]);};
+
+	count += 4;
+	check((summary(0, 0).all == 1) && (summary(0, 0).any == 1), "flags: solid block", failures);
+	check((summary(1, 0).all == 0) && (summary(1, 0).any == 2), "flags: ladder block", failures);
+	check((summary(3, 0).all == 0) && (summary(3, 0).any == 5), "flags: hazard and solid block", failures);
+	check((indices[(1 * tilemap.blocks_wide()) + 3] == gap::tilemap::INDEX_EMPTY) && (tilemap.flag_size() == 1), "flags: empty block or flag size", failures);
+
+	// ----- A tileset embedded in the map. -----
+	// Tile 0 is solid, but tile 0 is stored as 0, the same as the empty cell
+	// and the padding at the right edge. No block may report it as solid.
+	const auto filename = (std::filesystem::temp_directory_path() / "gap_test_flags.tmx").string();
+	std::ofstream(filename, std::ios_base::binary | std::ios_base::trunc)
+		<< "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		<< "<map orientation=\"orthogonal\" renderorder=\"right-down\" width=\"3\" height=\"2\" tilewidth=\"8\" tileheight=\"8\" infinite=\"0\">\n"
+		<< " <tileset firstgid=\"1\" name=\"embedded\" tilewidth=\"8\" tileheight=\"8\" tilecount=\"2\" columns=\"2\">\n"
+		<< "  <tile id=\"0\"><properties><property name=\"Solid\" value=\"yes\"/><property name=\"hazard\" value=\"false\"/></properties></tile>\n"
+		<< "  <tile id=\"1\" class=\"hazard\"/>\n"
+		<< " </tileset>\n"
+		<< " <layer id=\"1\" name=\"l\" width=\"3\" height=\"2\"><data encoding=\"csv\">1,2,2,0,2,2</data></layer>\n</map>\n";
+
+	auto p_embedded = gap::tilemap::load(filename, "tiled:tmx", filesystem);
+	std::filesystem::remove(filename);
+
+	++count;
+	if(!check(	(p_embedded != nullptr) && p_embedded->get_tileset().tile_flag(0, "solid") && !p_embedded->get_tileset().tile_flag(0, "hazard") &&
+							p_embedded->get_tileset().tile_flag(1, "HAZARD") && !p_embedded->get_tileset().tile_flag(1, "solid"), "flags: embedded tileset", failures))
+		return failures;
+
+	const std::vector<std::string> embedded_names = {"solid", "hazard"};
+	const auto & embedded_layer	= *p_embedded->get_layer(1);
+	const auto embedded_flags		= p_embedded->get_tileset().tile_flags(embedded_names, embedded_layer.largest_tile());
+
+	gap::tilemap::TileMap embedded(1, "embedded", embedded_layer.m_width, embedded_layer.m_height, 2, 1);
+	embedded.assign_rect(embedded_layer.m_data, embedded_layer.m_width, 0, 0, embedded_layer.m_width, embedded_layer.m_height);
+	embedded.set_tile_flags(embedded_names, embedded_flags);
+
+	const auto embedded_blocks	= embedded.block_flags();
+	const auto embedded_indices	= embedded.indices();
+
+	count += 3;
+	check(embedded_flags == std::vector<uint32_t>{0, 2}, std::format("flags: tile 0 has flags {}", embedded_flags.empty() ? 0 : embedded_flags[0]), failures);
+	check(	(embedded_blocks.size() == 2) && (embedded_blocks[embedded_indices[0]].all == 0) && (embedded_blocks[embedded_indices[0]].any == 2),
+					"flags: tile 0 and the empty cell are solid in the block summary", failures);
+	check(	(embedded_blocks.size() == 2) && (embedded_blocks[embedded_indices[1]].all == 0) && (embedded_blocks[embedded_indices[1]].any == 2),
+					"flags: the padding is solid in the block summary", failures);
+
+	return failures;
+}
+
+//-----------------------------------------------------------------------------
+//	A 300x300 map with 1x1 blocks has more blocks than a block number can
+//	refer to. Setting a tile in every block, with set() or with assign_rect()
+//	as TILEMAP does, must fail once the blocks run out instead of dropping
+//	the tiles.
+//-----------------------------------------------------------------------------
+static
+int
+test_block_limit(int & count)
 {
-	if(config.args.size() < 2)
-		return -1;
+	int failures = 0;
+
+	constexpr uint32_t SIZE = 300;
+
+	gap::tilemap::TileMap tilemap(1, "limit", SIZE, SIZE, 1, 1);
 
-	auto p_tilemap = gap::tilemap::load(config.args[0], config.args[1], filesystem);
+	uint32_t stored = 0;
+	for(uint32_t y=0; y<SIZE; ++y)
+		for(uint32_t x=0; x<SIZE; ++x)
+			stored += tilemap.set(x, y, 1) ? 1 : 0;
 
+	count += 3;
+	check(stored == gap::tilemap::INDEX_EMPTY, std::format("block limit: set() stored {} tiles", stored), failures);
+	check(tilemap.active_block_count() == gap::tilemap::INDEX_EMPTY, std::format("block limit: {} blocks allocated", tilemap.active_block_count()), failures);
+	check(tilemap.set(0, 0, 2) && (tilemap.get(0, 0) == 2), "block limit: a tile in an allocated block could not be set", failures);
 
-	return 0;
+	// ----- assign_rect() -----
+	const std::vector<uint64_t> tiles(SIZE * SIZE, 1);
+
+	gap::tilemap::TileMap full(1, "limit", SIZE, SIZE, 1, 1);
+	gap::tilemap::TileMap fits(1, "limit", SIZE, 200, 1, 1);
+
+	count += 3;
+	check(!full.assign_rect(tiles, SIZE, 0, 0, SIZE, SIZE), "block limit: assign_rect() did not fail", failures);
+	check(full.active_block_count() == gap::tilemap::MAX_BLOCKS, std::format("block limit: assign_rect() allocated {} blocks", full.active_block_count()), failures);
+	check(	fits.assign_rect(tiles, SIZE, 0, 0, SIZE, 200) && (fits.active_block_count() == (SIZE * 200)) && (fits.get(SIZE - 1, 199) == 1),
+					"block limit: a map within the limit failed", failures);
+
+	return failures;
 }
 
+int
+test_tilemap(const gap::Configuration & config, gap::FileSystem & filesystem)
+{
+	// Load and print a single map, given its path and type.
+	if(config.args.size() >= 2)
+	{
+		auto p_tilemap = gap::tilemap::load(config.args[0], config.args[1], filesystem);
+		return p_tilemap == nullptr ? -1 : 0;
+	}
+
+	const std::string directory = config.args.empty() ? std::string("data/testfiles/tmx") : config.args.front();
+
+	int count			= 0;
+	int failures	= test_base64(count);
+	failures += test_csv(filesystem, count);
+	failures += test_streaming(filesystem, count);
+	failures += test_encodings(directory, filesystem, count);
+	failures += test_infinite(directory, filesystem, count);
+	failures += test_layers(count);
+	failures += test_assign_rect(count);
+	failures += test_block_sizes(count);
+	failures += test_layout(count);
+	failures += test_flags(directory, filesystem, count);
+	failures += test_block_limit(count);
+
+	return report_checks("tilemap", count, failures);
+}
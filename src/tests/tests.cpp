@@ -10,11 +10,21 @@
 //=============================================================================
 #include "tests.h"
 #include "test_tilemap.h"
+#include "test_image.h"
+#include "test_atlas.h"
+#include "test_palette.h"
+#include "test_assets.h"
+#include "test_sound.h"
 
 int	
 run_test(const gap::Configuration & config, gap::FileSystem & filesystem)
 {
 	if(config.test_mode == "tilemap")		return test_tilemap(config, filesystem);
+	if(config.test_mode == "image")			return test_image(config, filesystem);
+	if(config.test_mode == "atlas")			return test_atlas(config, filesystem);
+	if(config.test_mode == "palette")		return test_palette(config, filesystem);
+	if(config.test_mode == "assets")		return test_assets(config, filesystem);
+	if(config.test_mode == "sound")			return test_sound(config, filesystem);
 	else return -1;
 	return 0;
 }
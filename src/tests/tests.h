@@ -11,11 +11,38 @@
 #ifndef GUARD_ADE_GAMES_ASSET_PACKER_TESTS_H
 #define GUARD_ADE_GAMES_ASSET_PACKER_TESTS_H
 
+#include <print>
+#include <string_view>
 #include "configuration.h"
 #include "filesystem.h"
 #include "assets.h"
 
 int	run_test(const gap::Configuration & config, gap::FileSystem & filesystem);
 
+//-----------------------------------------------------------------------------
+//	Shared by the test suites. check() prints a failed check and counts it.
+//	report_checks() prints the summary line of a suite and returns its exit
+//	code.
+//-----------------------------------------------------------------------------
+inline
+bool
+check(bool b_pass, std::string_view message, int & failures)
+{
+	if(!b_pass)
+	{
+		std::println("FAIL: {}", message);
+		++failures;
+	}
+	return b_pass;
+}
+
+inline
+int
+report_checks(std::string_view suite, int count, int failures)
+{
+	std::println("{}: {} of {} checks passed", suite, count - failures, count);
+	return failures == 0 ? 0 : 1;
+}
+
 
 #endif // ! defined GUARD_ADE_GAMES_ASSET_PACKER_TESTS_H
\ No newline at end of file
@@ -8,10 +8,14 @@
 //	MAINTAINER:		Adrian Purser <ade@adrianpurser.co.uk>
 //	CREATED:			12-AUG-2025 Adrian Purser <ade@adrianpurser.co.uk>
 //=============================================================================
+#include <algorithm>
 #include <format>
-#include <print>
+#include <iterator>
+#include <numeric>
 #include <string>
 #include "tilemap.h"
+#include "dedupe.h"
+#include "logger.h"
 #include "utility/ansi.h"
 
 namespace gap::tilemap
@@ -25,12 +29,125 @@ TileMap::allocate_block()
 	return index;
 }
 
-void
-TileMap::set(uint32_t x, uint32_t y, uint64_t value)
+//-----------------------------------------------------------------------------
+//	The key of x,y along a Z-order (Morton) curve.
+//-----------------------------------------------------------------------------
+static
+uint64_t
+morton_key(uint32_t x, uint32_t y)
+{
+	uint64_t key = 0;
+	for(uint32_t bit=0; bit<32; ++bit)
+		key |= (uint64_t((x >> bit) & 1) << (bit * 2)) | (uint64_t((y >> bit) & 1) << ((bit * 2) + 1));
+	return key;
+}
+
+//-----------------------------------------------------------------------------
+//	The distance of x,y along a Hilbert curve that fills a side x side square,
+//	where side is a power of 2.
+//-----------------------------------------------------------------------------
+static
+uint64_t
+hilbert_key(uint32_t side, uint32_t x, uint32_t y)
+{
+	uint64_t key = 0;
+	for(uint32_t s=side/2; s>0; s/=2)
+	{
+		const uint32_t rx = (x & s) ? 1 : 0;
+		const uint32_t ry = (y & s) ? 1 : 0;
+		key += uint64_t(s) * s * ((3 * rx) ^ ry);
+
+		// ----- Rotate the quadrant so that the curve inside it starts at 0,0. -----
+		if(ry == 0)
+		{
+			if(rx == 1)
+			{
+				x = side - 1 - x;
+				y = side - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return key;
+}
+
+//-----------------------------------------------------------------------------
+//	Curves are followed over the smallest power of 2 square that covers the
+//	grid, skipping the positions outside of the grid, so any size of grid may
+//	be used.
+//-----------------------------------------------------------------------------
+std::vector<uint32_t>
+layout_order(Layout layout, uint32_t width, uint32_t height)
+{
+	std::vector<uint32_t> order(std::size_t(width) * height);
+	std::iota(begin(order), end(order), 0U);
+
+	if((layout == LAYOUT_ROW_MAJOR) || order.empty())
+		return order;
+
+	const uint32_t side = std::bit_ceil(std::max(width, height));
+
+	std::vector<uint64_t> keys(order.size());
+	for(uint32_t y=0; y<height; ++y)
+		for(uint32_t x=0; x<width; ++x)
+			keys[(std::size_t(y) * width) + x] = layout == LAYOUT_HILBERT ? hilbert_key(side, x, y) : morton_key(x, y);
+
+	std::sort(begin(order), end(order), [&](uint32_t a, uint32_t b) {return keys[a] < keys[b];});
+	return order;
+}
+
+//-----------------------------------------------------------------------------
+//	Remove the blocks that are identical to another block and renumber the
+//	blocks in the order that the indices, visited in 'order', first refer to
+//	them, so that blocks that are near each other in the map are stored near
+//	each other. Returns the number of blocks that were removed.
+//-----------------------------------------------------------------------------
+uint32_t
+TilemapBlocks::deduplicate(std::span<uint16_t> indices, std::span<const uint32_t> order)
+{
+	const std::size_t	volume = std::size_t(m_blocksize) * m_blocksize;
+	const auto				block_bytes = [](std::span<const uint64_t> block) {return std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(block.data()), block.size_bytes());};
+
+	std::vector<uint64_t>	data;
+	std::vector<uint16_t>	remap(m_active_block_count, INDEX_EMPTY);
+	gap::DataDedupe				dedupe;
+	data.reserve(m_data.size());
+
+	for(auto position : order)
+	{
+		auto & index = indices[position];
+		if(index >= m_active_block_count)
+			continue;
+
+		if(remap[index] == INDEX_EMPTY)
+		{
+			const auto block = std::span<const uint64_t>(m_data).subspan(index * volume, volume);
+
+			if(auto offset = dedupe.find(block_bytes(data), block_bytes(block)))
+				remap[index] = uint16_t(*offset / block.size_bytes());
+			else
+			{
+				remap[index] = uint16_t(data.size() / volume);
+				dedupe.add(block_bytes(block), uint32_t(data.size() * sizeof(uint64_t)));
+				data.insert(end(data), begin(block), end(block));
+			}
+		}
+		index = remap[index];
+	}
+
+	const auto removed = m_active_block_count - uint32_t(data.size() / volume);
+	m_active_block_count	= uint32_t(data.size() / volume);
+	m_data								= std::move(data);
+	return removed;
+}
+
+bool
+TileMap::set(uint32_t x, uint32_t y, uint64_t value, uint32_t layer)
 {
 	assert(x<m_width);
 	assert(y<m_height);
-	const std::size_t iblk = ((y/m_blocksize)*m_blocks_wide)+(x/m_blocksize);
+	assert(layer<m_layers);
+	const std::size_t iblk = index_position(x, y, layer);
 	assert(iblk < m_indices.size());
 	auto index = m_indices[iblk];
 
@@ -43,22 +160,80 @@ TileMap::set(uint32_t x, uint32_t y, uint64_t value)
 		case INDEX_EMPTY :
 			index = allocate_block();
 			if(index == INDEX_EMPTY)
-				break;
+				return false;
 			m_indices[iblk] = index;
 			[[fallthrough]];
 
 		default :
-			m_tilemap_blocks.set(index,x,y,value);
+			m_tilemap_blocks.set(index,x-(block_of(x)*m_blocksize),y-(block_of(y)*m_blocksize),value);
 			break;
 	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+//	Copy a 'width' x 'height' rectangle of tiles, with rows 'stride' tiles
+//	apart, to x,y. The rectangle is copied a block at a time. A block that is
+//	empty is only allocated if a tile copied to it is not zero. Copying stops
+//	at the first block that cannot be allocated.
+//-----------------------------------------------------------------------------
+bool
+TileMap::assign_rect(std::span<const uint64_t> tiles, std::size_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t layer)
+{
+	assert(x+width<=m_width);
+	assert(y+height<=m_height);
+	assert(layer<m_layers);
+	assert((height == 0) || (tiles.size() >= ((height-1)*stride)+width));
+
+	if((width == 0) || (height == 0))
+		return true;
+
+	for(uint32_t by=block_of(y); by<=block_of(y+height-1); ++by)
+	{
+		const uint32_t top			= std::max(y, by*m_blocksize);
+		const uint32_t bottom		= std::min(y+height, (by+1)*m_blocksize);
+
+		for(uint32_t bx=block_of(x); bx<=block_of(x+width-1); ++bx)
+		{
+			const uint32_t left		= std::max(x, bx*m_blocksize);
+			const uint32_t right	= std::min(x+width, (bx+1)*m_blocksize);
+			const uint64_t * p_src = tiles.data() + ((top-y)*stride) + (left-x);
+
+			auto & index = m_indices[(((std::size_t(by)*m_blocks_wide)+bx)*m_layers)+layer];
+
+			if(index == INDEX_UNLOADED)
+				continue; //TODO(Ade): Add mechanism to re-load block.
+
+			if(index == INDEX_EMPTY)
+			{
+				bool b_zero = true;
+				for(uint32_t ty=top; b_zero && (ty<bottom); ++ty)
+					b_zero = std::all_of(p_src + ((ty-top)*stride), p_src + ((ty-top)*stride) + (right-left), [](uint64_t tile) {return tile == 0;});
+				if(b_zero)
+					continue;
+
+				index = allocate_block();
+				if(index == INDEX_EMPTY)
+					return false;
+			}
+
+			auto p_dst = m_tilemap_blocks.block(index).data() + ((top-(by*m_blocksize))*m_blocksize) + (left-(bx*m_blocksize));
+			for(uint32_t ty=top; ty<bottom; ++ty, p_src+=stride, p_dst+=m_blocksize)
+				std::copy_n(p_src, right-left, p_dst);
+		}
+	}
+
+	return true;
 }
 
 uint64_t
-TileMap::get(uint32_t x, uint32_t y)
+TileMap::get(uint32_t x, uint32_t y, uint32_t layer)
 {
 	assert(x<m_width);
 	assert(y<m_height);
-	const std::size_t iblk = ((y/m_blocksize)*m_blocks_wide)+(x/m_blocksize);
+	assert(layer<m_layers);
+	const std::size_t iblk = index_position(x, y, layer);
 	assert(iblk < m_indices.size());
 	auto index = m_indices[iblk];
 	switch(index)
@@ -71,73 +246,110 @@ TileMap::get(uint32_t x, uint32_t y)
 		case INDEX_EMPTY :
 			return 0U;
 	}
-	return m_tilemap_blocks.get(index,x,y);
+	return m_tilemap_blocks.get(index,x-(block_of(x)*m_blocksize),y-(block_of(y)*m_blocksize));
+}
+
+// Blocks that are shared are only stored once, whichever layers use them.
+// The blocks are numbered in layout order, with the layers of each block
+// together.
+uint32_t
+TileMap::deduplicate_blocks()
+{
+	std::vector<uint32_t> order;
+	order.reserve(m_indices.size());
+	for(auto position : layout_order(m_layout, m_blocks_wide, m_blocks_high))
+		for(uint32_t layer=0; layer<m_layers; ++layer)
+			order.push_back((position * m_layers) + layer);
+
+	return m_tilemap_blocks.deduplicate(m_indices, order);
+}
+
+//-----------------------------------------------------------------------------
+//	Summarise the tile flags of each block so that a block can be skipped
+//	without looking at its tiles. Tiles outside of the map, in the blocks at
+//	the right and bottom edges, are tile 0.
+//-----------------------------------------------------------------------------
+std::vector<BlockFlags>
+TileMap::block_flags() const
+{
+	const auto				data		= block_data();
+	const std::size_t	volume	= std::size_t(m_blocksize) * m_blocksize;
+
+	std::vector<BlockFlags> blocks(active_block_count(), BlockFlags{~0U, 0U});
+	for(std::size_t i=0; i<data.size(); ++i)
+	{
+		const uint32_t flags = data[i] < m_tile_flags.size() ? m_tile_flags[data[i]] : 0U;
+		blocks[i / volume].all &= flags;
+		blocks[i / volume].any |= flags;
+	}
+
+	return blocks;
 }
 
 void
 TileMap::print() const
 {
-	for(int by=0;by<m_blocks_high;++by)
+	if(!gap::logger::enabled(gap::logger::TRACE))
+		return;
+
+	// The dump is built up in a string and written in one go. Writing it a
+	// character at a time was slower than encoding the whole map.
+	std::string out;
+	out.reserve(std::size_t(m_layers) * m_blocks_high * (m_blocksize + 3) * ((m_blocks_wide * ((m_blocksize * 6) + 32)) + 1));
+
+	auto set_background = [&](int colour) {std::format_to(std::back_inserter(out), "\033[{}m", colour);};
+
+	for(uint32_t layer=0;layer<m_layers;++layer)
+	for(uint32_t by=0;by<m_blocks_high;++by)
 	{
 		for(int row = -2;row <= (int)m_blocksize;++row)
 		{
-			for(int bx=0; bx<m_blocks_wide;++bx)
+			for(uint32_t bx=0; bx<m_blocks_wide;++bx)
 			{
-				const std::size_t iblk = (by*m_blocks_wide)+bx;
+				const std::size_t iblk = (((by*m_blocks_wide)+bx)*m_layers)+layer;
 				assert(iblk < m_indices.size());
 				auto index = m_indices[iblk];
 
 				if(row == -2)
 				{
 					auto istr = std::format("{:04X}",index);
-					std::print(FOREGROUND_YELLOW"{:{}} ",istr,m_blocksize+3);
-					ansi::stdio::reset_colour();
+					std::format_to(std::back_inserter(out), FOREGROUND_YELLOW "{:{}} " RESET_COLOUR, istr, m_blocksize+3);
 				}
-				else if((row == -1) || (row==m_blocksize))
+				else if((row == -1) || (row==(int)m_blocksize))
 				{
-					printf(FOREGROUND_LIGHT_BLUE "+");
-					for(int i=0;i<m_blocksize;++i)
-						putchar('-');
-					printf("+ ");
-					ansi::stdio::reset_colour();
+					out += FOREGROUND_LIGHT_BLUE "+";
+					out.append(m_blocksize, '-');
+					out += "+ " RESET_COLOUR;
 				}
 				else
 				{
-					printf(FOREGROUND_LIGHT_BLUE "|" FOREGROUND_WHITE);
+					out += FOREGROUND_LIGHT_BLUE "|" FOREGROUND_WHITE;
 
 					switch(index)
 					{
-						case INDEX_UNLOADED :
-							for(int i=0;i<m_blocksize;++i)
-								putchar('/');
-							break;
-
-						case INDEX_EMPTY :
-							for(int i=0;i<m_blocksize;++i)
-								putchar('.');
-							break;
+						case INDEX_UNLOADED :		out.append(m_blocksize, '/'); break;
+						case INDEX_EMPTY :			out.append(m_blocksize, '.'); break;
 
 						default :
-							for(int i=0;i<m_blocksize;++i)
+							for(uint32_t i=0;i<m_blocksize;++i)
 							{
 								auto tile = m_tilemap_blocks.get(index,i,row);
 								char ch = tile > 9 ? '#' : '0' + (char)(tile&0x7F);
-								ansi::stdio::background_colour(ansi::sgr::FG_BLACK + std::min<int>(tile,9));
-								putchar(tile == 0 ? '.' : ch);
+								set_background(ansi::sgr::BG_BLACK + std::min<int>(tile,9));
+								out.push_back(tile == 0 ? '.' : ch);
 							}
 							break;
 					}
-					ansi::stdio::reset_colour();
-					printf(FOREGROUND_LIGHT_BLUE "| ");
-					ansi::stdio::reset_colour();
+					out += RESET_COLOUR FOREGROUND_LIGHT_BLUE "| " RESET_COLOUR;
 				}
 			}
-			printf("\n");
+			out.push_back('\n');
 		}
-		printf("\n");
+		out.push_back('\n');
 	}
-}
 
+	gap::logger::write(gap::logger::TRACE, out);
+}
 
 } // namespace gap::tilemap
 
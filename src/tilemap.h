@@ -14,6 +14,7 @@
 #include <cstdint>
 #include <cassert>
 #include <array>
+#include <bit>
 #include <vector>
 #include <span>
 #include <string>
@@ -24,6 +25,25 @@ namespace gap::tilemap
 {
 static constexpr uint16_t		INDEX_EMPTY 		= 0xFFFE;		// Block is empty. Setting a tile will allocate a new block.
 static constexpr uint16_t		INDEX_UNLOADED 	= 0xFFFF;		// This block has been unloaded and will require loading to become active.
+static constexpr uint32_t		MAX_BLOCKS			= INDEX_EMPTY;	// Blocks are numbered from 0 to 0xFFFD.
+
+// The order in which the blocks of a tilemap, and the tiles of a block, are stored.
+enum Layout : uint8_t
+{
+	LAYOUT_ROW_MAJOR	= 0,
+	LAYOUT_MORTON			= 1,		// Z-order
+	LAYOUT_HILBERT		= 2
+};
+
+// The positions (y * width + x) of a width x height grid in 'layout' order.
+std::vector<uint32_t>		layout_order(Layout layout, uint32_t width, uint32_t height);
+
+// The flags that are set in every tile of a block and in any tile of it.
+struct BlockFlags
+{
+	uint32_t		all		= 0;
+	uint32_t		any		= 0;
+};
 
 class TilemapBlocks
 {
@@ -39,9 +59,9 @@ public:
 		: m_blocksize(blocksize)
 		, m_blockcount(blockcount)
 		{
-			m_data.resize(blockcount * blocksize * blocksize);
 		}
 
+	// x and y are the position of the tile within the block.
 	uint64_t			get(uint32_t block, uint32_t x, uint32_t y) const
 								{
 									auto index = calc_index(block,x,y);
@@ -55,16 +75,29 @@ public:
 										m_data[index] = value;
 								}
 
-	uint16_t										allocate()									{return m_active_block_count++;}
+	// Storage grows as blocks are allocated so that a sparse map only uses
+	// memory for the blocks that have tiles. INDEX_EMPTY if there are none left.
+	uint16_t										allocate()
+															{
+																if((m_active_block_count >= m_blockcount) || (m_active_block_count >= INDEX_EMPTY))
+																	return INDEX_EMPTY;
+																m_data.resize(std::size_t(m_active_block_count + 1) * m_blocksize * m_blocksize);
+																return m_active_block_count++;
+															}
 	uint32_t										active_block_count() const	{return m_active_block_count;}
+	std::span<uint64_t>					block(uint16_t block)				{return std::span<uint64_t>(m_data.data() + (std::size_t(block) * m_blocksize * m_blocksize), std::size_t(m_blocksize) * m_blocksize);}
 	std::span<const uint64_t>		block_data() const					{return std::span<const uint64_t>(m_data.data(), m_active_block_count * m_blocksize * m_blocksize);}
 
+	uint32_t										deduplicate(std::span<uint16_t> indices, std::span<const uint32_t> order);
+
 private:
 	std::size_t 	calc_index(uint32_t block, uint32_t x, uint32_t y) const
 								{
-									return 	(block * m_blocksize * m_blocksize) +
-													((y&(m_blocksize-1))*m_blocksize) +
-													(x&(m_blocksize-1));
+									assert(x<m_blocksize);
+									assert(y<m_blocksize);
+									return 	(std::size_t(block) * m_blocksize * m_blocksize) +
+													(y*m_blocksize) +
+													x;
 								}
 };
 
@@ -81,12 +114,17 @@ private:
 	uint32_t 												m_tilesize			= 0;
 	uint32_t												m_blocks_wide		= 0;
 	uint32_t												m_blocks_high		= 0;
+	uint32_t												m_layers				= 1;
+	int															m_block_shift		= -1;				// log2(m_blocksize) if it is a power of 2, otherwise -1.
+	Layout													m_layout				= LAYOUT_ROW_MAJOR;
+	std::vector<std::string>				m_flag_names;										// Name of each bit of the tile flags.
+	std::vector<uint32_t>						m_tile_flags;										// Flags of each tile value.
 
 public:
 	TileMap() = delete;
-	TileMap(uint32_t id, std::string_view name, uint32_t width, uint32_t height, uint32_t blocksize, uint32_t tilesize)
+	TileMap(uint32_t id, std::string_view name, uint32_t width, uint32_t height, uint32_t blocksize, uint32_t tilesize, uint32_t layers = 1)
 		: m_name(name)
-		, m_tilemap_blocks(blocksize, width*height)
+		, m_tilemap_blocks(blocksize, ((width+(blocksize-1))/blocksize) * ((height+(blocksize-1))/blocksize) * layers)
 		, m_id(id)
 		, m_width(width)
 		, m_height(height)
@@ -94,8 +132,11 @@ public:
 		, m_tilesize(tilesize)
 		, m_blocks_wide((width+(blocksize-1))/blocksize)
 		, m_blocks_high((height+(blocksize-1))/blocksize)
+		, m_layers(layers)
+		, m_block_shift(std::has_single_bit(blocksize) ? std::countr_zero(blocksize) : -1)
 		{
-			m_indices.resize(m_blocks_wide * m_blocks_high, INDEX_EMPTY);
+			// The indices of all of the layers of a block are stored together.
+			m_indices.resize(std::size_t(m_blocks_wide) * m_blocks_high * m_layers, INDEX_EMPTY);
 		}
 
 	~TileMap() = default;
@@ -111,15 +152,39 @@ public:
 	uint32_t 										blocks_high() const 				{return m_blocks_high;}
 	uint32_t										block_size() const					{return m_blocksize;}
 	uint32_t										tile_size() const						{return m_tilesize;}
+	uint32_t										layer_count() const					{return m_layers;}
+	Layout											layout() const							{return m_layout;}
+	void												set_layout(Layout layout)		{m_layout = layout;}
+	void												set_tile_flags(std::vector<std::string> names, std::vector<uint32_t> flags)	{m_flag_names = std::move(names); m_tile_flags = std::move(flags);}
+	std::span<const std::string>	flag_names() const				{return m_flag_names;}
+	std::span<const uint32_t>		tile_flags() const					{return m_tile_flags;}
+	uint32_t										flag_size() const						{return m_flag_names.size() <= 8 ? 1 : (m_flag_names.size() <= 16 ? 2 : 4);}
+	std::vector<BlockFlags>			block_flags() const;
 	const std::string &					name() const								{return m_name;}
 	std::size_t									active_block_count() const	{return m_tilemap_blocks.active_block_count();}
 	std::span<const uint64_t>		block_data() const					{return m_tilemap_blocks.block_data();}
 	std::span<const uint16_t>		indices() const							{return std::span<const uint16_t>(m_indices.data(), m_indices.size());}
 
 	uint16_t							allocate_block();
-	void									set(uint32_t x, uint32_t y, uint64_t value);
-	uint64_t							get(uint32_t x, uint32_t y);
+
+	// Both return false if a tile needed a new block and there were none left.
+	bool									set(uint32_t x, uint32_t y, uint64_t value, uint32_t layer = 0);
+	bool									assign_rect(std::span<const uint64_t> tiles, std::size_t stride, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t layer = 0);
+	uint64_t							get(uint32_t x, uint32_t y, uint32_t layer = 0);
+	uint32_t							deduplicate_blocks();
 	void									print() const;
+
+private:
+	// The block that contains tile 'v', shifting rather than dividing when
+	// the block size is a power of 2.
+	uint32_t							block_of(uint32_t v) const
+												{
+													return m_block_shift >= 0 ? (v >> m_block_shift) : (v / m_blocksize);
+												}
+	std::size_t						index_position(uint32_t x, uint32_t y, uint32_t layer) const
+												{
+													return (((std::size_t(block_of(y))*m_blocks_wide)+block_of(x)) * m_layers) + layer;
+												}
 };
 
 } // namespace gap::tilemap
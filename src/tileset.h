@@ -47,6 +47,9 @@ struct TileSet
 	int											tile_width 		= -1;
 	int 										tile_height 	= -1;
 	int											pixel_format 	= 0;
+	int											colour_map		= -1;			// Colour map for the indexed formats.
+	int											palette_size	= 256;		// Maximum colours of a generated colour map.
+	gap::image::EncodeOptions	encode;
 	std::vector<Tile>				tiles;
 };
 
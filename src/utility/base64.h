@@ -0,0 +1,215 @@
+//=============================================================================
+//	FILE:					base64.h
+//	SYSTEM:
+//	DESCRIPTION:	Base64 (RFC 4648) encoding and decoding
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C) Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:			MIT - See LICENSE file for details
+//	MAINTAINER:		Adrian Purser <ade@adrianpurser.co.uk>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade@adrianpurser.co.uk>
+//=============================================================================
+#ifndef GUARD_ADE_BASE64_H
+#define GUARD_ADE_BASE64_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace ade::base64
+{
+
+namespace detail
+{
+
+static constexpr uint8_t WHITESPACE	= 0xFE;
+static constexpr uint8_t INVALID		= 0xFF;
+
+constexpr std::array<uint8_t,256>
+make_decode_table()
+{
+	std::array<uint8_t,256> table{};
+	table.fill(INVALID);
+
+	constexpr std::string_view alphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+	for(std::size_t i=0; i<alphabet.size(); ++i)
+		table[static_cast<uint8_t>(alphabet[i])] = uint8_t(i);
+
+	for(char ch : {' ', '\t', '\r', '\n'})
+		table[static_cast<uint8_t>(ch)] = WHITESPACE;
+
+	return table;
+}
+
+inline constexpr auto DECODE_TABLE = make_decode_table();
+
+#if defined(__SSSE3__)
+//-----------------------------------------------------------------------------
+//	Decode blocks of 16 characters into 12 bytes until a block contains
+//	anything other than the 64 alphabet characters (whitespace, padding or an
+//	invalid character). Each block stores 16 bytes so 'out' must have room for
+//	4 more bytes than are decoded. Returns the number of characters consumed,
+//	always a multiple of 16.
+//
+//	The characters are classified and translated with nibble lookups, see
+//	W. Mula and D. Lemire, "Faster Base64 Encoding and Decoding Using AVX2
+//	Instructions".
+//-----------------------------------------------------------------------------
+inline
+std::size_t
+decode_blocks_ssse3(std::string_view text, uint8_t * p_out, std::size_t out_size)
+{
+	const __m128i lut_lo		= _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+	const __m128i lut_hi		= _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+	const __m128i lut_roll	= _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i nibble		= _mm_set1_epi8(0x0F);
+	const __m128i slash			= _mm_set1_epi8(0x2F);
+	const __m128i pack		 	= _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+	std::size_t consumed	= 0;
+	std::size_t written		= 0;
+
+	while(((consumed + 16) <= text.size()) && ((written + 16) <= out_size))
+	{
+		const __m128i input	= _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + consumed));
+		const __m128i hi		= _mm_and_si128(_mm_srli_epi32(input, 4), nibble);
+		const __m128i lo		= _mm_and_si128(input, nibble);
+
+		const __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo), _mm_shuffle_epi8(lut_hi, hi));
+		if(_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0)
+			break;
+
+		const __m128i roll		= _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(input, slash), hi));
+		const __m128i values	= _mm_add_epi8(input, roll);
+
+		// ----- Pack the 6 bit values into 3 bytes for every 4 characters. -----
+		const __m128i pairs		= _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		const __m128i words		= _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p_out + written), _mm_shuffle_epi8(words, pack));
+
+		consumed	+= 16;
+		written		+= 12;
+	}
+
+	return consumed;
+}
+#endif // defined(__SSSE3__)
+
+} // namespace detail
+
+// Encode 'data' with '=' padding and no line breaks.
+inline
+std::string
+encode(std::span<const uint8_t> data)
+{
+	constexpr std::string_view alphabet("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+
+	std::string text;
+	text.reserve(((data.size() + 2) / 3) * 4);
+
+	for(std::size_t i=0; i<data.size(); i+=3)
+	{
+		const std::size_t	remaining = data.size() - i;
+		const uint32_t		bits = (uint32_t(data[i]) << 16) | (remaining > 1 ? uint32_t(data[i+1]) << 8 : 0) | (remaining > 2 ? data[i+2] : 0);
+
+		text.push_back(alphabet[(bits >> 18) & 0x3F]);
+		text.push_back(alphabet[(bits >> 12) & 0x3F]);
+		text.push_back(remaining > 1 ? alphabet[(bits >> 6) & 0x3F] : '=');
+		text.push_back(remaining > 2 ? alphabet[bits & 0x3F] : '=');
+	}
+
+	return text;
+}
+
+// The most bytes that 'text' can decode to.
+constexpr
+std::size_t
+decoded_size_limit(std::string_view text) noexcept
+{
+	return ((text.size() + 3) / 4) * 3;
+}
+
+//-----------------------------------------------------------------------------
+//	Decode 'text' into 'out'. Whitespace is ignored anywhere in the text and
+//	the '=' padding at the end is optional. Returns the number of bytes
+//	decoded, or nothing if the text is not valid base64 or 'out' is too small.
+//-----------------------------------------------------------------------------
+inline
+std::optional<std::size_t>
+decode(std::string_view text, std::span<uint8_t> out)
+{
+	std::size_t written = 0;
+
+#if defined(__SSSE3__)
+	// The fast path stops at the first block with whitespace in it, so skip
+	// the line break and indentation that usually lead the text.
+	while(!text.empty() && (detail::DECODE_TABLE[static_cast<uint8_t>(text.front())] == detail::WHITESPACE))
+		text.remove_prefix(1);
+
+	const auto consumed = detail::decode_blocks_ssse3(text, out.data(), out.size());
+	text.remove_prefix(consumed);
+	written = (consumed / 4) * 3;
+#endif
+
+	uint32_t		bits		= 0;
+	int					count		= 0;
+	std::size_t	padding	= 0;
+
+	for(char ch : text)
+	{
+		const uint8_t value = detail::DECODE_TABLE[static_cast<uint8_t>(ch)];
+
+		if(value == detail::WHITESPACE)
+			continue;
+
+		if(ch == '=')
+		{
+			++padding;
+			continue;
+		}
+
+		if((value == detail::INVALID) || (padding > 0))
+			return std::nullopt;
+
+		bits = (bits << 6) | value;
+		if(++count == 4)
+		{
+			if((written + 3) > out.size())
+				return std::nullopt;
+
+			out[written++] = uint8_t(bits >> 16);
+			out[written++] = uint8_t(bits >> 8);
+			out[written++] = uint8_t(bits);
+			bits	= 0;
+			count	= 0;
+		}
+	}
+
+	// ----- A final group of 2 or 3 characters holds 1 or 2 bytes. -----
+	if((count == 1) || (padding > 2) || ((padding > 0) && ((count + padding) != 4)))
+		return std::nullopt;
+
+	if(count > 1)
+	{
+		if((written + count - 1) > out.size())
+			return std::nullopt;
+
+		bits <<= 6 * (4 - count);
+		out[written++] = uint8_t(bits >> 16);
+		if(count == 3)
+			out[written++] = uint8_t(bits >> 8);
+	}
+
+	return written;
+}
+
+} // namespace ade::base64
+
+#endif // ! defined GUARD_ADE_BASE64_H
@@ -103,6 +103,16 @@ fourcc(const char * str,size_t size)
 	return value;
 }
 
+// FNV-1a (64 bit) of a block of binary data.
+template<std::uint64_t basis=14695981039346656037ULL,std::uint64_t prime=1099511628211ULL>
+constexpr std::uint64_t
+hash_bytes(const std::uint8_t * p_data,size_t size)
+{
+	std::uint64_t hash = basis;
+	while(size--)
+		hash = (hash ^ *p_data++) * prime;
+	return hash;
+}
 
 } // namespace ade::hash
 
@@ -0,0 +1,102 @@
+//=============================================================================
+//	FILE:					line_scanner.h
+//	SYSTEM:
+//	DESCRIPTION:	Split text into lines and whitespace separated fields
+//								without copying it.
+//-----------------------------------------------------------------------------
+//  COPYRIGHT:		(C) Copyright 2026 Adrian Purser. All Rights Reserved.
+//	LICENCE:			MIT - See LICENSE file for details
+//	MAINTAINER:		Adrian Purser <ade@adrianpurser.co.uk>
+//	CREATED:			19-OCT-2026 Adrian Purser <ade@adrianpurser.co.uk>
+//=============================================================================
+#ifndef GUARD_ADE_LINE_SCANNER_H
+#define GUARD_ADE_LINE_SCANNER_H
+
+#include <charconv>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+namespace ade
+{
+
+//-----------------------------------------------------------------------------
+//	Lines end with LF, CR LF or CR. The lines are views of the text so the
+//	text must outlive them. A UTF-8 byte order mark at the start is skipped.
+//-----------------------------------------------------------------------------
+class LineScanner
+{
+private:
+	std::string_view		m_text;
+	std::size_t					m_line_number = 0;
+
+public:
+	explicit LineScanner(std::string_view text) : m_text(text)
+	{
+		if(m_text.starts_with("\xEF\xBB\xBF"))
+			m_text.remove_prefix(3);
+	}
+
+	explicit LineScanner(std::span<const std::uint8_t> data)
+		: LineScanner(std::string_view(reinterpret_cast<const char *>(data.data()), data.size())) {}
+
+	bool								next(std::string_view & line)
+											{
+												if(m_text.empty())
+													return false;
+
+												const auto end = m_text.find_first_of("\r\n");
+												line = m_text.substr(0, end);
+												m_text.remove_prefix(end == std::string_view::npos ? m_text.size() : end + 1);
+												if((end != std::string_view::npos) && (line.data()[end] == '\r') && m_text.starts_with('\n'))
+													m_text.remove_prefix(1);
+
+												++m_line_number;
+												return true;
+											}
+
+	// Number of the line most recently returned by next(), starting at 1.
+	std::size_t					line_number() const noexcept		{return m_line_number;}
+};
+
+inline
+std::string_view
+trim(std::string_view text)
+{
+	const auto first = text.find_first_not_of(" \t");
+	if(first == std::string_view::npos)
+		return {};
+	return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// Remove and return the first whitespace separated field of 'text'.
+inline
+std::string_view
+next_field(std::string_view & text)
+{
+	text = trim(text);
+	const auto end		= text.find_first_of(" \t");
+	const auto field	= text.substr(0, end);
+	text.remove_prefix(field.size());
+	return field;
+}
+
+// Parse the whole of 'text' as a number. 'value' is unchanged on failure.
+template<typename T>
+inline
+bool
+parse_number(std::string_view text, T & value, int base = 10)
+{
+	T result{};
+	const auto [p_end, error] = std::from_chars(text.data(), text.data() + text.size(), result, base);
+	if((error != std::errc()) || (p_end != (text.data() + text.size())) || text.empty())
+		return false;
+	value = result;
+	return true;
+}
+
+} // namespace ade
+
+
+#endif // ! defined GUARD_ADE_LINE_SCANNER_H
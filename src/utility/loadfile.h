@@ -14,6 +14,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -44,6 +45,35 @@ loadfile(const std::string_view filename)
 	return data;
 }
 
+//-----------------------------------------------------------------------------
+//	Read a binary file in pieces of up to 'chunk_size' bytes and pass each one
+//	to 'callback', so that the whole file never has to be in memory. Reading
+//	stops if the callback returns false. Returns false if the file could not
+//	be opened or read, or the callback stopped it.
+//-----------------------------------------------------------------------------
+template<typename F>
+inline
+bool
+readfile(const std::string_view filename, std::size_t chunk_size, F && callback)
+{
+	std::ifstream file(std::string(filename), std::ios_base::in | std::ios_base::binary);
+	if(file.fail() || (chunk_size == 0))
+		return false;
+
+	std::vector<std::uint8_t> buffer(chunk_size);
+	for(;;)
+	{
+		file.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+		const auto size = static_cast<std::size_t>(file.gcount());
+		if((size > 0) && !callback(std::span<std::uint8_t>(buffer.data(), size)))
+			return false;
+		if(file.eof())
+			return true;
+		if(file.fail())
+			return false;
+	}
+}
+
 } // namespace ade
 
 #endif // ! defined GUARD_ADE_LOADFILE_H